@@ -413,11 +413,11 @@ void __asan_unpoison(void *p, long n) {
 
 static bool __asan_is_mapped(int x) {
   // xxx: we can't lock because no reentrant locks yet
-  int i;
   bool res;
+  struct MemoryInterval *e;
   __mmi_lock();
-  i = __find_memory(&_mmi, x);
-  res = i < _mmi.i && x >= _mmi.p[i].x;
+  e = __find_memory(&_mmi, x);
+  res = e && x >= e->x;
   __mmi_unlock();
   return res;
 }
@@ -855,7 +855,7 @@ static __wur __asan_die_f *__asan_report(const void *addr, int size,
   signed char t;
   uint64_t x, y, z;
   char *base, *q, *p = buf;
-  struct MemoryIntervals *m;
+  struct MemoryInterval *e;
   ftrace_enabled(-1);
   kprintf("\n\e[J\e[1;31masan error\e[0m: %s %d-byte %s at %p shadow %p\n",
           __asan_describe_access_poison(kind), size, message, addr,
@@ -920,9 +920,9 @@ static __wur __asan_die_f *__asan_report(const void *addr, int size,
   p = __asan_format_section(p, _etext, _edata, ".data", addr);
   p = __asan_format_section(p, _end, _edata, ".bss", addr);
   __mmi_lock();
-  for (m = &_mmi, i = 0; i < m->i; ++i) {
-    x = m->p[i].x;
-    y = m->p[i].y;
+  for (e = __first_memory(&_mmi); e; e = __next_memory(e)) {
+    x = e->x;
+    y = e->y;
     p = __asan_format_interval(p, x << 16, (y << 16) + (FRAMESIZE - 1));
     z = (intptr_t)addr >> 16;
     if (x <= z && z <= y)
@@ -1462,19 +1462,18 @@ void __asan_map_shadow(uintptr_t p, size_t n) {
   __asan_unpoison((char *)p, n);
 }
 
-static textstartup void __asan_shadow_mapping(struct MemoryIntervals *m,
-                                              size_t i) {
+static textstartup void __asan_shadow_mapping(struct MemoryInterval *e) {
   uintptr_t x, y;
-  if (i < m->i) {
-    x = m->p[i].x;
-    y = m->p[i].y;
-    __asan_shadow_mapping(m, i + 1);
+  if (e) {
+    x = e->x;
+    y = e->y;
+    __asan_shadow_mapping(__next_memory(e));
     __asan_map_shadow(x << 16, (y - x + 1) << 16);
   }
 }
 
 static textstartup void __asan_shadow_existing_mappings(void) {
-  __asan_shadow_mapping(&_mmi, 0);
+  __asan_shadow_mapping(__first_memory(&_mmi));
   if (!IsWindows()) {
     int guard;
     void *addr;
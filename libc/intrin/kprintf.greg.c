@@ -163,32 +163,33 @@ __funline bool kischarmisaligned(const char *p, signed char t) {
 }
 
 __funline bool kismemtrackhosed(void) {
+  struct MemoryInterval *e = _weaken(_mmi)->root;
   return !((_weaken(_mmi)->i <= _weaken(_mmi)->n) &&
-           (_weaken(_mmi)->p == _weaken(_mmi)->s ||
-            _weaken(_mmi)->p == (struct MemoryInterval *)kMemtrackStart));
+           (!e ||
+            (_weaken(_mmi)->s <= e &&
+             e < _weaken(_mmi)->s + ARRAYLEN(_weaken(_mmi)->s)) ||
+            ((struct MemoryInterval *)kMemtrackStart <= e &&
+             e < (struct MemoryInterval *)kMemtrackStart + _weaken(_mmi)->c)));
 }
 
 privileged static bool kismapped(int x) {
   // xxx: we can't lock because no reentrant locks yet
-  size_t m, r, l = 0;
+  int tries;
+  bool res;
+  unsigned seq;
+  struct MemoryInterval *e;
   if (!_weaken(_mmi))
     return true;
-  if (kismemtrackhosed())
-    return false;
-  r = _weaken(_mmi)->i;
-  while (l < r) {
-    m = (l & r) + ((l ^ r) >> 1);  // floor((a+b)/2)
-    if (_weaken(_mmi)->p[m].y < x) {
-      l = m + 1;
-    } else {
-      r = m;
-    }
-  }
-  if (l < _weaken(_mmi)->i && x >= _weaken(_mmi)->p[l].x) {
-    return !!(_weaken(_mmi)->p[l].prot & PROT_READ);
-  } else {
-    return false;
+  for (tries = 0; tries < 10; ++tries) {
+    seq = __memtrack_begin(_weaken(_mmi));
+    if (kismemtrackhosed())
+      return false;
+    e = __find_memory(_weaken(_mmi), x);
+    res = e && x >= e->x && (e->prot & PROT_READ);
+    if (!__memtrack_retry(_weaken(_mmi), seq))
+      return res;
   }
+  return false;  // we probably interrupted a writer
 }
 
 privileged bool32 kisdangerous(const void *p) {
@@ -23,6 +23,8 @@
 #ifndef __aarch64__
 
 typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef char zmm_t __attribute__((__vector_size__(64), __aligned__(1)));
 
 static inline const unsigned char *memchr_pure(const unsigned char *s,
                                                unsigned char c, size_t n) {
@@ -56,6 +58,42 @@ static __vex const unsigned char *memchr_sse(const unsigned char *s,
   }
   return 0;
 }
+
+_Microarchitecture("avx2") static const unsigned char *memchr_avx2(
+    const unsigned char *s, unsigned char c, size_t n) {
+  unsigned m;
+  ymm_t v, t = {c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+                c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  for (; n >= 64; n -= 64, s += 64) {
+    v = *(const ymm_t *)s;
+    if ((m = __builtin_ia32_pmovmskb256(v == t)))
+      return s + __builtin_ctz(m);
+    v = *(const ymm_t *)(s + 32);
+    if ((m = __builtin_ia32_pmovmskb256(v == t)))
+      return s + 32 + __builtin_ctz(m);
+  }
+  for (; n >= 32; n -= 32, s += 32) {
+    v = *(const ymm_t *)s;
+    if ((m = __builtin_ia32_pmovmskb256(v == t)))
+      return s + __builtin_ctz(m);
+  }
+  return memchr_sse(s, c, n);
+}
+
+_Microarchitecture("avx512bw") static const unsigned char *memchr_avx512(
+    const unsigned char *s, unsigned char c, size_t n) {
+  unsigned long m;
+  zmm_t v, t = {c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+                c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+                c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+                c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  for (; n >= 64; n -= 64, s += 64) {
+    v = *(const zmm_t *)s;
+    if ((m = __builtin_ia32_pcmpeqb512_mask(v, t, -1)))
+      return s + __builtin_ctzl(m);
+  }
+  return memchr_sse(s, c, n);
+}
 #endif
 
 /**
@@ -69,6 +107,10 @@ static __vex const unsigned char *memchr_sse(const unsigned char *s,
  */
 void *memchr(const void *s, int c, size_t n) {
 #if defined(__x86_64__) && !defined(__chibicc__)
+  if (n >= 256 && X86_HAVE(AVX512BW))
+    return (void *)memchr_avx512(s, c, n);
+  if (n >= 32 && X86_HAVE(AVX2))
+    return (void *)memchr_avx2(s, c, n);
   return (void *)memchr_sse(s, c, n);
 #else
   return (void *)memchr_pure(s, c, n);
@@ -23,6 +23,7 @@
 #ifndef __aarch64__
 
 typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
 
 static inline const unsigned char *memrchr_pure(const unsigned char *s,
                                                 unsigned char c, size_t n) {
@@ -56,6 +57,19 @@ static __vex const unsigned char *memrchr_sse(const unsigned char *s,
   }
   return 0;
 }
+
+_Microarchitecture("avx2") static const unsigned char *memrchr_avx2(
+    const unsigned char *s, unsigned char c, size_t n) {
+  unsigned m;
+  ymm_t v, t = {c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+                c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  for (; n >= 32; n -= 32) {
+    v = *(const ymm_t *)(s + n - 32);
+    if ((m = __builtin_ia32_pmovmskb256(v == t)))
+      return s + n - 32 + (__builtin_clz(m) ^ (sizeof(int) * CHAR_BIT - 1));
+  }
+  return memrchr_sse(s, c, n);
+}
 #endif
 
 /**
@@ -69,6 +83,8 @@ static __vex const unsigned char *memrchr_sse(const unsigned char *s,
  */
 void *memrchr(const void *s, int c, size_t n) {
 #if defined(__x86_64__) && !defined(__chibicc__)
+  if (n >= 32 && X86_HAVE(AVX2))
+    return (void *)memrchr_avx2(s, c, n);
   return (void *)memrchr_sse(s, c, n);
 #else
   return (void *)memrchr_pure(s, c, n);
@@ -21,6 +21,7 @@
 #include "libc/dce.h"
 #include "libc/errno.h"
 #include "libc/intrin/asan.internal.h"
+#include "libc/intrin/atomic.h"
 #include "libc/intrin/directmap.internal.h"
 #include "libc/intrin/strace.internal.h"
 #include "libc/log/libfatal.internal.h"
@@ -34,27 +35,18 @@
 #include "libc/sysv/consts/prot.h"
 #include "libc/sysv/errfuns.h"
 
-static void *__shove_memory(struct MemoryInterval *d,
-                            const struct MemoryInterval *s, int n) {
-  int i;
-  unassert(n >= 0);
-  if (d > s) {
-    for (i = n; i--;) {
-      d[i] = s[i];
-    }
-  } else {
-    for (i = 0; i < n; ++i) {
-      d[i] = s[i];
-    }
-  }
-  return d;
+#define HEIGHT(e) ((e) ? (e)->height : 0)
+
+// makes seq odd while the tree changes, see __memtrack_retry()
+static void __begin_memory_write(struct MemoryIntervals *mm) {
+  unsigned seq = atomic_load_explicit(&mm->seq, memory_order_relaxed);
+  atomic_store_explicit(&mm->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
 }
 
-static void __remove_memory(struct MemoryIntervals *mm, int i, int n) {
-  unassert(i >= 0);
-  unassert(i + n <= mm->i);
-  __shove_memory(mm->p + i, mm->p + i + n, mm->i - (i + n));
-  mm->i -= n;
+static void __end_memory_write(struct MemoryIntervals *mm) {
+  unsigned seq = atomic_load_explicit(&mm->seq, memory_order_relaxed);
+  atomic_store_explicit(&mm->seq, seq + 1, memory_order_release);
 }
 
 static bool __extend_memory(struct MemoryIntervals *mm) {
@@ -63,79 +55,214 @@ static bool __extend_memory(struct MemoryIntervals *mm) {
   size_t gran, size;
   struct DirectMap dm;
   gran = kMemtrackGran;
-  base = (char *)kMemtrackStart;
   prot = PROT_READ | PROT_WRITE;
   flags = MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED;
-  if (mm->p == mm->s) {
-    // TODO(jart): How can we detect ASAN mode under GREG?
-    if (1 || IsAsan()) {
-      shad = (char *)(((intptr_t)base >> 3) + 0x7fff8000);
-      dm = sys_mmap(shad, gran >> 3, prot, flags, -1, 0);
-      if (!dm.addr)
-        return false;
-    }
-    dm = sys_mmap(base, gran, prot, flags, -1, 0);
+  size = ROUNDUP(mm->c * sizeof(*mm->s), gran);
+  base = (char *)kMemtrackStart + size;
+  // TODO(jart): How can we detect ASAN mode under GREG?
+  if (!mm->c || IsAsan()) {
+    shad = (char *)(((intptr_t)base >> 3) + 0x7fff8000);
+    dm = sys_mmap(shad, gran >> 3, prot, flags, -1, 0);
     if (!dm.addr)
       return false;
-    __shove_memory(dm.addr, mm->p, mm->i);
-    mm->p = dm.addr;
-    mm->n = gran / sizeof(*mm->p);
+  }
+  dm = sys_mmap(base, gran, prot, flags, -1, 0);
+  if (!dm.addr)
+    return false;
+  mm->c = (size + gran) / sizeof(*mm->s);
+  return true;
+}
+
+// nodes are never unmapped, since lookups may be reading them
+static struct MemoryInterval *__alloc_memory(struct MemoryIntervals *mm) {
+  struct MemoryInterval *e;
+  if ((e = mm->free)) {
+    mm->free = e->right;
+  } else if (mm->n < ARRAYLEN(mm->s)) {
+    e = mm->s + mm->n++;
+  } else if (mm->n - ARRAYLEN(mm->s) < mm->c || __extend_memory(mm)) {
+    e = (struct MemoryInterval *)kMemtrackStart + (mm->n++ - ARRAYLEN(mm->s));
   } else {
-    size = ROUNDUP(mm->n * sizeof(*mm->p), gran);
-    base += size;
-    if (IsAsan()) {
-      shad = (char *)(((intptr_t)base >> 3) + 0x7fff8000);
-      dm = sys_mmap(shad, gran >> 3, prot, flags, -1, 0);
-      if (!dm.addr)
-        return false;
+    enomem();
+    return 0;
+  }
+  return e;
+}
+
+static void __free_memory(struct MemoryIntervals *mm, struct MemoryInterval *e) {
+  e->right = mm->free;
+  mm->free = e;
+}
+
+static void __fix_memory_height(struct MemoryInterval *e) {
+  e->height = MAX(HEIGHT(e->left), HEIGHT(e->right)) + 1;
+}
+
+// points the parent of `old` at `new` instead
+static void __swap_memory(struct MemoryIntervals *mm,
+                          struct MemoryInterval *parent,
+                          struct MemoryInterval *old,
+                          struct MemoryInterval *new) {
+  if (!parent) {
+    mm->root = new;
+  } else if (parent->left == old) {
+    parent->left = new;
+  } else {
+    parent->right = new;
+  }
+  if (new) {
+    new->parent = parent;
+  }
+}
+
+static struct MemoryInterval *__rotate_memory_left(
+    struct MemoryIntervals *mm, struct MemoryInterval *x) {
+  struct MemoryInterval *y = x->right;
+  x->right = y->left;
+  if (y->left)
+    y->left->parent = x;
+  __swap_memory(mm, x->parent, x, y);
+  y->left = x;
+  x->parent = y;
+  __fix_memory_height(x);
+  __fix_memory_height(y);
+  return y;
+}
+
+static struct MemoryInterval *__rotate_memory_right(
+    struct MemoryIntervals *mm, struct MemoryInterval *x) {
+  struct MemoryInterval *y = x->left;
+  x->left = y->right;
+  if (y->right)
+    y->right->parent = x;
+  __swap_memory(mm, x->parent, x, y);
+  y->right = x;
+  x->parent = y;
+  __fix_memory_height(x);
+  __fix_memory_height(y);
+  return y;
+}
+
+// restores the avl invariant on the path from `e` up to the root
+static void __balance_memory(struct MemoryIntervals *mm,
+                             struct MemoryInterval *e) {
+  int b;
+  for (; e; e = e->parent) {
+    __fix_memory_height(e);
+    b = HEIGHT(e->left) - HEIGHT(e->right);
+    if (b > 1) {
+      if (HEIGHT(e->left->left) < HEIGHT(e->left->right))
+        __rotate_memory_left(mm, e->left);
+      e = __rotate_memory_right(mm, e);
+    } else if (b < -1) {
+      if (HEIGHT(e->right->right) < HEIGHT(e->right->left))
+        __rotate_memory_right(mm, e->right);
+      e = __rotate_memory_left(mm, e);
     }
-    dm = sys_mmap(base, gran, prot, flags, -1, 0);
-    if (!dm.addr)
-      return false;
-    mm->n = (size + gran) / sizeof(*mm->p);
   }
-  return true;
 }
 
-static int __mint_memory(struct MemoryIntervals *mm, int i) {
-  unassert(i >= 0);
-  unassert(i <= mm->i);
-  unassert(mm->n >= 0);
-  if (mm->i == mm->n && !__extend_memory(mm))
-    return enomem();
-  __shove_memory(mm->p + i + 1, mm->p + i, mm->i++ - i);
-  return 0;
+static void __insert_memory(struct MemoryIntervals *mm,
+                            struct MemoryInterval *e) {
+  struct MemoryInterval *p, **q;
+  for (p = 0, q = &mm->root; *q;) {
+    p = *q;
+    q = e->x < p->x ? &p->left : &p->right;
+  }
+  e->parent = p;
+  e->left = 0;
+  e->right = 0;
+  e->height = 1;
+  *q = e;
+  ++mm->i;
+  __balance_memory(mm, p);
 }
 
-static int __punch_memory(struct MemoryIntervals *mm, int x, int y, int i) {
-  if (__mint_memory(mm, i) == -1)
-    return -1;
-  mm->p[i + 0].size -= (size_t)(mm->p[i + 0].y - (x - 1)) * FRAMESIZE;
-  mm->p[i + 0].y = x - 1;
-  mm->p[i + 1].size -= (size_t)((y + 1) - mm->p[i + 1].x) * FRAMESIZE;
-  mm->p[i + 1].x = y + 1;
-  return 0;
+// relinks nodes rather than moving intervals, so that pointers to the
+// other intervals stay valid while the caller is walking the tree
+static void __remove_memory(struct MemoryIntervals *mm,
+                            struct MemoryInterval *e) {
+  struct MemoryInterval *p, *s;
+  if (e->left && e->right) {
+    for (s = e->right; s->left;)
+      s = s->left;
+    if (s->parent != e) {
+      p = s->parent;
+      __swap_memory(mm, p, s, s->right);
+      s->right = e->right;
+      s->right->parent = s;
+    } else {
+      p = s;
+    }
+    __swap_memory(mm, e->parent, e, s);
+    s->left = e->left;
+    s->left->parent = s;
+  } else {
+    p = e->parent;
+    __swap_memory(mm, p, e, e->left ? e->left : e->right);
+  }
+  --mm->i;
+  __balance_memory(mm, p);
+  __free_memory(mm, e);
 }
 
-int __untrack_memory(struct MemoryIntervals *mm, int x, int y,
-                     void wf(struct MemoryIntervals *, int, int)) {
-  unsigned l, r;
+static struct MemoryInterval *__build_memory(struct MemoryInterval *p,
+                                             size_t n,
+                                             struct MemoryInterval *parent) {
+  size_t m;
+  struct MemoryInterval *e;
+  if (!n)
+    return 0;
+  e = p + (m = n / 2);
+  e->parent = parent;
+  e->left = __build_memory(p, m, e);
+  e->right = __build_memory(p + m + 1, n - m - 1, e);
+  __fix_memory_height(e);
+  return e;
+}
+
+/**
+ * Replaces tracked intervals with sorted array of `n` intervals.
+ *
+ * The array becomes the nodes of the tree, so it must outlive it. This
+ * is how intervals are restored after fork() on Windows, which copies
+ * them as a flat array. The caller is responsible for accounting for
+ * where the array lives, via `mm->n`, `mm->c` and `mm->free`.
+ */
+void __rebuild_memory(struct MemoryIntervals *mm, struct MemoryInterval *p,
+                      size_t n) {
+  __begin_memory_write(mm);
+  mm->root = __build_memory(p, n, 0);
+  mm->i = n;
+  __end_memory_write(mm);
+}
+
+static int __untrack_memory_impl(struct MemoryIntervals *mm, int x, int y,
+                                 void wf(struct MemoryInterval *)) {
+  size_t n;
+  struct MemoryInterval *l, *r, *e, *f;
   unassert(y >= x);
+  // __choose_memory() may no longer skip frames that are being freed
+  if (x < mm->hint && y >= mm->hintlo)
+    mm->hint = MAX(mm->hintlo, x);
   if (!mm->i)
     return 0;
-  // binary search for the lefthand side
-  l = __find_memory(mm, x);
-  if (l == mm->i)
+  // find the lefthand side
+  if (!(l = __find_memory(mm, x)))
     return 0;
-  if (y < mm->p[l].x)
+  if (y < l->x)
     return 0;
 
-  // binary search for the righthand side
+  // find the righthand side
   r = __find_memory(mm, y);
-  if (r == mm->i || (r > l && y < mm->p[r].x))
-    --r;
-  unassert(r >= l);
-  unassert(x <= mm->p[r].y);
+  if (!r) {
+    r = __last_memory(mm);
+  } else if (r != l && y < r->x) {
+    r = __prev_memory(r);
+  }
+  for (n = 1, e = l; e != r; e = __next_memory(e))
+    ++n;
+  unassert(x <= r->y);
 
   // remove the middle of an existing map
   //
@@ -145,8 +272,16 @@ int __untrack_memory(struct MemoryIntervals *mm, int x, int y,
   //
   // this isn't possible on windows because we track each
   // 64kb segment on that platform using a separate entry
-  if (l == r && x > mm->p[l].x && y < mm->p[l].y) {
-    return __punch_memory(mm, x, y, l);
+  if (l == r && x > l->x && y < l->y) {
+    if (!(e = __alloc_memory(mm)))
+      return -1;
+    *e = *l;
+    l->size -= (size_t)(l->y - (x - 1)) * FRAMESIZE;
+    l->y = x - 1;
+    e->size -= (size_t)((y + 1) - e->x) * FRAMESIZE;
+    e->x = y + 1;
+    __insert_memory(mm, e);
+    return 0;
   }
 
   // trim the right side of the lefthand map
@@ -155,14 +290,15 @@ int __untrack_memory(struct MemoryIntervals *mm, int x, int y,
   //           xxxxx
   // ----|mmmm|----------------- after
   //
-  if (x > mm->p[l].x && x <= mm->p[l].y) {
-    unassert(y >= mm->p[l].y);
+  if (x > l->x && x <= l->y) {
+    unassert(y >= l->y);
     if (IsWindows())
       return einval();
-    mm->p[l].size -= (size_t)(mm->p[l].y - (x - 1)) * FRAMESIZE;
-    mm->p[l].y = x - 1;
-    unassert(mm->p[l].x <= mm->p[l].y);
-    ++l;
+    l->size -= (size_t)(l->y - (x - 1)) * FRAMESIZE;
+    l->y = x - 1;
+    unassert(l->x <= l->y);
+    l = __next_memory(l);
+    --n;
   }
 
   // trim the left side of the righthand map
@@ -171,73 +307,98 @@ int __untrack_memory(struct MemoryIntervals *mm, int x, int y,
   //           xxxxx
   // ---------------|mm|-------- after
   //
-  if (y >= mm->p[r].x && y < mm->p[r].y) {
-    unassert(x <= mm->p[r].x);
+  if (n && y >= r->x && y < r->y) {
+    unassert(x <= r->x);
     if (IsWindows())
       return einval();
-    mm->p[r].size -= (size_t)((y + 1) - mm->p[r].x) * FRAMESIZE;
-    mm->p[r].x = y + 1;
-    unassert(mm->p[r].x <= mm->p[r].y);
-    --r;
+    r->size -= (size_t)((y + 1) - r->x) * FRAMESIZE;
+    r->x = y + 1;
+    unassert(r->x <= r->y);
+    --n;
   }
 
-  if (l <= r) {
+  for (e = l; n--; e = f) {
+    f = __next_memory(e);
     if (IsWindows() && wf) {
-      wf(mm, l, r);
+      wf(e);
     }
-    __remove_memory(mm, l, r - l + 1);
+    __remove_memory(mm, e);
   }
   return 0;
 }
 
-int __track_memory(struct MemoryIntervals *mm, int x, int y, long h, int prot,
-                   int flags, bool readonlyfile, bool iscow, long offset,
-                   long size) {
-  unsigned i;
+int __untrack_memory(struct MemoryIntervals *mm, int x, int y,
+                     void wf(struct MemoryInterval *)) {
+  int rc;
+  __begin_memory_write(mm);
+  rc = __untrack_memory_impl(mm, x, y, wf);
+  __end_memory_write(mm);
+  return rc;
+}
+
+static int __track_memory_impl(struct MemoryIntervals *mm, int x, int y,
+                               long h, int prot, int flags, bool readonlyfile,
+                               bool iscow, long offset, long size) {
+  struct MemoryInterval *l, *r, *e;
   unassert(y >= x);
-  i = __find_memory(mm, x);
+  if ((r = __find_memory(mm, x))) {
+    l = __prev_memory(r);
+  } else {
+    l = __last_memory(mm);
+  }
 
   // try to extend the righthand side of the lefthand entry
   // we can't do that if we're tracking independent handles
   // we can't do that if it's a file map with a small size!
-  if (i && x == mm->p[i - 1].y + 1 && h == mm->p[i - 1].h &&
-      prot == mm->p[i - 1].prot && flags == mm->p[i - 1].flags &&
-      mm->p[i - 1].size ==
-          (size_t)(mm->p[i - 1].y - mm->p[i - 1].x) * FRAMESIZE + FRAMESIZE) {
-    mm->p[i - 1].size += (size_t)(y - mm->p[i - 1].y) * FRAMESIZE;
-    mm->p[i - 1].y = y;
+  if (l && x == l->y + 1 && h == l->h && prot == l->prot &&
+      flags == l->flags &&
+      l->size == (size_t)(l->y - l->x) * FRAMESIZE + FRAMESIZE) {
+    l->size += (size_t)(y - l->y) * FRAMESIZE;
+    l->y = y;
     // if we filled the hole then merge the two mappings
-    if (i < mm->i && y + 1 == mm->p[i].x && h == mm->p[i].h &&
-        prot == mm->p[i].prot && flags == mm->p[i].flags) {
-      mm->p[i - 1].y = mm->p[i].y;
-      mm->p[i - 1].size += mm->p[i].size;
-      __remove_memory(mm, i, 1);
+    if (r && y + 1 == r->x && h == r->h && prot == r->prot &&
+        flags == r->flags) {
+      l->y = r->y;
+      l->size += r->size;
+      __remove_memory(mm, r);
     }
   }
 
   // try to extend the lefthand side of the righthand entry
   // we can't do that if we're creating a smaller file map!
-  else if (i < mm->i && y + 1 == mm->p[i].x && h == mm->p[i].h &&
-           prot == mm->p[i].prot && flags == mm->p[i].flags &&
+  else if (r && y + 1 == r->x && h == r->h && prot == r->prot &&
+           flags == r->flags &&
            size == (size_t)(y - x) * FRAMESIZE + FRAMESIZE) {
-    mm->p[i].size += (size_t)(mm->p[i].x - x) * FRAMESIZE;
-    mm->p[i].x = x;
+    r->size += (size_t)(r->x - x) * FRAMESIZE;
+    r->x = x;
   }
 
-  // otherwise, create a new entry and memmove the items
+  // otherwise, create a new entry and insert it into the tree
   else {
-    if (__mint_memory(mm, i) == -1)
+    if (!(e = __alloc_memory(mm)))
       return -1;
-    mm->p[i].x = x;
-    mm->p[i].y = y;
-    mm->p[i].h = h;
-    mm->p[i].prot = prot;
-    mm->p[i].flags = flags;
-    mm->p[i].offset = offset;
-    mm->p[i].size = size;
-    mm->p[i].iscow = iscow;
-    mm->p[i].readonlyfile = readonlyfile;
+    e->x = x;
+    e->y = y;
+    e->h = h;
+    e->prot = prot;
+    e->flags = flags;
+    e->offset = offset;
+    e->size = size;
+    e->iscow = iscow;
+    e->readonlyfile = readonlyfile;
+    __insert_memory(mm, e);
   }
 
   return 0;
 }
+
+int __track_memory(struct MemoryIntervals *mm, int x, int y, long h, int prot,
+                   int flags, bool readonlyfile, bool iscow, long offset,
+                   long size) {
+  int rc;
+  __begin_memory_write(mm);
+  rc = __track_memory_impl(mm, x, y, h, prot, flags, readonlyfile, iscow,
+                           offset, size);
+  __end_memory_write(mm);
+  return rc;
+}
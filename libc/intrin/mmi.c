@@ -20,9 +20,5 @@
 #include "libc/runtime/memtrack.internal.h"
 #include "libc/thread/thread.h"
 
-#ifdef __x86_64__
-__static_yoink("_init__mmi");
-#endif
-
 struct MemoryIntervals _mmi;
 pthread_mutex_t __mmi_lock_obj = {._type = PTHREAD_MUTEX_RECURSIVE};
@@ -23,41 +23,43 @@
 #include "libc/macros.internal.h"
 #include "libc/runtime/memtrack.internal.h"
 
-static bool IsNoteworthyHole(unsigned i, const struct MemoryIntervals *mm) {
+static bool IsNoteworthyHole(const struct MemoryInterval *e,
+                             const struct MemoryInterval *f) {
   // gaps between shadow frames aren't interesting
   // the chasm from heap to stack ruins statistics
-  return !(
-      (IsShadowFrame(mm->p[i].y) || IsShadowFrame(mm->p[i + 1].x)) ||
-      (!IsStaticStackFrame(mm->p[i].y) && IsStaticStackFrame(mm->p[i + 1].x)));
+  return !((IsShadowFrame(e->y) || IsShadowFrame(f->x)) ||
+           (!IsStaticStackFrame(e->y) && IsStaticStackFrame(f->x)));
 }
 
 void PrintMemoryIntervals(int fd, const struct MemoryIntervals *mm) {
-  long i, w, frames, maptally = 0;
+  long w, frames, maptally = 0;
+  struct MemoryInterval *e, *f;
   char mappingbuf[8], framebuf[64], sb[16];
-  for (w = i = 0; i < mm->i; ++i) {
-    w = MAX(w, LengthInt64Thousands(mm->p[i].y + 1 - mm->p[i].x));
+  for (w = 0, e = __first_memory(mm); e; e = __next_memory(e)) {
+    w = MAX(w, LengthInt64Thousands(e->y + 1 - e->x));
   }
-  for (i = 0; i < mm->i; ++i) {
-    frames = mm->p[i].y + 1 - mm->p[i].x;
+  for (e = __first_memory(mm); e; e = f) {
+    f = __next_memory(e);
+    frames = e->y + 1 - e->x;
     maptally += frames;
-    kprintf("%08x-%08x %s %'*ldx %s", mm->p[i].x, mm->p[i].y,
-            (DescribeMapping)(mappingbuf, mm->p[i].prot, mm->p[i].flags), w,
-            frames, (DescribeFrame)(framebuf, mm->p[i].x));
-    if (mm->p[i].iscow)
+    kprintf("%08x-%08x %s %'*ldx %s", e->x, e->y,
+            (DescribeMapping)(mappingbuf, e->prot, e->flags), w, frames,
+            (DescribeFrame)(framebuf, e->x));
+    if (e->iscow)
       kprintf(" cow");
-    if (mm->p[i].readonlyfile)
+    if (e->readonlyfile)
       kprintf(" readonlyfile");
-    sizefmt(sb, mm->p[i].size, 1024);
+    sizefmt(sb, e->size, 1024);
     kprintf(" %sB", sb);
-    if (i + 1 < mm->i) {
-      frames = mm->p[i + 1].x - mm->p[i].y - 1;
-      if (frames && IsNoteworthyHole(i, mm)) {
+    if (f) {
+      frames = f->x - e->y - 1;
+      if (frames && IsNoteworthyHole(e, f)) {
         sizefmt(sb, frames * FRAMESIZE, 1024);
         kprintf(" w/ %sB hole", sb);
       }
     }
-    if (mm->p[i].h != -1) {
-      kprintf(" h=%ld", mm->p[i].h);
+    if (e->h != -1) {
+      kprintf(" h=%ld", e->h);
     }
     kprintf("\n");
   }
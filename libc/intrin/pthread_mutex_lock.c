@@ -25,8 +25,35 @@
 #include "libc/runtime/internal.h"
 #include "libc/thread/thread.h"
 #include "libc/thread/tls.h"
+#include "third_party/nsync/futex.internal.h"
 #include "third_party/nsync/mu.h"
 
+// acquires mutex->_lock, which is 0 if free, 1 if held, and 2 if held
+// with other threads possibly sleeping on the futex. that's important
+// for process shared mutexes, since they can't be delegated to *NSYNC
+static void pthread_mutex_lock_impl(pthread_mutex_t *mutex) {
+  int i, c;
+  for (i = 0; i < 100; ++i) {
+    c = 0;
+    if (atomic_compare_exchange_weak_explicit(&mutex->_lock, &c, 1,
+                                              memory_order_acquire,
+                                              memory_order_relaxed)) {
+      return;
+    }
+    if (c == 2) {
+      break;
+    }
+    pthread_pause_np();
+  }
+  while (atomic_exchange_explicit(&mutex->_lock, 2, memory_order_acquire)) {
+    if (_weaken(nsync_futex_wait_)) {
+      _weaken(nsync_futex_wait_)(&mutex->_lock, 2, mutex->_pshared, 0);
+    } else {
+      pthread_pause_np();
+    }
+  }
+}
+
 /**
  * Locks mutex.
  *
@@ -81,9 +108,7 @@ errno_t pthread_mutex_lock(pthread_mutex_t *mutex) {
   }
 
   if (mutex->_type == PTHREAD_MUTEX_NORMAL) {
-    while (atomic_exchange_explicit(&mutex->_lock, 1, memory_order_acquire)) {
-      pthread_pause_np();
-    }
+    pthread_mutex_lock_impl(mutex);
     return 0;
   }
 
@@ -101,9 +126,7 @@ errno_t pthread_mutex_lock(pthread_mutex_t *mutex) {
     }
   }
 
-  while (atomic_exchange_explicit(&mutex->_lock, 1, memory_order_acquire)) {
-    pthread_pause_np();
-  }
+  pthread_mutex_lock_impl(mutex);
 
   mutex->_depth = 0;
   mutex->_owner = t;
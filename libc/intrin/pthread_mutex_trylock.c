@@ -24,6 +24,14 @@
 #include "libc/thread/thread.h"
 #include "third_party/nsync/mu.h"
 
+// compare and swap, because exchanging would clobber the state where
+// the owner was told there might be sleepers it needs to wake up
+static bool pthread_mutex_trylock_impl(pthread_mutex_t *mutex) {
+  int c = 0;
+  return atomic_compare_exchange_strong_explicit(
+      &mutex->_lock, &c, 1, memory_order_acquire, memory_order_relaxed);
+}
+
 /**
  * Attempts acquiring lock.
  *
@@ -53,7 +61,7 @@ errno_t pthread_mutex_trylock(pthread_mutex_t *mutex) {
 
   // handle normal mutexes
   if (mutex->_type == PTHREAD_MUTEX_NORMAL) {
-    if (!atomic_exchange_explicit(&mutex->_lock, 1, memory_order_acquire)) {
+    if (pthread_mutex_trylock_impl(mutex)) {
       return 0;
     } else {
       return EBUSY;
@@ -75,7 +83,7 @@ errno_t pthread_mutex_trylock(pthread_mutex_t *mutex) {
     }
   }
 
-  if (atomic_exchange_explicit(&mutex->_lock, 1, memory_order_acquire)) {
+  if (!pthread_mutex_trylock_impl(mutex)) {
     return EBUSY;
   }
 
@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/dce.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #ifndef __aarch64__
 
@@ -51,6 +52,30 @@ static __vex size_t __strlen(const char *s) {
 #endif
 }
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+_Microarchitecture("avx2") static size_t strlen_avx2(const char *s) {
+  typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(32)));
+  ymm_t z = {0};
+  unsigned m, k = (uintptr_t)s & 31;
+  const ymm_t *p = (const ymm_t *)((uintptr_t)s & -32);
+  m = __builtin_ia32_pmovmskb256(*p == z) >> k << k;
+  while (!m)
+    m = __builtin_ia32_pmovmskb256(*++p == z);
+  return (const char *)p + __builtin_ctz(m) - s;
+}
+
+_Microarchitecture("avx512bw") static size_t strlen_avx512(const char *s) {
+  typedef char zmm_t __attribute__((__vector_size__(64), __aligned__(64)));
+  zmm_t z = {0};
+  unsigned long m, k = (uintptr_t)s & 63;
+  const zmm_t *p = (const zmm_t *)((uintptr_t)s & -64);
+  m = __builtin_ia32_pcmpeqb512_mask(*p, z, -1) >> k << k;
+  while (!m)
+    m = __builtin_ia32_pcmpeqb512_mask(*++p, z, -1);
+  return (const char *)p + __builtin_ctzl(m) - s;
+}
+#endif
+
 /**
  * Returns length of NUL-terminated string.
  *
@@ -59,6 +84,12 @@ static __vex size_t __strlen(const char *s) {
  * @asyncsignalsafe
  */
 size_t strlen(const char *s) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX512BW))
+    return strlen_avx512(s);
+  if (X86_HAVE(AVX2))
+    return strlen_avx2(s);
+#endif
   return __strlen(s);
 }
 
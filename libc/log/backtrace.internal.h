@@ -6,7 +6,6 @@
 COSMOPOLITAN_C_START_
 
 forceinline pureconst bool IsValidStackFramePointer(struct StackFrame *x) {
-  /* assumes __mmi_lock() is held */
   return IsLegalPointer(x) && !((uintptr_t)x & 15) &&
          (IsStaticStackFrame((uintptr_t)x >> 16) ||
           IsOldStackFrame((uintptr_t)x >> 16) ||
@@ -0,0 +1,376 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/arena.h"
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/limits.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/hook.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdckdint.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+// arenas hand out memory by bumping a pointer through a list of chunks
+// that were mmap()'d. resetting an arena rewinds the pointer and keeps
+// the chunks around to be used again. chunks of arenas that have been
+// destroyed are kept on a small global free list for the next one.
+//
+// every allocation is preceded by a header whose magic number can't be
+// mistaken for the size field of a dlmalloc chunk header, so free() can
+// tell arena memory apart from heap memory once malloc is redirected.
+
+#define ARENA_CHUNK 65536
+#define ARENA_CACHE 32
+#define ARENA_ALIGN 16
+#define ARENA_MAGIC 0xa7e4a7e4a7e4a7e4ul
+
+struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t size;
+  size_t used;
+};
+
+struct ArenaHeader {
+  size_t size;
+  size_t magic;
+};
+
+struct CosmoArena {
+  struct ArenaChunk *head;
+  struct ArenaChunk *cur;
+  struct CosmoArena *prev;  // arena that was pushed before this one
+};
+
+static struct {
+  pthread_spinlock_t lock;
+  int count;
+  struct ArenaChunk *list;
+} __arena_cache;
+
+static struct {
+  atomic_uint once;
+  void (*free)(void *);
+  void *(*malloc)(size_t);
+  void *(*calloc)(size_t, size_t);
+  void *(*memalign)(size_t, size_t);
+  void *(*realloc)(void *, size_t);
+  void *(*realloc_in_place)(void *, size_t);
+  size_t (*malloc_usable_size)(void *);
+  size_t (*bulk_free)(void *[], size_t);
+} __arena_hooks;
+
+static _Thread_local struct CosmoArena *__arena_current;
+
+static struct ArenaChunk *__arena_chunk_new(size_t need) {
+  size_t size;
+  struct ArenaChunk *c;
+  size = ROUNDUP(sizeof(struct ArenaChunk) + need, ARENA_CHUNK);
+  if (size == ARENA_CHUNK) {
+    pthread_spin_lock(&__arena_cache.lock);
+    if ((c = __arena_cache.list)) {
+      __arena_cache.list = c->next;
+      --__arena_cache.count;
+    }
+    pthread_spin_unlock(&__arena_cache.lock);
+    if (c) {
+      c->used = 0;
+      return c;
+    }
+  }
+  if (!(c = _mapanon(size)))
+    return 0;
+  c->size = size;
+  c->used = 0;
+  return c;
+}
+
+static void __arena_chunk_free(struct ArenaChunk *c) {
+  if (c->size == ARENA_CHUNK) {
+    pthread_spin_lock(&__arena_cache.lock);
+    if (__arena_cache.count < ARENA_CACHE) {
+      c->next = __arena_cache.list;
+      __arena_cache.list = c;
+      ++__arena_cache.count;
+      c = 0;
+    }
+    pthread_spin_unlock(&__arena_cache.lock);
+    if (!c)
+      return;
+  }
+  munmap(c, c->size);
+}
+
+// returns pointer aligned to `align` that has `n` bytes available, and
+// a header right before it, or null w/ enomem
+static void *__arena_bump(struct CosmoArena *a, size_t align, size_t n) {
+  char *base;
+  size_t need, off;
+  struct ArenaChunk *c, *c2;
+  struct ArenaHeader *h;
+  if (align < ARENA_ALIGN)
+    align = ARENA_ALIGN;
+  if (n > SIZE_MAX / 2 || align > SIZE_MAX / 4) {
+    errno = ENOMEM;
+    return 0;
+  }
+  n = ROUNDUP(n ? n : 1, ARENA_ALIGN);
+  for (c = a->cur;;) {
+    base = (char *)c + sizeof(struct ArenaChunk);
+    off = ROUNDUP(c->used + sizeof(struct ArenaHeader), align);
+    if (off + n <= c->size - sizeof(struct ArenaChunk))
+      break;
+    // chunks after the current one are leftovers from before a reset
+    if ((c2 = c->next) &&
+        ROUNDUP(sizeof(struct ArenaHeader), align) + n <=
+            c2->size - sizeof(struct ArenaChunk)) {
+      c = c2;
+      c->used = 0;
+      continue;
+    }
+    need = sizeof(struct ArenaHeader) + align + n;
+    if (!(c2 = __arena_chunk_new(need)))
+      return 0;
+    c2->next = c->next;
+    c->next = c2;
+    c = c2;
+  }
+  a->cur = c;
+  c->used = off + n;
+  h = (struct ArenaHeader *)(base + off) - 1;
+  h->size = n;
+  h->magic = ARENA_MAGIC;
+  return base + off;
+}
+
+static struct ArenaHeader *__arena_header(void *p) {
+  struct ArenaHeader *h;
+  if (!p || ((uintptr_t)p & (ARENA_ALIGN - 1)))
+    return 0;
+  h = (struct ArenaHeader *)p - 1;
+  return h->magic == ARENA_MAGIC ? h : 0;
+}
+
+/**
+ * Creates new memory arena.
+ *
+ * Arenas allocate memory by incrementing a pointer. Memory is released
+ * all at once, by cosmo_arena_reset() or cosmo_arena_destroy(). This is
+ * useful for request-scoped code that makes lots of small allocations.
+ *
+ * @return new arena, or null w/ errno
+ */
+struct CosmoArena *cosmo_arena_create(void) {
+  struct ArenaChunk *c;
+  struct CosmoArena *a;
+  if (!(c = __arena_chunk_new(sizeof(struct CosmoArena))))
+    return 0;
+  c->next = 0;
+  c->used = sizeof(struct CosmoArena);
+  a = (struct CosmoArena *)(c + 1);
+  a->head = c;
+  a->cur = c;
+  a->prev = 0;
+  return a;
+}
+
+/**
+ * Allocates memory from arena.
+ *
+ * @return pointer aligned on a 16-byte boundary, or null w/ errno
+ */
+void *cosmo_arena_alloc(struct CosmoArena *a, size_t n) {
+  return __arena_bump(a, ARENA_ALIGN, n);
+}
+
+/**
+ * Allocates aligned memory from arena.
+ *
+ * @param align must be a two power
+ * @return pointer aligned on an `align` byte boundary, or null w/ errno
+ */
+void *cosmo_arena_memalign(struct CosmoArena *a, size_t align, size_t n) {
+  if (!align || (align & (align - 1))) {
+    errno = EINVAL;
+    return 0;
+  }
+  return __arena_bump(a, align, n);
+}
+
+/**
+ * Returns current position of arena, for cosmo_arena_reset().
+ */
+struct CosmoArenaMark cosmo_arena_mark(struct CosmoArena *a) {
+  return (struct CosmoArenaMark){a->cur, a->cur->used};
+}
+
+/**
+ * Frees everything allocated from arena since `mark` was taken.
+ *
+ * This takes constant time. The chunks of memory that were used stay
+ * with the arena, to be used again by future allocations.
+ *
+ * @param mark was returned by cosmo_arena_mark(), or null to free all
+ *     memory that's been allocated from the arena
+ */
+void cosmo_arena_reset(struct CosmoArena *a, const struct CosmoArenaMark *m) {
+  if (m) {
+    a->cur = m->chunk;
+    a->cur->used = m->used;
+  } else {
+    a->cur = a->head;
+    a->cur->used = sizeof(struct CosmoArena);
+  }
+}
+
+/**
+ * Destroys arena, freeing all memory that was allocated from it.
+ */
+void cosmo_arena_destroy(struct CosmoArena *a) {
+  struct ArenaChunk *c, *next;
+  if (!a)
+    return;
+  for (c = a->head; c; c = next) {
+    next = c->next;
+    __arena_chunk_free(c);
+  }
+}
+
+static void *__arena_malloc(size_t n) {
+  struct CosmoArena *a;
+  if ((a = __arena_current))
+    return __arena_bump(a, ARENA_ALIGN, n);
+  return __arena_hooks.malloc(n);
+}
+
+static void *__arena_calloc(size_t n, size_t z) {
+  void *p;
+  struct CosmoArena *a;
+  if ((a = __arena_current)) {
+    if (ckd_mul(&n, n, z)) {
+      errno = ENOMEM;
+      return 0;
+    }
+    if ((p = __arena_bump(a, ARENA_ALIGN, n)))
+      bzero(p, n);
+    return p;
+  }
+  return __arena_hooks.calloc(n, z);
+}
+
+static void *__arena_memalign(size_t align, size_t n) {
+  struct CosmoArena *a;
+  if ((a = __arena_current))
+    return cosmo_arena_memalign(a, align, n);
+  return __arena_hooks.memalign(align, n);
+}
+
+static void __arena_free(void *p) {
+  if (!__arena_header(p))
+    __arena_hooks.free(p);
+}
+
+static void *__arena_realloc(void *p, size_t n) {
+  void *q;
+  struct ArenaHeader *h;
+  if (!p && __arena_current)
+    return __arena_malloc(n);
+  if (!(h = __arena_header(p)))
+    return __arena_hooks.realloc(p, n);
+  if (n <= h->size)
+    return p;
+  if ((q = malloc(n)))
+    memcpy(q, p, h->size);
+  return q;
+}
+
+static void *__arena_realloc_in_place(void *p, size_t n) {
+  struct ArenaHeader *h;
+  if (!(h = __arena_header(p)))
+    return __arena_hooks.realloc_in_place(p, n);
+  return n <= h->size ? p : 0;
+}
+
+static size_t __arena_malloc_usable_size(void *p) {
+  struct ArenaHeader *h;
+  if ((h = __arena_header(p)))
+    return h->size;
+  return __arena_hooks.malloc_usable_size(p);
+}
+
+static size_t __arena_bulk_free(void *p[], size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i)
+    if (__arena_header(p[i]))
+      p[i] = 0;
+  return __arena_hooks.bulk_free(p, n);
+}
+
+static void __arena_install(void) {
+  __arena_hooks.free = hook_free;
+  __arena_hooks.malloc = hook_malloc;
+  __arena_hooks.calloc = hook_calloc;
+  __arena_hooks.memalign = hook_memalign;
+  __arena_hooks.realloc = hook_realloc;
+  __arena_hooks.realloc_in_place = hook_realloc_in_place;
+  __arena_hooks.malloc_usable_size = hook_malloc_usable_size;
+  __arena_hooks.bulk_free = hook_bulk_free;
+  hook_free = __arena_free;
+  hook_malloc = __arena_malloc;
+  hook_calloc = __arena_calloc;
+  hook_memalign = __arena_memalign;
+  hook_realloc = __arena_realloc;
+  hook_realloc_in_place = __arena_realloc_in_place;
+  hook_malloc_usable_size = __arena_malloc_usable_size;
+  hook_bulk_free = __arena_bulk_free;
+}
+
+/**
+ * Redirects malloc() in calling thread to arena.
+ *
+ * Until cosmo_arena_pop() is called, memory allocated by this thread
+ * using malloc(), calloc(), memalign(), etc. comes from `a`. Calling
+ * free() on such memory does nothing. It may be called by any thread
+ * and it's fine if that happens after the arena is popped, but not
+ * after the arena is reset or destroyed. Calls may be nested.
+ *
+ * Other threads aren't affected, except that malloc() becomes a tiny
+ * bit slower after the first time this is called. This function does
+ * nothing in asan mode, which needs malloc() to itself.
+ */
+void cosmo_arena_push(struct CosmoArena *a) {
+  if (IsAsan())
+    return;
+  cosmo_once(&__arena_hooks.once, __arena_install);
+  a->prev = __arena_current;
+  __arena_current = a;
+}
+
+/**
+ * Stops redirecting malloc() to arena that was last pushed.
+ */
+void cosmo_arena_pop(void) {
+  struct CosmoArena *a;
+  if ((a = __arena_current))
+    __arena_current = a->prev;
+}
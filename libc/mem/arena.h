@@ -0,0 +1,27 @@
+#ifdef _COSMO_SOURCE
+#ifndef COSMOPOLITAN_LIBC_MEM_ARENA_H_
+#define COSMOPOLITAN_LIBC_MEM_ARENA_H_
+COSMOPOLITAN_C_START_
+
+struct CosmoArena;
+
+struct CosmoArenaMark {
+  void *chunk;
+  size_t used;
+};
+
+struct CosmoArena *cosmo_arena_create(void) libcesque;
+void *cosmo_arena_alloc(struct CosmoArena *, size_t) libcesque
+    attributeallocsize((2)) mallocesque;
+void *cosmo_arena_memalign(struct CosmoArena *, size_t, size_t) libcesque
+    attributeallocalign((2)) attributeallocsize((3)) mallocesque;
+struct CosmoArenaMark cosmo_arena_mark(struct CosmoArena *) libcesque;
+void cosmo_arena_reset(struct CosmoArena *,
+                       const struct CosmoArenaMark *) libcesque;
+void cosmo_arena_destroy(struct CosmoArena *) libcesque;
+void cosmo_arena_push(struct CosmoArena *) libcesque;
+void cosmo_arena_pop(void) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_MEM_ARENA_H_ */
+#endif /* _COSMO_SOURCE */
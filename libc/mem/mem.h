@@ -4,6 +4,7 @@
 #define M_TRIM_THRESHOLD (-1)
 #define M_GRANULARITY    (-2)
 #define M_MMAP_THRESHOLD (-3)
+#define M_HUGEPAGES      (-9)
 
 COSMOPOLITAN_C_START_
 /*───────────────────────────────────────────────────────────────────────────│─╗
@@ -39,7 +40,7 @@ struct mallinfo {
   size_t arena;    /* non-mmapped space allocated from system */
   size_t ordblks;  /* number of free chunks */
   size_t smblks;   /* always 0 */
-  size_t hblks;    /* always 0 */
+  size_t hblks;    /* bytes in transparent huge page regions */
   size_t hblkhd;   /* space in mmapped regions */
   size_t usmblks;  /* maximum total allocated space */
   size_t fsmblks;  /* always 0 */
@@ -174,6 +174,23 @@ TryAgain:
   }
 }
 
+// sends intervals to the child as a flat array in order of address
+static textwindows bool WriteMemoryIntervals(int64_t h) {
+  size_t n;
+  struct MemoryInterval *e, buf[64];
+  if (!WriteAll(h, &_mmi.i, sizeof(_mmi.i)))
+    return false;
+  for (n = 0, e = __first_memory(&_mmi); e; e = __next_memory(e)) {
+    buf[n++] = *e;
+    if (n == ARRAYLEN(buf)) {
+      if (!WriteAll(h, buf, sizeof(buf)))
+        return false;
+      n = 0;
+    }
+  }
+  return WriteAll(h, buf, n * sizeof(*buf));
+}
+
 static __msabi textwindows int OnForkCrash(struct NtExceptionPointers *ep) {
   kprintf("error: fork() child crashed!%n"
           "\tExceptionCode = %#x%n"
@@ -192,7 +209,7 @@ textwindows void WinMainForked(void) {
   struct MemoryInterval *maps;
   char16_t fvar[21 + 1 + 21 + 1];
   uint32_t i, varlen, oldprot, savepid;
-  long mapcount, mapcapacity, specialz;
+  long mapcount, specialz;
   struct Fds *fds = __veil("r", &g_fds);
 
   // check to see if the process was actually forked
@@ -210,20 +227,18 @@ textwindows void WinMainForked(void) {
   // read the cpu state from the parent process & plus
   // read the list of mappings from the parent process
   // this is stored in a special secretive memory map!
-  // read ExtendMemoryIntervals for further details :|
+  // read WriteMemoryIntervals for further details :|
   maps = (void *)kMemtrackStart;
   ReadOrDie(reader, jb, sizeof(jb));
   ReadOrDie(reader, &mapcount, sizeof(_mmi.i));
-  ReadOrDie(reader, &mapcapacity, sizeof(_mmi.n));
-  specialz = ROUNDUP(mapcapacity * sizeof(_mmi.p[0]), kMemtrackGran);
+  specialz = ROUNDUP(mapcount * sizeof(*maps), kMemtrackGran);
   ViewOrDie(MapOrDie(kNtPageReadwrite, specialz), kNtFileMapWrite, 0, specialz,
             maps);
-  ReadOrDie(reader, maps, mapcount * sizeof(_mmi.p[0]));
+  ReadOrDie(reader, maps, mapcount * sizeof(*maps));
   if (IsAsan()) {
     shad = (char *)(((intptr_t)maps >> 3) + 0x7fff8000);
     size = ROUNDUP(specialz >> 3, FRAMESIZE);
     ViewOrDie(MapOrDie(kNtPageReadwrite, size), kNtFileMapWrite, 0, size, shad);
-    ReadOrDie(reader, shad, (mapcount * sizeof(_mmi.p[0])) >> 3);
   }
 
   // read the heap mappings from the parent process
@@ -258,8 +273,12 @@ textwindows void WinMainForked(void) {
   __tls_enabled_set(false);
 
   // apply fixups and reapply memory protections
-  _mmi.p = maps;
-  _mmi.n = specialz / sizeof(_mmi.p[0]);
+  // the parent's tree nodes are meaningless here so the flat array of
+  // intervals becomes the slab, and s[] is left unused until exec
+  _mmi.free = 0;
+  _mmi.n = ARRAYLEN(_mmi.s) + mapcount;
+  _mmi.c = specialz / sizeof(*maps);
+  __rebuild_memory(&_mmi, maps, mapcount);
   for (i = 0; i < mapcount; ++i) {
     if (!VirtualProtect((void *)((uint64_t)maps[i].x << 16), maps[i].size,
                         __prot2nt(maps[i].prot, maps[i].iscow), &oldprot)) {
@@ -299,6 +318,7 @@ textwindows int sys_fork_nt(uint32_t dwCreationFlags) {
   struct Proc *proc;
   struct CosmoTib *tib;
   char16_t pipename[64];
+  struct MemoryInterval *e;
   int64_t reader, writer;
   struct NtStartupInfo startinfo;
   struct NtProcessInformation procinfo;
@@ -349,22 +369,14 @@ textwindows int sys_fork_nt(uint32_t dwCreationFlags) {
                             &startinfo, &procinfo);
       if (spawnrc != -1) {
         CloseHandle(procinfo.hThread);
-        ok = WriteAll(writer, jb, sizeof(jb)) &&
-             WriteAll(writer, &_mmi.i, sizeof(_mmi.i)) &&
-             WriteAll(writer, &_mmi.n, sizeof(_mmi.n)) &&
-             WriteAll(writer, _mmi.p, _mmi.i * sizeof(_mmi.p[0]));
-        if (IsAsan() && ok) {
-          ok = WriteAll(writer, (char *)(((intptr_t)_mmi.p >> 3) + 0x7fff8000),
-                        (_mmi.i * sizeof(_mmi.p[0])) >> 3);
-        }
-        for (i = 0; i < _mmi.i && ok; ++i) {
-          if ((_mmi.p[i].flags & MAP_TYPE) != MAP_SHARED) {
-            char *p = (char *)((uint64_t)_mmi.p[i].x << 16);
+        ok = WriteAll(writer, jb, sizeof(jb)) && WriteMemoryIntervals(writer);
+        for (e = __first_memory(&_mmi); e && ok; e = __next_memory(e)) {
+          if ((e->flags & MAP_TYPE) != MAP_SHARED) {
+            char *p = (char *)((uint64_t)e->x << 16);
             // XXX: forking destroys thread guard pages currently
-            VirtualProtect(
-                p, _mmi.p[i].size,
-                __prot2nt(_mmi.p[i].prot | PROT_READ, _mmi.p[i].iscow), &op);
-            ok = WriteAll(writer, p, _mmi.p[i].size);
+            VirtualProtect(p, e->size, __prot2nt(e->prot | PROT_READ, e->iscow),
+                           &op);
+            ok = WriteAll(writer, p, e->size);
           }
         }
         if (ok)
@@ -163,9 +163,6 @@ wontreturn textstartup void cosmo(long *sp, struct Syslib *m1, char *exename,
   __pid = sys_getpid().ax;
 
   // initialize memory manager
-  _mmi.i = 0;
-  _mmi.p = _mmi.s;
-  _mmi.n = ARRAYLEN(_mmi.s);
   __virtualmax = -1;
 
   // initialize file system
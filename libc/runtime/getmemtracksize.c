@@ -19,9 +19,10 @@
 #include "libc/runtime/memtrack.internal.h"
 
 size_t __get_memtrack_size(struct MemoryIntervals *mm) {
-  size_t i, n;
-  for (n = i = 0; i < mm->i; ++i) {
-    n += ((size_t)(mm->p[i].y - mm->p[i].x) + 1) << 16;
+  size_t n;
+  struct MemoryInterval *e;
+  for (n = 0, e = __first_memory(mm); e; e = __next_memory(e)) {
+    n += ((size_t)(e->y - e->x) + 1) << 16;
   }
   return n;
 }
@@ -16,11 +16,16 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/atomic.h"
 #include "libc/intrin/strace.internal.h"
 #include "libc/intrin/weaken.h"
 #include "libc/macros.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
+#include "libc/serialize.h"
+#include "libc/thread/pool.h"
+#include "libc/thread/thread.h"
+#include "libc/thread/tls.h"
 #include "third_party/puff/puff.h"
 #include "third_party/zlib/zlib.h"
 
@@ -63,3 +68,130 @@ int __inflate(void *out, size_t outsize, const void *in, size_t insize) {
          (int)MIN(40, insize), in, insize > 40 ? "..." : "", insize, rc);
   return rc;
 }
+
+#define MAX_INFLATE_THREADS 16
+#define MIN_INFLATE_PARALLEL (4 * 1024 * 1024)
+
+struct InflateSegments {
+  atomic_int failed;
+  uint8_t *out;
+  size_t outsize;
+  const uint8_t *in;
+  size_t insize;
+  uint32_t span;
+  const uint8_t *points;
+  size_t segments;
+};
+
+static _Atomic(struct CosmoPool *) __inflate_pool;
+
+static bool __inflate_segment(z_stream *zs, struct InflateSegments *j,
+                              size_t i) {
+  int rc;
+  size_t a, b, o;
+  a = i ? READ32LE(j->points + (i - 1) * 4) : 0;
+  b = i + 1 < j->segments ? READ32LE(j->points + i * 4) : j->insize;
+  o = i * j->span;
+  if (_weaken(inflateReset)(zs) != Z_OK)
+    return false;
+  zs->next_in = (uint8_t *)j->in + a;
+  zs->avail_in = b - a;
+  zs->next_out = j->out + o;
+  zs->avail_out = MIN(j->span, j->outsize - o);
+  rc = _weaken(inflate)(zs, Z_SYNC_FLUSH);
+  return (rc == Z_OK || rc == Z_STREAM_END) && !zs->avail_out;
+}
+
+static void __inflate_range(void *arg, size_t lo, size_t hi) {
+  size_t i;
+  z_stream zs = {0};
+  struct InflateSegments *j = arg;
+  if (_weaken(inflateInit2)(&zs, -MAX_WBITS) != Z_OK) {
+    j->failed = true;
+    return;
+  }
+  for (i = lo; i < hi && !j->failed; ++i)
+    if (!__inflate_segment(&zs, j, i))
+      j->failed = true;
+  _weaken(inflateEnd)(&zs);
+}
+
+// pool threads don't exist in the child, so it must make its own
+static void __inflate_pool_forget(void) {
+  atomic_store_explicit(&__inflate_pool, 0, memory_order_relaxed);
+}
+
+// returns pool shared by all callers, creating it on first use
+static struct CosmoPool *__inflate_pool_get(void) {
+  int n;
+  struct CosmoPool *p, *q;
+  if ((p = atomic_load_explicit(&__inflate_pool, memory_order_acquire)))
+    return p;
+  if ((n = MIN(MAX_INFLATE_THREADS, __get_cpu_count()) - 1) < 1)
+    return 0;
+  if (!(q = _weaken(cosmo_pool_create)(n)))
+    return 0;
+  if (atomic_compare_exchange_strong_explicit(&__inflate_pool, &p, q,
+                                              memory_order_acq_rel,
+                                              memory_order_acquire)) {
+    _weaken(pthread_atfork)(0, 0, __inflate_pool_forget);
+    return q;
+  }
+  _weaken(cosmo_pool_destroy)(q);
+  return p;
+}
+
+/**
+ * Decompresses raw deflate data that has full flush points.
+ *
+ * Content that zipobj compressed with a full flush every `span` bytes
+ * may be inflated as independent segments. If the output is at least
+ * 4mb, the thread pool is linked, and the process already has threads,
+ * then segments are handed out to a pool that's kept around for later
+ * calls. Otherwise the segments are inflated on the calling thread, so
+ * this never turns a single-threaded program into a threaded one. This
+ * does the same as __inflate() when zlib isn't linked.
+ *
+ * @param points is from GetZipCfileFlushPoints()
+ * @param count is number of points, i.e. segments minus one
+ * @return 0 on success or nonzero on failure
+ */
+int __inflate_segments(void *out, size_t outsize, const void *in,
+                       size_t insize, uint32_t span, const uint8_t *points,
+                       size_t count) {
+  struct CosmoPool *pool;
+  struct InflateSegments j = {
+      .out = out,
+      .outsize = outsize,
+      .in = in,
+      .insize = insize,
+      .span = span,
+      .points = points,
+      .segments = count + 1,
+  };
+  if (!count ||                    //
+      !_weaken(inflateInit2) ||    //
+      !_weaken(inflateReset) ||    //
+      !_weaken(inflate) ||         //
+      !_weaken(inflateEnd) ||      //
+      __runlevel < RUNLEVEL_MALLOC)
+    return __inflate(out, outsize, in, insize);
+  pool = 0;
+  if (__threaded &&                        //
+      outsize >= MIN_INFLATE_PARALLEL &&   //
+      _weaken(cosmo_pool_create) &&        //
+      _weaken(cosmo_pool_parallel_for) &&  //
+      _weaken(cosmo_pool_destroy) &&       //
+      _weaken(pthread_atfork))
+    pool = __inflate_pool_get();
+  if (pool) {
+    // subintervals it fails to schedule are run by this thread
+    _weaken(cosmo_pool_parallel_for)(pool, j.segments, 0, __inflate_range,
+                                     &j);
+  } else {
+    __inflate_range(&j, 0, j.segments);
+  }
+  STRACE("inflate_segments(%'zu, %'zu, %'u, %'zu) %s → %d", outsize, insize,
+         span, count, pool ? "in parallel" : "serially", j.failed);
+  return j.failed;
+}
@@ -19,25 +19,40 @@
 #include "libc/runtime/memtrack.internal.h"
 
 static inline bool IsMemtrackedImpl(int x, int y) {
-  unsigned i;
-  i = __find_memory(&_mmi, x);
-  if (i == _mmi.i)
+  size_t i;
+  struct MemoryInterval *e, *f;
+  if (!(e = __find_memory(&_mmi, x)))
     return false;
-  if (x < _mmi.p[i].x)
+  if (x < e->x)
     return false;
-  for (;;) {
-    if (y <= _mmi.p[i].y)
+  for (i = 0; i < _mmi.i; ++i) {
+    if (y <= e->y)
       return true;
-    if (++i == _mmi.i)
+    if (!(f = __next_memory(e)))
       return false;
-    if (_mmi.p[i].x != _mmi.p[i - 1].y + 1)
+    if (f->x != e->y + 1)
       return false;
+    e = f;
   }
+  return false;
 }
 
+/**
+ * Returns true if frames [x,y] are all tracked as mapped memory.
+ *
+ * This doesn't need __mmi_lock(). If a writer keeps changing the tree,
+ * e.g. because this was called from a signal handler that interrupted
+ * it, then an answer based on a possibly inconsistent read is returned
+ * after a few tries.
+ */
 bool IsMemtracked(int x, int y) {
-  /* assumes __mmi_lock() is held */
+  int tries;
   bool res;
-  res = IsMemtrackedImpl(x, y);
-  return res;
+  unsigned seq;
+  for (tries = 0;; ++tries) {
+    seq = __memtrack_begin(&_mmi);
+    res = IsMemtrackedImpl(x, y);
+    if (!__memtrack_retry(&_mmi, seq) || tries == 100)
+      return res;
+  }
 }
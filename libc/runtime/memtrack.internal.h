@@ -2,6 +2,7 @@
 #define COSMOPOLITAN_LIBC_RUNTIME_MEMTRACK_H_
 #include "ape/sections.internal.h"
 #include "libc/dce.h"
+#include "libc/intrin/atomic.h"
 #include "libc/macros.internal.h"
 #include "libc/nt/version.h"
 #include "libc/runtime/runtime.h"
@@ -24,6 +25,8 @@ COSMOPOLITAN_C_START_
 #define kMemtrackZiposSize  (0x6fdffffc0000 - kMemtrackZiposStart)
 #define kMemtrackGran       (!IsAsan() ? FRAMESIZE : FRAMESIZE * 8)
 
+#define kMemtrackDepth 64 /* bounds walks that race with a writer */
+
 struct MemoryInterval {
   int x;
   int y;
@@ -34,11 +37,28 @@ struct MemoryInterval {
   char prot;
   bool iscow;
   bool readonlyfile;
+  signed char height;
+  struct MemoryInterval *parent;
+  struct MemoryInterval *left;
+  struct MemoryInterval *right;
 };
 
+/*
+ * Intervals are kept in an AVL tree ordered by frame, so that tracking
+ * and untracking memory costs O(log n). Nodes come from s[] and then a
+ * slab at kMemtrackStart which only ever grows, so a node's memory is
+ * never unmapped. That lets lookups run without __mmi_lock(). Writers
+ * make seq odd while they change the tree, and a lookup that saw seq
+ * change is retried. See __memtrack_begin() and __memtrack_retry().
+ */
 struct MemoryIntervals {
-  size_t i, n;
-  struct MemoryInterval *p;
+  size_t i; /* number of intervals tracked */
+  size_t n; /* nodes handed out from s[] and then the slab */
+  size_t c; /* nodes that fit in the slab mapped so far */
+  struct MemoryInterval *root;
+  struct MemoryInterval *free;
+  _Atomic(unsigned) seq;
+  int hintlo, hint; /* frames [hintlo,hint) are known to be mapped */
   struct MemoryInterval s[16];
 };
 
@@ -48,17 +68,115 @@ void __mmi_lock(void);
 void __mmi_unlock(void);
 bool IsMemtracked(int, int);
 void PrintSystemMappings(int);
-unsigned __find_memory(const struct MemoryIntervals *, int) nosideeffect;
-bool __check_memtrack(const struct MemoryIntervals *) nosideeffect;
 void PrintMemoryIntervals(int, const struct MemoryIntervals *);
 int __track_memory(struct MemoryIntervals *, int, int, long, int, int, bool,
                    bool, long, long);
 int __untrack_memory(struct MemoryIntervals *, int, int,
-                     void (*)(struct MemoryIntervals *, int, int));
-void __release_memory_nt(struct MemoryIntervals *, int, int);
+                     void (*)(struct MemoryInterval *));
+void __rebuild_memory(struct MemoryIntervals *, struct MemoryInterval *,
+                      size_t);
+void __release_memory_nt(struct MemoryInterval *);
 int __untrack_memories(void *, size_t);
 size_t __get_memtrack_size(struct MemoryIntervals *) nosideeffect;
 
+/**
+ * Returns first interval that ends at or after frame `x`, or null.
+ */
+forceinline struct MemoryInterval *__find_memory(
+    const struct MemoryIntervals *mm, int x) {
+  int k;
+  struct MemoryInterval *e, *r = 0;
+  for (e = mm->root, k = 0; e && k < kMemtrackDepth; ++k) {
+    if (e->y < x) {
+      e = e->right;
+    } else {
+      r = e;
+      e = e->left;
+    }
+  }
+  return r;
+}
+
+forceinline struct MemoryInterval *__first_memory(
+    const struct MemoryIntervals *mm) {
+  int k;
+  struct MemoryInterval *e;
+  if ((e = mm->root))
+    for (k = 0; e->left && k < kMemtrackDepth; ++k)
+      e = e->left;
+  return e;
+}
+
+forceinline struct MemoryInterval *__last_memory(
+    const struct MemoryIntervals *mm) {
+  int k;
+  struct MemoryInterval *e;
+  if ((e = mm->root))
+    for (k = 0; e->right && k < kMemtrackDepth; ++k)
+      e = e->right;
+  return e;
+}
+
+/**
+ * Returns interval after `e` in order of address, or null.
+ */
+forceinline struct MemoryInterval *__next_memory(
+    const struct MemoryInterval *e) {
+  int k;
+  struct MemoryInterval *f;
+  if ((f = e->right)) {
+    for (k = 0; f->left && k < kMemtrackDepth; ++k)
+      f = f->left;
+    return f;
+  }
+  for (k = 0; (f = e->parent) && e == f->right && k < kMemtrackDepth; ++k)
+    e = f;
+  return f;
+}
+
+/**
+ * Returns interval before `e` in order of address, or null.
+ */
+forceinline struct MemoryInterval *__prev_memory(
+    const struct MemoryInterval *e) {
+  int k;
+  struct MemoryInterval *f;
+  if ((f = e->left)) {
+    for (k = 0; f->right && k < kMemtrackDepth; ++k)
+      f = f->right;
+    return f;
+  }
+  for (k = 0; (f = e->parent) && e == f->left && k < kMemtrackDepth; ++k)
+    e = f;
+  return f;
+}
+
+/**
+ * Starts reading intervals without holding __mmi_lock().
+ *
+ *     unsigned seq;
+ *     do {
+ *       seq = __memtrack_begin(&_mmi);
+ *       e = __find_memory(&_mmi, x);
+ *       ...
+ *     } while (__memtrack_retry(&_mmi, seq));
+ *
+ * Anything read between the two calls may be garbage if a writer was
+ * active, so it mustn't be acted upon until the retry check passes. A
+ * reader that might interrupt a writer on its own thread, e.g. from a
+ * crash handler, should give up after a few retries.
+ */
+forceinline unsigned __memtrack_begin(const struct MemoryIntervals *mm) {
+  return atomic_load_explicit(&mm->seq, memory_order_acquire);
+}
+
+forceinline bool __memtrack_retry(const struct MemoryIntervals *mm,
+                                  unsigned seq) {
+  atomic_thread_fence(memory_order_acquire);
+  return (seq & 1) ||
+         atomic_load_explicit(&mm->seq, memory_order_relaxed) != seq;
+}
+
 #ifdef __x86_64__
 /*
  * AMD64 has 48-bit signed pointers (PML4T)
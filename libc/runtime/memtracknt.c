@@ -30,10 +30,7 @@ static inline void *GetFrameAddr(int f) {
   return (void *)a;
 }
 
-void __release_memory_nt(struct MemoryIntervals *mm, int l, int r) {
-  int i;
-  for (i = l; i <= r; ++i) {
-    UnmapViewOfFile(GetFrameAddr(mm->p[i].x));
-    CloseHandle(mm->p[i].h);
-  }
+void __release_memory_nt(struct MemoryInterval *e) {
+  UnmapViewOfFile(GetFrameAddr(e->x));
+  CloseHandle(e->h);
 }
@@ -84,81 +84,107 @@ static wontreturn void __mmap_die(const char *s) {
 }
 
 static inline bool __overlaps_existing_mapping(char *p, size_t n) {
-  int a, b, i;
+  int a, b;
+  struct MemoryInterval *e;
   unassert(n > 0);
   a = FRAME(p);
   b = FRAME(p + (n - 1));
-  i = __find_memory(&_mmi, a);
-  if (i < _mmi.i) {
-    if (a <= _mmi.p[i].x && _mmi.p[i].x <= b)
+  if ((e = __find_memory(&_mmi, a))) {
+    if (a <= e->x && e->x <= b)
       return true;
-    if (a <= _mmi.p[i].y && _mmi.p[i].y <= b)
+    if (a <= e->y && e->y <= b)
       return true;
-    if (_mmi.p[i].x <= a && b <= _mmi.p[i].y)
+    if (e->x <= a && b <= e->y)
       return true;
   }
   return false;
 }
 
 static bool __choose_memory(int x, int n, int align, int *res) {
-  // TODO: improve performance
-  int i, start, end;
+  int lo, hole, start, end;
+  struct MemoryInterval *e, *p;
   unassert(align > 0);
+
+  // skip past the frames we found to be mapped last time. without this
+  // the search would visit every interval whenever maps are dense.
+  if (_mmi.hintlo <= x && x < _mmi.hint) {
+    lo = _mmi.hintlo;
+    x = _mmi.hint;
+  } else {
+    lo = x;
+  }
+  hole = INT_MAX;
+
   if (_mmi.i) {
 
     // find the start of the automap memory region
-    i = __find_memory(&_mmi, x);
-    if (i < _mmi.i) {
+    if ((e = __find_memory(&_mmi, x))) {
 
       // check to see if there's space available before the first entry
+      if (x < e->x)
+        hole = x;
       if (!ckd_add(&start, x, align - 1)) {
         start &= -align;
         if (!ckd_add(&end, start, n - 1)) {
-          if (end < _mmi.p[i].x) {
+          if (end < e->x) {
             *res = start;
-            return true;
+            goto Found;
           }
         }
       }
 
       // check to see if there's space available between two entries
-      while (++i < _mmi.i) {
-        if (!ckd_add(&start, _mmi.p[i - 1].y, 1) &&
-            !ckd_add(&start, start, align - 1)) {
+      for (p = e; (e = __next_memory(p)); p = e) {
+        if (hole == INT_MAX && p->y + 1 < e->x)
+          hole = p->y + 1;
+        if (!ckd_add(&start, p->y, 1) && !ckd_add(&start, start, align - 1)) {
           start &= -align;
           if (!ckd_add(&end, start, n - 1)) {
-            if (end < _mmi.p[i].x) {
+            if (end < e->x) {
               *res = start;
-              return true;
+              goto Found;
             }
           }
         }
       }
+    } else {
+      p = __last_memory(&_mmi);
     }
 
     // otherwise append after the last entry if space is available
-    if (!ckd_add(&start, _mmi.p[i - 1].y, 1) &&
+    if (hole == INT_MAX)
+      hole = MAX(x, p->y + 1);
+    if (!ckd_add(&start, p->y, 1) &&
         !ckd_add(&start, start, align - 1)) {
       start &= -align;
       if (!ckd_add(&end, start, n - 1)) {
         *res = start;
-        return true;
+        goto Found;
       }
     }
 
   } else {
     // if memtrack is empty, then just assign the requested address
     // assuming it doesn't overflow
+    hole = x;
     if (!ckd_add(&start, x, align - 1)) {
       start &= -align;
       if (!ckd_add(&end, start, n - 1)) {
         *res = start;
-        return true;
+        goto Found;
       }
     }
   }
 
   return false;
+
+Found:
+  // every frame from lo up to the first hole we saw is mapped
+  if (hole != INT_MAX) {
+    _mmi.hintlo = lo;
+    _mmi.hint = hole;
+  }
+  return true;
 }
 
 static bool __auto_map(int count, int align, int *res) {
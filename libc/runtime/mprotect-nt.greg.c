@@ -24,15 +24,16 @@
 
 textwindows int sys_mprotect_nt(void *addr, size_t size, int prot) {
   int rc = 0;
-  unsigned i;
   uint32_t op;
+  struct MemoryInterval *e;
   char *a, *b, *x, *y, *p;
   BLOCK_SIGNALS;
   __mmi_lock();
   size = (size + 4095) & -4096;
   p = addr;
-  i = __find_memory(&_mmi, (intptr_t)p >> 16);
-  if (i == _mmi.i || (!i && p + size <= (char *)ADDR_32_TO_48(_mmi.p[0].x))) {
+  e = __find_memory(&_mmi, (intptr_t)p >> 16);
+  if (!e || (e == __first_memory(&_mmi) &&
+             p + size <= (char *)ADDR_32_TO_48(e->x))) {
     // memory isn't in memtrack
     // let's just trust the user then
     // it's probably part of the executable
@@ -42,19 +43,19 @@ textwindows int sys_mprotect_nt(void *addr, size_t size, int prot) {
   } else {
     // memory is in memtrack, so use memtrack, to do dimensioning
     // we unfortunately must do something similar to this for cow
-    for (; i < _mmi.i; ++i) {
-      x = (char *)ADDR_32_TO_48(_mmi.p[i].x);
-      y = (char *)ADDR_32_TO_48(_mmi.p[i].y) + 65536;
+    for (; e; e = __next_memory(e)) {
+      x = (char *)ADDR_32_TO_48(e->x);
+      y = (char *)ADDR_32_TO_48(e->y) + 65536;
       if ((x <= p && p < y) || (x < p + size && p + size <= y) ||
           (p < x && y < p + size)) {
         if (p <= x && p + size >= y) {
-          _mmi.p[i].prot = prot;
+          e->prot = prot;
         } else {
-          _mmi.p[i].prot |= prot;
+          e->prot |= prot;
         }
         a = MIN(MAX(p, x), y);
         b = MAX(MIN(p + size, y), x);
-        if (!VirtualProtect(a, b - a, __prot2nt(prot, _mmi.p[i].iscow), &op)) {
+        if (!VirtualProtect(a, b - a, __prot2nt(prot, e->iscow), &op)) {
           rc = -1;
           break;
         }
@@ -26,12 +26,14 @@
 #include "libc/sysv/consts/prot.h"
 
 textwindows int sys_msync_nt(char *addr, size_t size, int flags) {
-  int i, rc = 0;
+  int rc = 0;
   char *a, *b, *x, *y;
+  struct MemoryInterval *e;
   __mmi_lock();
-  for (i = __find_memory(&_mmi, (intptr_t)addr >> 16); i < _mmi.i; ++i) {
-    x = (char *)ADDR_32_TO_48(_mmi.p[i].x);
-    y = x + _mmi.p[i].size;
+  for (e = __find_memory(&_mmi, (intptr_t)addr >> 16); e;
+       e = __next_memory(e)) {
+    x = (char *)ADDR_32_TO_48(e->x);
+    y = x + e->size;
     if ((x <= addr && addr < y) || (x < addr + size && addr + size <= y) ||
         (addr < x && y < addr + size)) {
       a = MIN(MAX(addr, x), y);
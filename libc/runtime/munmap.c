@@ -70,27 +70,28 @@ static void __munmap_impl(char *p, size_t n) {
   char *q;
   size_t m;
   intptr_t a, b, c;
-  int i, l, r, beg, end;
+  int l, r, beg, end;
+  struct MemoryInterval *e;
   KERNTRACE("__munmap_impl(%p, %'zu)", p, n);
   l = FRAME(p);
   r = FRAME(p + n - 1);
-  i = __find_memory(&_mmi, l);
-  for (; i < _mmi.i && r >= _mmi.p[i].x; ++i) {
-    if (l >= _mmi.p[i].x && r <= _mmi.p[i].y) {
+  e = __find_memory(&_mmi, l);
+  for (; e && r >= e->x; e = __next_memory(e)) {
+    if (l >= e->x && r <= e->y) {
 
       // it's contained within the entry
       beg = l;
       end = r;
-    } else if (l <= _mmi.p[i].x && r >= _mmi.p[i].x) {
+    } else if (l <= e->x && r >= e->x) {
 
       // it overlaps with the lefthand side of the entry
-      beg = _mmi.p[i].x;
-      end = MIN(r, _mmi.p[i].y);
-    } else if (l <= _mmi.p[i].y && r >= _mmi.p[i].y) {
+      beg = e->x;
+      end = MIN(r, e->y);
+    } else if (l <= e->y && r >= e->y) {
 
       // it overlaps with the righthand side of the entry
-      beg = MAX(_mmi.p[i].x, l);
-      end = _mmi.p[i].y;
+      beg = MAX(e->x, l);
+      end = e->y;
     } else {
       __builtin_unreachable();
     }
@@ -98,7 +99,7 @@ static void __munmap_impl(char *p, size_t n) {
     // file, that we be sure to call munmap(file, 5). let's abstract!
     a = ADDR_32_TO_48(beg);
     b = ADDR_32_TO_48(end) + FRAMESIZE;
-    c = ADDR_32_TO_48(_mmi.p[i].x) + _mmi.p[i].size;
+    c = ADDR_32_TO_48(e->x) + e->size;
     q = (char *)a;
     m = MIN(b, c) - a;
     if (!IsWindows()) {
@@ -181,12 +181,10 @@ static abi wontreturn void WinInit(const char16_t *cmdline) {
   }
 
   // allocate memory for stack and argument block
-  _mmi.p = _mmi.s;
-  _mmi.n = ARRAYLEN(_mmi.s);
   uintptr_t stackaddr = GetStaticStackAddr(0);
   size_t stacksize = GetStaticStackSize();
   __imp_MapViewOfFileEx(
-      (_mmi.p[0].h = __imp_CreateFileMappingW(
+      (_mmi.s[0].h = __imp_CreateFileMappingW(
            -1, 0, kNtPageExecuteReadwrite, stacksize >> 32, stacksize, NULL)),
       kNtFileMapWrite | kNtFileMapExecute, 0, 0, stacksize, (void *)stackaddr);
   int prot = (intptr_t)ape_stack_prot;
@@ -197,11 +195,14 @@ static abi wontreturn void WinInit(const char16_t *cmdline) {
   uint32_t oldattr;
   __imp_VirtualProtect((void *)stackaddr, GetGuardSize(),
                        kNtPageReadwrite | kNtPageGuard, &oldattr);
-  _mmi.p[0].x = stackaddr >> 16;
-  _mmi.p[0].y = (stackaddr >> 16) + ((stacksize - 1) >> 16);
-  _mmi.p[0].prot = prot;
-  _mmi.p[0].flags = 0x00000026;  // stack+anonymous
-  _mmi.p[0].size = stacksize;
+  _mmi.s[0].x = stackaddr >> 16;
+  _mmi.s[0].y = (stackaddr >> 16) + ((stacksize - 1) >> 16);
+  _mmi.s[0].prot = prot;
+  _mmi.s[0].flags = 0x00000026;  // stack+anonymous
+  _mmi.s[0].size = stacksize;
+  _mmi.s[0].height = 1;
+  _mmi.root = _mmi.s;
+  _mmi.n = 1;
   _mmi.i = 1;
   struct WinArgs *wa =
       (struct WinArgs *)(stackaddr + (stacksize - sizeof(struct WinArgs)));
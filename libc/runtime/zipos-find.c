@@ -40,6 +40,28 @@ static ssize_t __zipos_match(struct Zipos *z, struct ZiposUri *name, int len,
   }
 }
 
+/**
+ * Returns node for path, which mustn't have a trailing slash.
+ *
+ * @return node, or null if not found or the index couldn't be built
+ */
+struct ZiposNode *__zipos_lookup(struct Zipos *zipos, const char *path,
+                                 size_t len) {
+  uint32_t i, j, m;
+  struct ZiposNode *n;
+  if (!zipos->nodes)
+    return 0;
+  if (!len)
+    return zipos->nodes;
+  m = zipos->tablemask;
+  for (i = __fnv(path, len) & m; (j = zipos->table[i]); i = (i + 1) & m) {
+    n = zipos->nodes + j;
+    if (n->namelen == len && !memcmp(n->name, path, len))
+      return n;
+  }
+  return 0;
+}
+
 ssize_t __zipos_scan(struct Zipos *zipos, struct ZiposUri *name) {
 
   // strip trailing slash from search name
@@ -53,6 +75,16 @@ ssize_t __zipos_scan(struct Zipos *zipos, struct ZiposUri *name) {
     return ZIPOS_SYNTHETIC_DIRECTORY;
   }
 
+  // use hash table if one was built by __zipos_get()
+  if (zipos->nodes) {
+    struct ZiposNode *n;
+    if ((n = __zipos_lookup(zipos, name->path, len))) {
+      return n->cfile;
+    } else {
+      return -1;
+    }
+  }
+
   // binary search for leftmost name in central directory
   int l = 0;
   int r = zipos->records;
@@ -22,9 +22,11 @@
 #include "libc/calls/struct/stat.h"
 #include "libc/cosmo.h"
 #include "libc/fmt/conv.h"
+#include "libc/intrin/bsr.h"
 #include "libc/intrin/cmpxchg.h"
 #include "libc/intrin/promises.internal.h"
 #include "libc/intrin/strace.internal.h"
+#include "libc/limits.h"
 #include "libc/macros.internal.h"
 #include "libc/mem/alg.h"
 #include "libc/runtime/runtime.h"
@@ -105,6 +107,72 @@ static void __zipos_generate_index(struct Zipos *zipos) {
                __zipos_compare_names, zipos);
 }
 
+// adds node for path unless it exists, and returns its index
+static uint32_t __zipos_intern(struct Zipos *zipos, uint32_t *count,
+                               uint32_t parent, const char *name, size_t len) {
+  uint32_t i, j, m;
+  struct ZiposNode *n;
+  m = zipos->tablemask;
+  for (i = __fnv(name, len) & m; (j = zipos->table[i]); i = (i + 1) & m) {
+    n = zipos->nodes + j;
+    if (n->namelen == len && !memcmp(n->name, name, len))
+      return j;
+  }
+  j = (*count)++;
+  zipos->table[i] = j;
+  n = zipos->nodes + j;
+  n->name = name;
+  n->namelen = len;
+  n->sibling = zipos->nodes[parent].child;
+  zipos->nodes[parent].child = j;
+  return j;
+}
+
+// creates hash table of paths and tree of directories, which includes
+// the parent directories of files that don't have their own records.
+// the index is walked backwards so that children get listed in order,
+// and so the leftmost of any duplicate names wins like __zipos_scan()
+static void __zipos_generate_tree(struct Zipos *zipos) {
+  const char *name;
+  size_t c, i, j, k, len, max, cap;
+  uint32_t count, parent;
+  for (max = 1, i = 0; i < zipos->records; ++i) {
+    c = zipos->index[i];
+    name = ZIP_CFILE_NAME(zipos->map + c);
+    len = ZIP_CFILE_NAMESIZE(zipos->map + c);
+    for (max += 1, j = 0; j < len; ++j)
+      max += name[j] == '/';
+  }
+  cap = 4ul << bsrl(max);  // keep load factor under 50%
+  if (max > UINT32_MAX / 2 ||
+      !(zipos->nodes = _mapanon(max * sizeof(struct ZiposNode))))
+    return;
+  if (!(zipos->table = _mapanon(cap * sizeof(uint32_t)))) {
+    munmap(zipos->nodes, max * sizeof(struct ZiposNode));
+    zipos->nodes = 0;
+    return;
+  }
+  zipos->tablemask = cap - 1;
+  zipos->nodes[0].name = "";
+  count = 1;
+  for (i = zipos->records; i--;) {
+    c = zipos->index[i];
+    name = ZIP_CFILE_NAME(zipos->map + c);
+    len = ZIP_CFILE_NAMESIZE(zipos->map + c);
+    if (len && name[len - 1] == '/')
+      --len;
+    for (parent = k = j = 0; j <= len; ++j) {
+      if (j < len && name[j] != '/')
+        continue;
+      if (j > k)
+        parent = __zipos_intern(zipos, &count, parent, name, j);
+      k = j + 1;
+    }
+    if (parent && len == zipos->nodes[parent].namelen)
+      zipos->nodes[parent].cfile = c;
+  }
+}
+
 static void __zipos_init(void) {
   char *endptr;
   const char *s;
@@ -138,6 +206,7 @@ static void __zipos_init(void) {
             __zipos.dev = st.st_ino;
             __zipos.pagesz = pagesz;
             __zipos_generate_index(&__zipos);
+            __zipos_generate_tree(&__zipos);
             msg = kZipOk;
           } else {
             munmap(map, st.st_size);
@@ -0,0 +1,261 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/errno.h"
+#include "libc/intrin/weaken.h"
+#include "libc/macros.internal.h"
+#include "libc/runtime/internal.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/thread/thread.h"
+#include "libc/zip.internal.h"
+#include "third_party/zlib/zlib.h"
+
+// large deflated files are inflated as they're being read, into a ring
+// of recent output that's just big enough to also serve as the history
+// deflate needs to resume. as the stream advances, a few checkpoints are
+// saved at block boundaries, so seeking backwards doesn't have to start
+// over from the beginning of the file. this uses zlib's inflatePrime()
+// trick from examples/zran.c, and it's only possible when zlib is linked.
+// if zipobj recorded full flush points then those are used instead, as
+// inflating can start at one of those without needing any history
+
+#define ZIPOS_WINDOW      32768
+#define ZIPOS_BUFFER      (4 * ZIPOS_WINDOW)
+#define ZIPOS_CHECKPOINTS 8
+#define ZIPOS_SPAN_MIN    1048576
+
+struct ZiposCheckpoint {
+  size_t out;    // uncompressed offset of block boundary
+  size_t in;     // compressed offset of first whole byte after it
+  int bits;      // bits from byte at in-1 which belong to next block
+  size_t wsize;  // bytes of history in window
+  uint8_t window[ZIPOS_WINDOW];
+};
+
+struct ZiposStream {
+  pthread_mutex_t lock;
+  z_stream zs;
+  const uint8_t *in;
+  size_t insize;
+  size_t size;  // uncompressed size
+  size_t span;  // uncompressed distance between checkpoints
+  size_t beg;   // uncompressed offset of buf[0]
+  size_t fill;  // number of valid bytes in buf
+  size_t mapsize;
+  uint32_t fspan;          // uncompressed distance between flush points
+  size_t fcount;           // number of flush points
+  const uint8_t *fpoints;  // from GetZipCfileFlushPoints()
+  int checkpoints;
+  struct ZiposCheckpoint ck[ZIPOS_CHECKPOINTS];
+  uint8_t buf[ZIPOS_BUFFER];
+};
+
+static bool __zipos_stream_linked(void) {
+  return _weaken(inflateInit2) &&          //
+         _weaken(inflate) &&               //
+         _weaken(inflateEnd) &&            //
+         _weaken(inflateReset) &&          //
+         _weaken(inflatePrime) &&          //
+         _weaken(inflateSetDictionary) &&  //
+         __runlevel >= RUNLEVEL_MALLOC;
+}
+
+/**
+ * Prepares to inflate deflated zip content on demand.
+ *
+ * @param in is raw deflate data, which must stay mapped
+ * @param size is uncompressed size from the zip headers
+ * @param cfile is central directory header, which may have flush
+ *     points that help seeking, or null if it's not known
+ * @return new stream, or null if zlib isn't linked or memory's short
+ */
+struct ZiposStream *__zipos_stream_open(const void *in, size_t insize,
+                                        size_t size, const uint8_t *cfile) {
+  size_t mapsize;
+  struct ZiposStream *s;
+  if (!__zipos_stream_linked())
+    return 0;
+  mapsize = ROUNDUP(sizeof(struct ZiposStream), 4096);
+  if (!(s = _mapanon(mapsize)))
+    return 0;
+  s->mapsize = mapsize;
+  s->in = in;
+  s->insize = insize;
+  s->size = size;
+  s->span = MAX(size / (ZIPOS_CHECKPOINTS + 1), ZIPOS_SPAN_MIN);
+  if (cfile)
+    s->fpoints = GetZipCfileFlushPoints(cfile, &s->fspan, &s->fcount);
+  s->zs.next_in = (uint8_t *)in;
+  s->zs.avail_in = insize;
+  s->zs.zalloc = Z_NULL;
+  s->zs.zfree = Z_NULL;
+  if (_weaken(inflateInit2)(&s->zs, -MAX_WBITS) != Z_OK) {
+    munmap(s, mapsize);
+    return 0;
+  }
+  pthread_mutex_init(&s->lock, 0);
+  return s;
+}
+
+/**
+ * Releases memory held by stream.
+ */
+void __zipos_stream_close(struct ZiposStream *s) {
+  _weaken(inflateEnd)(&s->zs);
+  pthread_mutex_destroy(&s->lock);
+  munmap(s, s->mapsize);
+}
+
+// returns latest checkpoint at or before `pos`, or null if none
+static struct ZiposCheckpoint *__zipos_stream_nearest(struct ZiposStream *s,
+                                                      size_t pos) {
+  int i;
+  for (i = s->checkpoints; i--;)
+    if (s->ck[i].out <= pos)
+      return s->ck + i;
+  return 0;
+}
+
+// returns index of latest flush point at or before `pos`, or zero
+static size_t __zipos_stream_flush(struct ZiposStream *s, size_t pos) {
+  if (!s->fpoints)
+    return 0;
+  return MIN(pos / s->fspan, s->fcount);
+}
+
+// returns uncompressed offset where inflating could resume for `pos`
+static size_t __zipos_stream_resume(struct ZiposStream *s, size_t pos) {
+  struct ZiposCheckpoint *ck;
+  if ((ck = __zipos_stream_nearest(s, pos)))
+    return MAX(ck->out, __zipos_stream_flush(s, pos) * s->fspan);
+  return __zipos_stream_flush(s, pos) * s->fspan;
+}
+
+// restarts decompression at the last checkpoint before `pos`
+static int __zipos_stream_rewind(struct ZiposStream *s, size_t pos) {
+  size_t k;
+  struct ZiposCheckpoint *ck;
+  if (_weaken(inflateReset)(&s->zs) != Z_OK)
+    return eio();
+  s->fill = 0;
+  ck = __zipos_stream_nearest(s, pos);
+  if ((k = __zipos_stream_flush(s, pos)) && (!ck || k * s->fspan >= ck->out)) {
+    s->beg = k * s->fspan;
+    s->zs.next_in = (uint8_t *)s->in + READ32LE(s->fpoints + (k - 1) * 4);
+    s->zs.avail_in = s->insize - READ32LE(s->fpoints + (k - 1) * 4);
+  } else if (ck) {
+    s->beg = ck->out;
+    s->zs.next_in = (uint8_t *)s->in + ck->in;
+    s->zs.avail_in = s->insize - ck->in;
+    if ((ck->bits && _weaken(inflatePrime)(&s->zs, ck->bits,
+                                           s->in[ck->in - 1] >>
+                                               (8 - ck->bits)) != Z_OK) ||
+        _weaken(inflateSetDictionary)(&s->zs, ck->window, ck->wsize) !=
+            Z_OK) {
+      return eio();
+    }
+  } else {
+    s->beg = 0;
+    s->zs.next_in = (uint8_t *)s->in;
+    s->zs.avail_in = s->insize;
+  }
+  return 0;
+}
+
+// remembers where we are if we're at a good place for a checkpoint
+static void __zipos_stream_save(struct ZiposStream *s) {
+  size_t out;
+  struct ZiposCheckpoint *ck;
+  if (s->fpoints || s->checkpoints == ZIPOS_CHECKPOINTS)
+    return;
+  if (!(s->zs.data_type & 128) || (s->zs.data_type & 64))
+    return;  // not at block boundary, or final block is done
+  out = s->beg + s->fill;
+  if (out < (s->checkpoints + 1) * s->span)
+    return;
+  if (s->beg && s->fill < ZIPOS_WINDOW)
+    return;  // not enough history since last rewind
+  ck = s->ck + s->checkpoints++;
+  ck->out = out;
+  ck->in = s->zs.next_in - s->in;
+  ck->bits = s->zs.data_type & 7;
+  ck->wsize = MIN(s->fill, ZIPOS_WINDOW);
+  memcpy(ck->window, s->buf + s->fill - ck->wsize, ck->wsize);
+}
+
+// inflates some more output into buffer
+static int __zipos_stream_advance(struct ZiposStream *s) {
+  int rc;
+  if (s->fill == ZIPOS_BUFFER) {
+    memmove(s->buf, s->buf + ZIPOS_BUFFER - ZIPOS_WINDOW, ZIPOS_WINDOW);
+    s->beg += ZIPOS_BUFFER - ZIPOS_WINDOW;
+    s->fill = ZIPOS_WINDOW;
+  }
+  s->zs.next_out = s->buf + s->fill;
+  s->zs.avail_out = ZIPOS_BUFFER - s->fill;
+  rc = _weaken(inflate)(&s->zs, Z_BLOCK);
+  s->fill = s->zs.next_out - s->buf;
+  if (rc == Z_OK) {
+    __zipos_stream_save(s);
+    return 0;
+  } else if (rc == Z_STREAM_END && s->beg + s->fill == s->size) {
+    return 0;
+  } else {
+    return eio();
+  }
+}
+
+/**
+ * Reads uncompressed content from deflated zip file.
+ *
+ * @return bytes copied, which is only less than `n` at end of file,
+ *     otherwise -1 w/ errno if the content turned out to be corrupt
+ */
+ssize_t __zipos_stream_pread(struct ZiposStream *s, void *p, size_t n,
+                             size_t off) {
+  ssize_t rc;
+  size_t got, pos, end, amt;
+  if (off >= s->size)
+    return 0;
+  n = MIN(n, s->size - off);
+  pthread_mutex_lock(&s->lock);
+  for (rc = got = 0; got < n;) {
+    pos = off + got;
+    end = s->beg + s->fill;
+    if (pos < s->beg || (pos >= end && __zipos_stream_resume(s, pos) > end)) {
+      if ((rc = __zipos_stream_rewind(s, pos)) == -1)
+        break;
+    } else if (pos < end) {
+      amt = MIN(n - got, end - pos);
+      memcpy((char *)p + got, s->buf + (pos - s->beg), amt);
+      got += amt;
+    } else if (end == s->size) {
+      rc = eio();
+      break;
+    } else if ((rc = __zipos_stream_advance(s)) == -1) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&s->lock);
+  return rc == -1 ? -1 : got;
+}
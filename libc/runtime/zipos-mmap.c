@@ -40,10 +40,11 @@
  * @param size must be >0 and will be rounded up to FRAMESIZE
  *     automatically.
  * @param prot can have PROT_READ/PROT_WRITE/PROT_EXEC/PROT_NONE/etc.
- * @param flags cannot have `MAP_SHARED` or `MAP_ANONYMOUS`, there is
- *     no actual file backing for zipos files. `MAP_SHARED` could be
- *     simulated for non-writable mappings, but that would require
- *     tracking zipos mappings to prevent making it PROT_WRITE.
+ * @param flags cannot have `MAP_ANONYMOUS`, there is no actual file
+ *     backing for zipos files. `MAP_SHARED` is only allowed without
+ *     `PROT_WRITE`, in which case it's simulated with a private copy,
+ *     since zipos content never changes. Calling mprotect() later to
+ *     make such a mapping writable won't share the changes.
  * @param h is a zip store object
  * @param off specifies absolute byte index of h's file for mapping,
  *     it does not need to be 64kb aligned.
@@ -62,7 +63,8 @@ void *__zipos_mmap(void *addr, size_t size, int prot, int flags,
     return VIP(eisdir());
   }
 
-  if (flags & (MAP_SHARED | MAP_ANONYMOUS)) {
+  if ((flags & MAP_ANONYMOUS) ||
+      ((flags & MAP_SHARED) && (prot & PROT_WRITE))) {
     STRACE("ZipOS bad flags");
     return VIP(einval());
   }
@@ -53,10 +53,25 @@
 
 #define MAX_REFS SSIZE_MAX
 
+#define CACHE_SLOTS 64
+
 static char *__zipos_mapend;
 static size_t __zipos_maptotal;
 static pthread_mutex_t __zipos_lock_obj;
 
+// inflated content of recently opened files, which is shared between
+// handles since it's immutable. each slot holds one reference to its
+// handle, and cached content lives until the last handle is dropped.
+static struct ZiposCache {
+  size_t bytes;
+  unsigned tick;
+  struct ZiposCacheSlot {
+    size_t cfile;
+    unsigned tick;
+    struct ZiposHandle *h;
+  } slot[CACHE_SLOTS];
+} __zipos_cache;
+
 static void __zipos_wipe(void) {
   pthread_mutex_init(&__zipos_lock_obj, 0);
 }
@@ -94,6 +109,14 @@ void __zipos_drop(struct ZiposHandle *h) {
     return;
   }
   atomic_thread_fence(memory_order_acquire);
+  if (h->stream) {
+    __zipos_stream_close(h->stream);
+    h->stream = 0;
+  }
+  if (h->base) {
+    __zipos_drop(h->base);
+    h->base = 0;
+  }
   if (IsAsan()) {
     __asan_poison((char *)h + sizeof(struct ZiposHandle),
                   h->mapsize - sizeof(struct ZiposHandle), kAsanHeapFree);
@@ -136,10 +159,100 @@ StartOver:
     h->size = size;
     h->zipos = zipos;
     h->mapsize = mapsize;
+    h->base = 0;
+    h->stream = 0;
+  }
+  return h;
+}
+
+// inflates file content, which for big files in threaded programs may
+// happen on several threads, if zipobj recorded flush points
+static int __zipos_inflate(struct Zipos *zipos, size_t cf, size_t lf,
+                           void *out, size_t size) {
+  size_t count;
+  uint32_t span;
+  const uint8_t *points;
+  if ((points = GetZipCfileFlushPoints(zipos->map + cf, &span, &count)))
+    return __inflate_segments(out, size, ZIP_LFILE_CONTENT(zipos->map + lf),
+                              GetZipLfileCompressedSize(zipos->map + lf), span,
+                              points, count);
+  return __inflate(out, size, ZIP_LFILE_CONTENT(zipos->map + lf),
+                   GetZipLfileCompressedSize(zipos->map + lf));
+}
+
+static struct ZiposHandle *__zipos_cache_get(size_t cf) {
+  int i;
+  struct ZiposHandle *h = 0;
+  __zipos_lock();
+  for (i = 0; i < CACHE_SLOTS; ++i) {
+    if (__zipos_cache.slot[i].h && __zipos_cache.slot[i].cfile == cf) {
+      __zipos_cache.slot[i].tick = ++__zipos_cache.tick;
+      h = __zipos_keep(__zipos_cache.slot[i].h);
+      break;
+    }
+  }
+  __zipos_unlock();
+  return h;
+}
+
+// adds handle to cache, unless another thread got there first
+static struct ZiposHandle *__zipos_cache_put(struct ZiposHandle *h) {
+  int i, j, e, n = 0;
+  struct ZiposHandle *evicted[CACHE_SLOTS];
+  __zipos_lock();
+  for (i = 0; i < CACHE_SLOTS; ++i) {
+    if (__zipos_cache.slot[i].h && __zipos_cache.slot[i].cfile == h->cfile) {
+      evicted[n++] = h;
+      h = __zipos_cache.slot[i].h;
+      goto Finish;
+    }
   }
+  for (;;) {
+    for (e = j = -1, i = 0; i < CACHE_SLOTS; ++i) {
+      if (!__zipos_cache.slot[i].h) {
+        e = i;
+      } else if (j == -1 ||
+                 __zipos_cache.slot[i].tick < __zipos_cache.slot[j].tick) {
+        j = i;
+      }
+    }
+    if (e != -1 && __zipos_cache.bytes + h->size <= ZIPOS_CACHE_MAX)
+      break;
+    evicted[n++] = __zipos_cache.slot[j].h;
+    __zipos_cache.bytes -= __zipos_cache.slot[j].h->size;
+    __zipos_cache.slot[j].h = 0;
+  }
+  __zipos_cache.bytes += h->size;
+  __zipos_cache.slot[e].h = h;
+  __zipos_cache.slot[e].cfile = h->cfile;
+  __zipos_cache.slot[e].tick = ++__zipos_cache.tick;
+Finish:
+  __zipos_keep(h);
+  __zipos_unlock();
+  for (i = 0; i < n; ++i)
+    __zipos_drop(evicted[i]);
   return h;
 }
 
+// returns reference to shared handle holding inflated file content
+static struct ZiposHandle *__zipos_inflate_shared(struct Zipos *zipos,
+                                                  size_t cf, size_t lf,
+                                                  size_t size) {
+  struct ZiposHandle *h;
+  if ((h = __zipos_cache_get(cf)))
+    return h;
+  if (!(h = __zipos_alloc(zipos, size)))
+    return 0;
+  if (__zipos_inflate(zipos, cf, lf, h->data, size)) {
+    __zipos_drop(h);
+    eio();
+    return 0;
+  }
+  h->cfile = cf;
+  h->mem = h->data;
+  return __zipos_cache_put(h);
+}
+
 static int __zipos_mkfd(int minfd) {
   int fd, e = errno;
   if ((fd = __sys_fcntl(2, F_DUPFD_CLOEXEC, minfd)) != -1) {
@@ -168,7 +281,8 @@ static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
   size_t lf;
   size_t size;
   int fd, minfd;
-  struct ZiposHandle *h;
+  struct ZiposHandle *h, *b;
+  struct ZiposStream *s;
   if (cf == ZIPOS_SYNTHETIC_DIRECTORY) {
     size = name->len;
     if (!(h = __zipos_alloc(zipos, size + 1)))
@@ -188,10 +302,33 @@ static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
         h->mem = ZIP_LFILE_CONTENT(zipos->map + lf);
         break;
       case kZipCompressionDeflate:
+        if (size >= ZIPOS_LAZY_MIN &&
+            (s = __zipos_stream_open(
+                 ZIP_LFILE_CONTENT(zipos->map + lf),
+                 GetZipLfileCompressedSize(zipos->map + lf), size,
+                 zipos->map + cf))) {
+          if (!(h = __zipos_alloc(zipos, 0))) {
+            __zipos_stream_close(s);
+            return -1;
+          }
+          h->mem = 0;
+          h->stream = s;
+          break;
+        }
+        if (size <= ZIPOS_CACHE_MAX / 4) {
+          if (!(b = __zipos_inflate_shared(zipos, cf, lf, size)))
+            return -1;
+          if (!(h = __zipos_alloc(zipos, 0))) {
+            __zipos_drop(b);
+            return -1;
+          }
+          h->base = b;
+          h->mem = b->data;
+          break;
+        }
         if (!(h = __zipos_alloc(zipos, size)))
           return -1;
-        if (!__inflate(h->data, size, ZIP_LFILE_CONTENT(zipos->map + lf),
-                       GetZipLfileCompressedSize(zipos->map + lf))) {
+        if (!__zipos_inflate(zipos, cf, lf, h->data, size)) {
           h->mem = h->data;
         } else {
           h->mem = 0;
@@ -206,7 +343,7 @@ static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
   h->cfile = cf;
   unassert(size < SIZE_MAX);
   h->size = size;
-  if (h->mem) {
+  if (h->mem || h->stream) {
     minfd = 3;
     __fds_lock();
   TryAgain:
@@ -32,6 +32,7 @@
 static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
                                  size_t iovlen, ssize_t opt_offset) {
   int i;
+  bool err = false;
   int64_t b, x, y, start_pos;
   if (h->cfile == ZIPOS_SYNTHETIC_DIRECTORY ||
       S_ISDIR(GetZipCfileMode(h->zipos->map + h->cfile))) {
@@ -53,14 +54,22 @@ static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
   }
   for (i = 0; i < iovlen && y < h->size; ++i, y += b) {
     b = MIN(iov[i].iov_len, h->size - y);
-    if (b)
+    if (!b)
+      continue;
+    if (h->stream) {
+      if ((b = __zipos_stream_pread(h->stream, iov[i].iov_base, b, y)) == -1) {
+        err = y == x;
+        break;
+      }
+    } else {
       memcpy(iov[i].iov_base, h->mem + y, b);
+    }
   }
   if (opt_offset == -1) {
     unassert(y != SIZE_MAX);
     atomic_store_explicit(&h->pos, y, memory_order_release);
   }
-  return y - x;
+  return err ? -1 : y - x;
 }
 
 /**
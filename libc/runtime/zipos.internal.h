@@ -6,9 +6,13 @@ COSMOPOLITAN_C_START_
 
 #define ZIPOS_SYNTHETIC_DIRECTORY 0
 
+#define ZIPOS_LAZY_MIN 1048576 /* smaller files get inflated by open() */
+#define ZIPOS_CACHE_MAX 8388608 /* bytes of inflated files kept by open() */
+
 struct stat;
 struct iovec;
 struct Zipos;
+struct ZiposStream;
 
 struct ZiposUri {
   uint32_t len;
@@ -24,9 +28,19 @@ struct ZiposHandle {
   _Atomic(size_t) refs;
   _Atomic(size_t) pos;
   uint8_t *mem;
+  struct ZiposHandle *base; /* shared handle holding inflated content */
+  struct ZiposStream *stream;
   uint8_t data[];
 };
 
+struct ZiposNode {
+  size_t cfile;      /* or ZIPOS_SYNTHETIC_DIRECTORY */
+  const char *name;  /* full path w/o trailing slash, not nul terminated */
+  uint32_t namelen;
+  uint32_t child;    /* first child node, or 0 if none */
+  uint32_t sibling;  /* next node in same directory, or 0 if none */
+};
+
 struct Zipos {
   long pagesz;
   uint8_t *map;
@@ -34,6 +48,9 @@ struct Zipos {
   uint64_t dev;
   size_t *index;
   size_t records;
+  struct ZiposNode *nodes; /* node 0 is the root directory */
+  uint32_t *table;         /* hash table of nodes by name */
+  uint32_t tablemask;
   struct ZiposHandle *freelist;
 };
 
@@ -44,6 +61,7 @@ struct Zipos *__zipos_get(void) pureconst;
 size_t __zipos_normpath(char *, const char *, size_t);
 ssize_t __zipos_find(struct Zipos *, struct ZiposUri *);
 ssize_t __zipos_scan(struct Zipos *, struct ZiposUri *);
+struct ZiposNode *__zipos_lookup(struct Zipos *, const char *, size_t);
 ssize_t __zipos_parseuri(const char *, struct ZiposUri *);
 uint64_t __zipos_inode(struct Zipos *, int64_t, const void *, size_t);
 int __zipos_open(struct ZiposUri *, int);
@@ -57,6 +75,10 @@ ssize_t __zipos_read(struct ZiposHandle *, const struct iovec *, size_t,
 int64_t __zipos_seek(struct ZiposHandle *, int64_t, unsigned);
 int __zipos_fcntl(int, int, uintptr_t);
 int __zipos_notat(int, const char *);
+struct ZiposStream *__zipos_stream_open(const void *, size_t, size_t,
+                                        const uint8_t *);
+ssize_t __zipos_stream_pread(struct ZiposStream *, void *, size_t, size_t);
+void __zipos_stream_close(struct ZiposStream *);
 void *__zipos_mmap(void *, uint64_t, int32_t, int32_t, struct ZiposHandle *,
                    int64_t);
 
@@ -81,6 +81,8 @@ struct dirstream {
       uint64_t inode;
       uint64_t offset;
       uint64_t records;
+      struct ZiposNode *node;
+      uint32_t next;
       struct ZiposUri prefix;
       struct critbit0 found;
     } zip;
@@ -348,6 +350,10 @@ DIR *fdopendir(int fd) {
   dir->zip.records = GetZipCdirRecords(h->zipos->cdir);
   dir->zip.inode = __zipos_inode(h->zipos, h->cfile, dir->zip.prefix.path,
                                  dir->zip.prefix.len);
+  if ((dir->zip.node = __zipos_lookup(h->zipos, dir->zip.prefix.path,
+                                      len ? len - 1 : 0))) {
+    dir->zip.next = dir->zip.node->child;
+  }
 
   return dir;
 }
@@ -417,6 +423,26 @@ static struct dirent *readdir_zipos(DIR *dir) {
       p.path[p.len] = 0;
       ent->d_ino = __zipos_inode(
           dir->zip.zipos, __zipos_scan(dir->zip.zipos, &p), p.path, p.len);
+    } else if (dir->zip.node) {
+      // list children using index built by __zipos_get()
+      struct ZiposNode *c;
+      if (!dir->zip.next)
+        break;
+      c = dir->zip.zipos->nodes + dir->zip.next;
+      dir->zip.next = c->sibling;
+      size_t n = c->namelen - dir->zip.prefix.len;
+      ent = &dir->ent;
+      ent->d_ino = __zipos_inode(dir->zip.zipos, c->cfile, c->name, c->namelen);
+      ent->d_off = dir->tell;
+      if (c->cfile == ZIPOS_SYNTHETIC_DIRECTORY ||
+          S_ISDIR(GetZipCfileMode(dir->zip.zipos->map + c->cfile))) {
+        ent->d_type = DT_DIR;
+      } else {
+        ent->d_type = DT_REG;
+      }
+      n = MIN(n, sizeof(ent->d_name) - 1);
+      memcpy(ent->d_name, c->name + dir->zip.prefix.len, n);
+      ent->d_name[n] = 0;
     } else {
       const char *s = ZIP_CFILE_NAME(dir->zip.zipos->map + dir->zip.offset);
       size_t n = ZIP_CFILE_NAMESIZE(dir->zip.zipos->map + dir->zip.offset);
@@ -633,6 +659,8 @@ void rewinddir(DIR *dir) {
     critbit0_clear(&dir->zip.found);
     dir->tell = 0;
     dir->zip.offset = GetZipCdirOffset(dir->zip.zipos->cdir);
+    if (dir->zip.node)
+      dir->zip.next = dir->zip.node->child;
   } else if (!IsWindows()) {
     if (!lseek(dir->fd, 0, SEEK_SET)) {
       dir->buf_pos = dir->buf_end = 0;
@@ -659,6 +687,8 @@ void seekdir(DIR *dir, long tell) {
     critbit0_clear(&dir->zip.found);
     dir->tell = 0;
     dir->zip.offset = GetZipCdirOffset(dir->zip.zipos->cdir);
+    if (dir->zip.node)
+      dir->zip.next = dir->zip.node->child;
     while (dir->tell < tell) {
       if (!readdir_zipos(dir)) {
         break;
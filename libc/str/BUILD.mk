@@ -44,6 +44,17 @@ $(LIBC_STR_A).pkg:						\
 		$(LIBC_STR_A_OBJS)				\
 		$(foreach x,$(LIBC_STR_A_DIRECTDEPS),$($(x)_A).pkg)
 
+# the neon code includes headers from third_party/aarch64, which is a
+# header-only package, so it has no .pkg that DIRECTDEPS could name
+ifeq ($(ARCH), aarch64)
+o/$(MODE)/libc/str/memcasecmp.o					\
+o/$(MODE)/libc/str/memmem.o					\
+o/$(MODE)/libc/str/strcasestr.o					\
+o/$(MODE)/libc/str/strspnvec.o					\
+o/$(MODE)/libc/str/strstr.o:					\
+		$(THIRD_PARTY_AARCH64_HDRS)
+endif
+
 o/$(MODE)/libc/str/wow.o: private				\
 		CC = gcc
 
@@ -0,0 +1,68 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/zip.internal.h"
+
+/**
+ * Returns deflate full flush points recorded by zipobj, if any.
+ *
+ * Content that was compressed with a full flush every `span` bytes of
+ * input can be inflated starting at any of these points, so it may be
+ * decompressed in parallel, or read starting in the middle.
+ *
+ * @param z points to central directory file header
+ * @param out_span receives distance between points in uncompressed bytes
+ * @param out_count receives number of points, which is the number of
+ *     segments minus one, since the first segment starts at zero
+ * @return array of 32-bit little endian compressed content offsets for
+ *     segments one and onward, or null if absent or inconsistent
+ */
+const uint8_t *GetZipCfileFlushPoints(const uint8_t *z, uint32_t *out_span,
+                                      size_t *out_count) {
+  size_t i, n;
+  uint32_t span;
+  int64_t insize, outsize, last;
+  const uint8_t *p, *pe, *points;
+  if (ZIP_CFILE_COMPRESSIONMETHOD(z) != kZipCompressionDeflate)
+    return 0;
+  p = ZIP_CFILE_EXTRA(z);
+  pe = p + ZIP_CFILE_EXTRASIZE(z);
+  for (; p + ZIP_EXTRA_SIZE(p) <= pe; p += ZIP_EXTRA_SIZE(p)) {
+    if (ZIP_EXTRA_HEADERID(p) != kZipExtraFlushPoints ||
+        ZIP_EXTRA_CONTENTSIZE(p) < 4 || (ZIP_EXTRA_CONTENTSIZE(p) & 3))
+      continue;
+    span = ZIP_READ32(ZIP_EXTRA_CONTENT(p));
+    n = ZIP_EXTRA_CONTENTSIZE(p) / 4 - 1;
+    points = ZIP_EXTRA_CONTENT(p) + 4;
+    insize = GetZipCfileCompressedSize(z);
+    outsize = GetZipCfileUncompressedSize(z);
+    if (!span || !n || outsize <= (int64_t)n * span ||
+        outsize > (int64_t)(n + 1) * span)
+      return 0;
+    for (last = i = 0; i < n; ++i) {
+      if (ZIP_READ32(points + i * 4) <= last ||
+          ZIP_READ32(points + i * 4) >= insize)
+        return 0;
+      last = ZIP_READ32(points + i * 4);
+    }
+    *out_span = span;
+    *out_count = n;
+    return points;
+  }
+  return 0;
+}
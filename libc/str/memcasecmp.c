@@ -16,9 +16,88 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/serialize.h"
 #include "libc/str/str.h"
 #include "libc/str/tab.internal.h"
+#ifdef __aarch64__
+#include "third_party/aarch64/arm_neon.internal.h"
+#endif
+
+static int memcasecmp_pure(const unsigned char *a, const unsigned char *b,
+                           size_t n) {
+  int c;
+  size_t i;
+  unsigned u;
+  uint64_t w;
+  for (i = 0; i < n; ++i) {
+    while (i + 8 <= n) {
+      if ((w = (READ64LE(a + i) ^ READ64LE(b + i)))) {
+        u = __builtin_ctzll(w);
+        i += u >> 3;
+        break;
+      } else {
+        i += 8;
+      }
+    }
+    if (i == n) {
+      break;
+    } else if ((c = kToLower[a[i]] - kToLower[b[i]])) {
+      return c;
+    }
+  }
+  return 0;
+}
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+typedef unsigned char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef char ymm_s __attribute__((__vector_size__(32), __aligned__(1)));
+
+_Microarchitecture("avx2") static int memcasecmp_avx2(const unsigned char *a,
+                                                      const unsigned char *b,
+                                                      size_t n) {
+  size_t i;
+  unsigned m;
+  ymm_t x, y;
+  for (i = 0; i + 32 <= n; i += 32) {
+    x = *(const ymm_t *)(a + i);
+    y = *(const ymm_t *)(b + i);
+    x |= (ymm_t)(x - 'A' < 26) & 32;
+    y |= (ymm_t)(y - 'A' < 26) & 32;
+    if ((m = ~__builtin_ia32_pmovmskb256((ymm_s)(x == y)))) {
+      i += __builtin_ctz(m);
+      return kToLower[a[i]] - kToLower[b[i]];
+    }
+  }
+  return memcasecmp_pure(a + i, b + i, n - i);
+}
+#endif
+
+#ifdef __aarch64__
+static uint8x16_t memcasecmp_lower(uint8x16_t x) {
+  uint8x16_t t = vcltq_u8(vsubq_u8(x, vdupq_n_u8('A')), vdupq_n_u8(26));
+  return vorrq_u8(x, vandq_u8(t, vdupq_n_u8(32)));
+}
+
+static int memcasecmp_neon(const unsigned char *a, const unsigned char *b,
+                           size_t n) {
+  size_t i;
+  uint64_t m;
+  uint8x16_t t;
+  for (i = 0; i + 16 <= n; i += 16) {
+    t = vceqq_u8(memcasecmp_lower(vld1q_u8(a + i)),
+                 memcasecmp_lower(vld1q_u8(b + i)));
+    // narrow each byte of the mask to a nibble, since there's no pmovmskb
+    m = ~vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(t), 4)), 0);
+    if (m) {
+      i += __builtin_ctzll(m) >> 2;
+      return kToLower[a[i]] - kToLower[b[i]];
+    }
+  }
+  return memcasecmp_pure(a + i, b + i, n - i);
+}
+#endif
 
 /**
  * Compares memory case-insensitively.
@@ -49,28 +128,15 @@
  * @return is <0, 0, or >0 based on uint8_t comparison
  */
 int memcasecmp(const void *p, const void *q, size_t n) {
-  int c;
-  size_t i;
-  unsigned u;
-  uint64_t w;
   const unsigned char *a, *b;
-  if ((a = p) != (b = q)) {
-    for (i = 0; i < n; ++i) {
-      while (i + 8 <= n) {
-        if ((w = (READ64LE(a) ^ READ64LE(b)))) {
-          u = __builtin_ctzll(w);
-          i += u >> 3;
-          break;
-        } else {
-          i += 8;
-        }
-      }
-      if (i == n) {
-        break;
-      } else if ((c = kToLower[a[i]] - kToLower[b[i]])) {
-        return c;
-      }
-    }
-  }
-  return 0;
+  if ((a = p) == (b = q))
+    return 0;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (n >= 32 && X86_HAVE(AVX2))
+    return memcasecmp_avx2(a, b, n);
+#elif defined(__aarch64__)
+  if (n >= 16)
+    return memcasecmp_neon(a, b, n);
+#endif
+  return memcasecmp_pure(a, b, n);
 }
@@ -18,22 +18,18 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/dce.h"
 #include "libc/intrin/likely.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
+#ifdef __aarch64__
+#include "third_party/aarch64/arm_neon.internal.h"
+#endif
 
+#if defined(__x86_64__) && !defined(__chibicc__)
 typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
 
-/**
- * Searches for fixed-length substring in memory region.
- *
- * @param haystack is the region of memory to be searched
- * @param haystacklen is its character count
- * @param needle contains the memory for which we're searching
- * @param needlelen is its character count
- * @return pointer to first result or NULL if not found
- */
-__vex void *memmem(const void *haystack, size_t haystacklen, const void *needle,
-                   size_t needlelen) {
-#if defined(__x86_64__) && !defined(__chibicc__)
+static __vex void *memmem_sse(const void *haystack, size_t haystacklen,
+                              const void *needle, size_t needlelen) {
   char c;
   xmm_t n;
   const xmm_t *v;
@@ -74,7 +70,35 @@ __vex void *memmem(const void *haystack, size_t haystacklen, const void *needle,
       m &= ~(1 << k);
     } while (m);
   }
+}
+
+// compares the first and last bytes of the needle at 32 positions at
+// once, so that common first bytes don't lead to as many false starts
+_Microarchitecture("avx2") static void *memmem_avx2(const char *p, size_t n,
+                                                    const char *q, size_t k) {
+  size_t i, j;
+  unsigned m;
+  ymm_t f, l;
+  char a = q[0], b = q[k - 1];
+  f = (ymm_t){a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a,
+              a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a};
+  l = (ymm_t){b, b, b, b, b, b, b, b, b, b, b, b, b, b, b, b,
+              b, b, b, b, b, b, b, b, b, b, b, b, b, b, b, b};
+  for (i = 0; n - i >= k + 31; i += 32) {
+    m = __builtin_ia32_pmovmskb256((*(const ymm_t *)(p + i) == f) &
+                                   (*(const ymm_t *)(p + i + k - 1) == l));
+    for (; m; m &= m - 1) {
+      j = i + __builtin_ctz(m);
+      if (!memcmp(p + j + 1, q + 1, k - 2))
+        return (/*unconst*/ char *)p + j;
+    }
+  }
+  return memmem_sse(p + i, n - i, q, k);
+}
 #else
+
+static void *memmem_pure(const void *haystack, size_t haystacklen,
+                         const void *needle, size_t needlelen) {
   size_t i, j;
   if (!needlelen)
     return (void *)haystack;
@@ -91,5 +115,56 @@ __vex void *memmem(const void *haystack, size_t haystacklen, const void *needle,
     }
   }
   return 0;
+}
+
+#ifdef __aarch64__
+// same as memmem_avx2() with 16 positions at a time, where the mask
+// only keeps the top bit of the nibble that vshrn leaves for each byte
+static void *memmem_neon(const char *p, size_t n, const char *q, size_t k) {
+  size_t i, j;
+  uint64_t m;
+  uint8x16_t f, l, t;
+  f = vdupq_n_u8(q[0]);
+  l = vdupq_n_u8(q[k - 1]);
+  for (i = 0; n - i >= k + 15; i += 16) {
+    t = vandq_u8(vceqq_u8(vld1q_u8((const uint8_t *)p + i), f),
+                 vceqq_u8(vld1q_u8((const uint8_t *)p + i + k - 1), l));
+    m = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(t), 4)), 0);
+    for (m &= 0x8888888888888888; m; m &= m - 1) {
+      j = i + (__builtin_ctzll(m) >> 2);
+      if (!memcmp(p + j + 1, q + 1, k - 2))
+        return (/*unconst*/ char *)p + j;
+    }
+  }
+  return memmem_pure(p + i, n - i, q, k);
+}
+#endif
+
+#endif
+
+/**
+ * Searches for fixed-length substring in memory region.
+ *
+ * @param haystack is the region of memory to be searched
+ * @param haystacklen is its character count
+ * @param needle contains the memory for which we're searching
+ * @param needlelen is its character count
+ * @return pointer to first result or NULL if not found
+ */
+void *memmem(const void *haystack, size_t haystacklen, const void *needle,
+             size_t needlelen) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (needlelen >= 2 && needlelen <= haystacklen &&
+      haystacklen - needlelen >= 31 && X86_HAVE(AVX2))
+    return memmem_avx2(haystack, haystacklen, needle, needlelen);
+  return memmem_sse(haystack, haystacklen, needle, needlelen);
+#else
+#ifdef __aarch64__
+  if (needlelen >= 2 && needlelen <= haystacklen &&
+      haystacklen - needlelen >= 15)
+    return memmem_neon(haystack, haystacklen, needle, needlelen);
+#endif
+  return memmem_pure(haystack, haystacklen, needle, needlelen);
 #endif
 }
@@ -18,24 +18,17 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/str.h"
 #include "libc/dce.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/tab.internal.h"
+#ifdef __aarch64__
+#include "third_party/aarch64/arm_neon.internal.h"
+#endif
 
+#if defined(__x86_64__) && !defined(__chibicc__)
 typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(32)));
 
-/**
- * Searches for substring case-insensitively.
- *
- * @param haystack is the search area, as a NUL-terminated string
- * @param needle is the desired substring, also NUL-terminated
- * @return pointer to first substring within haystack, or NULL
- * @note this implementation goes fast in practice but isn't hardened
- *     against pathological cases, and therefore shouldn't be used on
- *     untrustworthy data
- * @asyncsignalsafe
- * @see strstr()
- */
-__vex char *strcasestr(const char *haystack, const char *needle) {
-#if defined(__x86_64__) && !defined(__chibicc__)
+static __vex char *strcasestr_sse(const char *haystack, const char *needle) {
   char c;
   size_t i;
   unsigned k, m;
@@ -43,9 +36,9 @@ __vex char *strcasestr(const char *haystack, const char *needle) {
   xmm_t v, n1, n2, z = {0};
   if (haystack == needle || !*needle)
     return (char *)haystack;
-  c = *needle;
+  c = kToLower[*needle & 255];
   n1 = (xmm_t){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
-  c = kToLower[c & 255];
+  c = kToUpper[*needle & 255];
   n2 = (xmm_t){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
   for (;;) {
     k = (uintptr_t)haystack & 15;
@@ -71,6 +64,112 @@ __vex char *strcasestr(const char *haystack, const char *needle) {
       break;
   }
   return 0;
+}
+
+_Microarchitecture("avx2") static char *strcasestr_avx2(const char *haystack,
+                                                        const char *needle) {
+  char c;
+  size_t i;
+  unsigned k, m;
+  const ymm_t *p;
+  ymm_t v, n1, n2, z = {0};
+  if (haystack == needle || !*needle)
+    return (char *)haystack;
+  c = kToLower[*needle & 255];
+  n1 = (ymm_t){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+               c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  c = kToUpper[*needle & 255];
+  n2 = (ymm_t){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+               c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  for (;;) {
+    k = (uintptr_t)haystack & 31;
+    p = (const ymm_t *)((uintptr_t)haystack & -32);
+    v = *p;
+    m = __builtin_ia32_pmovmskb256((v == z) | (v == n1) | (v == n2));
+    m >>= k;
+    m <<= k;
+    while (!m) {
+      v = *++p;
+      m = __builtin_ia32_pmovmskb256((v == z) | (v == n1) | (v == n2));
+    }
+    haystack = (const char *)p + __builtin_ctzl(m);
+    for (i = 0;; ++i) {
+      if (!needle[i])
+        return (/*unconst*/ char *)haystack;
+      if (!haystack[i])
+        break;
+      if (kToLower[needle[i] & 255] != kToLower[haystack[i] & 255])
+        break;
+    }
+    if (!*haystack++)
+      break;
+  }
+  return 0;
+}
+#endif
+
+#ifdef __aarch64__
+static uint64_t strcasestr_mask(uint8x16_t v, uint8x16_t n1, uint8x16_t n2) {
+  uint8x16_t t;
+  t = vorrq_u8(vceqq_u8(v, vdupq_n_u8(0)),
+               vorrq_u8(vceqq_u8(v, n1), vceqq_u8(v, n2)));
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(t), 4)), 0);
+}
+
+// like strcasestr_sse() except the mask has a nibble for each byte
+static char *strcasestr_neon(const char *haystack, const char *needle) {
+  size_t i;
+  unsigned k;
+  uint64_t m;
+  uint8x16_t n1, n2;
+  const unsigned char *p;
+  if (haystack == needle || !*needle)
+    return (char *)haystack;
+  n1 = vdupq_n_u8(kToLower[*needle & 255]);
+  n2 = vdupq_n_u8(kToUpper[*needle & 255]);
+  for (;;) {
+    k = (uintptr_t)haystack & 15;
+    p = (const unsigned char *)((uintptr_t)haystack & -16);
+    m = strcasestr_mask(vld1q_u8(p), n1, n2);
+    m = m >> (k << 2) << (k << 2);
+    while (!m)
+      m = strcasestr_mask(vld1q_u8((p += 16)), n1, n2);
+    haystack = (const char *)p + (__builtin_ctzll(m) >> 2);
+    for (i = 0;; ++i) {
+      if (!needle[i])
+        return (/*unconst*/ char *)haystack;
+      if (!haystack[i])
+        break;
+      if (kToLower[needle[i] & 255] != kToLower[haystack[i] & 255])
+        break;
+    }
+    if (!*haystack++)
+      break;
+  }
+  return 0;
+}
+#endif
+
+/**
+ * Searches for substring case-insensitively.
+ *
+ * @param haystack is the search area, as a NUL-terminated string
+ * @param needle is the desired substring, also NUL-terminated
+ * @return pointer to first substring within haystack, or NULL
+ * @note this implementation goes fast in practice but isn't hardened
+ *     against pathological cases, and therefore shouldn't be used on
+ *     untrustworthy data
+ * @asyncsignalsafe
+ * @see strstr()
+ */
+char *strcasestr(const char *haystack, const char *needle) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2))
+    return strcasestr_avx2(haystack, needle);
+  return strcasestr_sse(haystack, needle);
+#elif defined(__aarch64__)
+  return strcasestr_neon(haystack, needle);
 #else
   size_t i;
   if (haystack == needle || !*needle)
@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/str.h"
+#include "libc/str/strspn.internal.h"
 
 /**
  * Returns prefix length, consisting of chars not in reject.
@@ -37,6 +38,9 @@ size_t strcspn(const char *s, const char *reject) {
   if (!reject[1]) {
     return strchrnul(s, reject[0]) - s;
   }
+  if ((i = __strspn_vec(s, reject, true)) != -1) {
+    return i;
+  }
 #endif
   bzero(lut, sizeof(lut));
   do {
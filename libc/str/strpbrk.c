@@ -17,16 +17,20 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/str.h"
+#include "libc/str/strspn.internal.h"
 
 /**
  * Returns pointer to first byte matching any in accept, or NULL.
  * @asyncsignalsafe
  */
 char *strpbrk(const char *s, const char *accept) {
+  size_t i;
   bool lut[256];
   if (accept[0]) {
     if (!accept[1]) {
       return strchr(s, accept[0]);
+    } else if ((i = __strspn_vec(s, accept, true)) != -1) {
+      return s[i] ? (/*unconst*/ char *)s + i : 0;
     } else {
       bzero(lut, sizeof(lut));
       while (*accept) {
@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/str.h"
+#include "libc/str/strspn.internal.h"
 
 /**
  * Returns prefix length, consisting of chars in accept.
@@ -40,6 +41,9 @@ size_t strspn(const char *s, const char *accept) {
       }
     }
   }
+  if ((i = __strspn_vec(s, accept, false)) != -1) {
+    return i;
+  }
 #endif
   bzero(lut, sizeof(lut));
   while ((c = *accept++ & 255)) {
@@ -0,0 +1,8 @@
+#ifndef COSMOPOLITAN_LIBC_STR_STRSPN_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_STR_STRSPN_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+size_t __strspn_vec(const char *, const char *, bool) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_STR_STRSPN_INTERNAL_H_ */
@@ -0,0 +1,124 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/str/strspn.internal.h"
+#ifdef __aarch64__
+#include "third_party/aarch64/arm_neon.internal.h"
+#endif
+
+// Bytes are classified with two table lookups, one per nibble. Bit h
+// of lo[c & 15] is set when the byte (h << 4) | (c & 15) is in the set
+// and hi[c >> 4] holds the bit for its high nibble, so that c belongs
+// to the set iff lo[c & 15] & hi[c >> 4] is nonzero. There are only 8
+// bits, so sets containing bytes above 127 have to use a lookup table.
+//
+// Strings are scanned in aligned blocks, which never cross a page, so
+// reading past the NUL terminator can't fault. On aarch64 the lookups
+// are done with tbl, and since there's no pmovmskb, each byte of the
+// comparison is narrowed to a nibble of a 64-bit mask.
+
+#if (defined(__x86_64__) && !defined(__chibicc__)) || defined(__aarch64__)
+static const unsigned char kSpnHigh[16] = {
+    1, 2, 4, 8, 16, 32, 64, 128,
+};
+#endif
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+typedef unsigned char ymm_t
+    __attribute__((__vector_size__(32), __aligned__(32)));
+typedef char ymm_s __attribute__((__vector_size__(32), __aligned__(32)));
+
+_Microarchitecture("avx2") static size_t strspn_avx2(const char *s,
+                                                     const unsigned char lo[16],
+                                                     bool reject) {
+  ymm_t v, a, b, t, z = {0};
+  unsigned m, k = (uintptr_t)s & 31;
+  const ymm_t *p = (const ymm_t *)((uintptr_t)s & -32);
+  __builtin_memcpy(&a, lo, 16);
+  __builtin_memcpy((char *)&a + 16, lo, 16);
+  __builtin_memcpy(&b, kSpnHigh, 16);
+  __builtin_memcpy((char *)&b + 16, kSpnHigh, 16);
+  for (;; k = 0, ++p) {
+    v = *p;
+    t = (ymm_t)__builtin_ia32_pshufb256((ymm_s)a, (ymm_s)(v & 15)) &
+        (ymm_t)__builtin_ia32_pshufb256((ymm_s)b, (ymm_s)(v >> 4));
+    m = __builtin_ia32_pmovmskb256((ymm_s)(t == z));
+    if (reject)
+      m = ~m;
+    if ((m = m >> k << k))
+      return (const char *)p + __builtin_ctz(m) - s;
+  }
+}
+#endif
+
+#ifdef __aarch64__
+static size_t strspn_neon(const char *s, const unsigned char lo[16],
+                          bool reject) {
+  uint64_t m;
+  uint8x16_t v, t, a, b;
+  unsigned k = (uintptr_t)s & 15;
+  const unsigned char *p = (const unsigned char *)((uintptr_t)s & -16);
+  a = vld1q_u8(lo);
+  b = vld1q_u8(kSpnHigh);
+  for (;; k = 0, p += 16) {
+    v = vld1q_u8(p);
+    t = vtstq_u8(vqtbl1q_u8(a, vandq_u8(v, vdupq_n_u8(15))),
+                 vqtbl1q_u8(b, vshrq_n_u8(v, 4)));
+    if (!reject)
+      t = vmvnq_u8(t);
+    m = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(t), 4)), 0);
+    if ((m = m >> (k << 2) << (k << 2)))
+      return (const char *)p + (__builtin_ctzll(m) >> 2) - s;
+  }
+}
+#endif
+
+/**
+ * Vectorized strspn() and strcspn() for sets of ASCII characters.
+ *
+ * @param s is nul-terminated string to scan
+ * @param set is nul-terminated character set
+ * @param reject if true counts bytes not in set, which includes NUL
+ * @return prefix length, or -1 if set or cpu isn't supported
+ */
+size_t __strspn_vec(const char *s, const char *set, bool reject) {
+#if (defined(__x86_64__) && !defined(__chibicc__)) || defined(__aarch64__)
+  int c;
+  unsigned char lo[16] = {0};
+#ifdef __x86_64__
+  if (!X86_HAVE(AVX2))
+    return -1;
+#endif
+  if (reject)
+    lo[0] = 1;
+  while ((c = *set++ & 255)) {
+    if (c >= 128)
+      return -1;
+    lo[c & 15] |= 1 << (c >> 4);
+  }
+#ifdef __x86_64__
+  return strspn_avx2(s, lo, reject);
+#else
+  return strspn_neon(s, lo, reject);
+#endif
+#else
+  return -1;
+#endif
+}
@@ -18,24 +18,16 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/str.h"
 #include "libc/dce.h"
+#include "libc/nexgen32e/x86feature.h"
+#ifdef __aarch64__
+#include "third_party/aarch64/arm_neon.internal.h"
+#endif
 
+#if defined(__x86_64__) && !defined(__chibicc__)
 typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(32)));
 
-/**
- * Searches for substring.
- *
- * @param haystack is the search area, as a NUL-terminated string
- * @param needle is the desired substring, also NUL-terminated
- * @return pointer to first substring within haystack, or NULL
- * @note this implementation goes fast in practice but isn't hardened
- *     against pathological cases, and therefore shouldn't be used on
- *     untrustworthy data
- * @asyncsignalsafe
- * @see strcasestr()
- * @see memmem()
- */
-__vex char *strstr(const char *haystack, const char *needle) {
-#if defined(__x86_64__) && !defined(__chibicc__)
+static __vex char *strstr_sse(const char *haystack, const char *needle) {
   size_t i;
   unsigned k, m;
   const xmm_t *p;
@@ -69,6 +61,107 @@ __vex char *strstr(const char *haystack, const char *needle) {
       break;
   }
   return 0;
+}
+
+_Microarchitecture("avx2") static char *strstr_avx2(const char *haystack,
+                                                    const char *needle) {
+  char c;
+  size_t i;
+  unsigned k, m;
+  const ymm_t *p;
+  ymm_t v, n, z = {0};
+  if (haystack == needle || !*needle)
+    return (char *)haystack;
+  c = *needle;
+  n = (ymm_t){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c,
+              c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+  for (;;) {
+    k = (uintptr_t)haystack & 31;
+    p = (const ymm_t *)((uintptr_t)haystack & -32);
+    v = *p;
+    m = __builtin_ia32_pmovmskb256((v == z) | (v == n));
+    m >>= k;
+    m <<= k;
+    while (!m) {
+      v = *++p;
+      m = __builtin_ia32_pmovmskb256((v == z) | (v == n));
+    }
+    haystack = (const char *)p + __builtin_ctzl(m);
+    for (i = 0;; ++i) {
+      if (!needle[i])
+        return (/*unconst*/ char *)haystack;
+      if (!haystack[i])
+        break;
+      if (needle[i] != haystack[i])
+        break;
+    }
+    if (!*haystack++)
+      break;
+  }
+  return 0;
+}
+#endif
+
+#ifdef __aarch64__
+static uint64_t strstr_mask(uint8x16_t v, uint8x16_t n) {
+  uint8x16_t t = vorrq_u8(vceqq_u8(v, vdupq_n_u8(0)), vceqq_u8(v, n));
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(t), 4)), 0);
+}
+
+// like strstr_sse() except the mask has a nibble for each byte
+static char *strstr_neon(const char *haystack, const char *needle) {
+  size_t i;
+  unsigned k;
+  uint64_t m;
+  uint8x16_t n;
+  const unsigned char *p;
+  if (haystack == needle || !*needle)
+    return (char *)haystack;
+  n = vdupq_n_u8(*needle);
+  for (;;) {
+    k = (uintptr_t)haystack & 15;
+    p = (const unsigned char *)((uintptr_t)haystack & -16);
+    m = strstr_mask(vld1q_u8(p), n);
+    m = m >> (k << 2) << (k << 2);
+    while (!m)
+      m = strstr_mask(vld1q_u8((p += 16)), n);
+    haystack = (const char *)p + (__builtin_ctzll(m) >> 2);
+    for (i = 0;; ++i) {
+      if (!needle[i])
+        return (/*unconst*/ char *)haystack;
+      if (!haystack[i])
+        break;
+      if (needle[i] != haystack[i])
+        break;
+    }
+    if (!*haystack++)
+      break;
+  }
+  return 0;
+}
+#endif
+
+/**
+ * Searches for substring.
+ *
+ * @param haystack is the search area, as a NUL-terminated string
+ * @param needle is the desired substring, also NUL-terminated
+ * @return pointer to first substring within haystack, or NULL
+ * @note this implementation goes fast in practice but isn't hardened
+ *     against pathological cases, and therefore shouldn't be used on
+ *     untrustworthy data
+ * @asyncsignalsafe
+ * @see strcasestr()
+ * @see memmem()
+ */
+char *strstr(const char *haystack, const char *needle) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2))
+    return strstr_avx2(haystack, needle);
+  return strstr_sse(haystack, needle);
+#elif defined(__aarch64__)
+  return strstr_neon(haystack, needle);
 #else
   size_t i;
   if (haystack == needle || !*needle)
@@ -34,6 +34,7 @@ LIBC_THREAD_A_DIRECTDEPS =				\
 	LIBC_STR					\
 	LIBC_SYSV					\
 	LIBC_SYSV_CALLS					\
+	THIRD_PARTY_DLMALLOC				\
 	THIRD_PARTY_NSYNC				\
 	THIRD_PARTY_NSYNC_MEM
 
@@ -0,0 +1,126 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/ring.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "third_party/nsync/futex.internal.h"
+
+// intrusive unbounded queue by dmitry vyukov. pushing is one exchange
+// so producers never wait on each other. the consumer pops from a tail
+// that trails behind a stub node. there's a brief window where a push
+// has exchanged the head but not linked it in yet, in which the queue
+// appears empty to the consumer, which is fine.
+
+static void MpscLink(struct CosmoMpsc *q, struct CosmoMpscNode *n) {
+  struct CosmoMpscNode *prev;
+  atomic_store_explicit(&n->next, 0, memory_order_relaxed);
+  prev = atomic_exchange_explicit(&q->head, n, memory_order_acq_rel);
+  atomic_store_explicit(&prev->next, n, memory_order_release);
+}
+
+/**
+ * Initializes multiple producer single consumer queue.
+ */
+void cosmo_mpsc_init(struct CosmoMpsc *q) {
+  atomic_init(&q->stub.next, 0);
+  atomic_init(&q->head, &q->stub);
+  atomic_init(&q->signal, 0);
+  atomic_init(&q->waiters, 0);
+  q->tail = &q->stub;
+}
+
+/**
+ * Adds node to queue.
+ *
+ * This may be called by any number of threads at once. It's wait-free
+ * unless the consumer is asleep, in which case it gets woken up.
+ */
+void cosmo_mpsc_push(struct CosmoMpsc *q, struct CosmoMpscNode *n) {
+  MpscLink(q, n);
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&q->waiters, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&q->signal, 1, memory_order_release);
+    nsync_futex_wake_((atomic_int *)&q->signal, 1, false);
+  }
+}
+
+/**
+ * Removes oldest node from queue if there's one.
+ *
+ * This may only be called by one thread at a time.
+ *
+ * @return node, or null if queue is empty
+ */
+struct CosmoMpscNode *cosmo_mpsc_trypop(struct CosmoMpsc *q) {
+  struct CosmoMpscNode *tail, *next;
+  tail = q->tail;
+  next = atomic_load_explicit(&tail->next, memory_order_acquire);
+  if (tail == &q->stub) {
+    if (!next)
+      return 0;
+    q->tail = tail = next;
+    next = atomic_load_explicit(&next->next, memory_order_acquire);
+  }
+  if (next) {
+    q->tail = next;
+    return tail;
+  }
+  if (tail != atomic_load_explicit(&q->head, memory_order_acquire))
+    return 0;  // producer is in the middle of linking
+  MpscLink(q, &q->stub);
+  if ((next = atomic_load_explicit(&tail->next, memory_order_acquire))) {
+    q->tail = next;
+    return tail;
+  }
+  return 0;
+}
+
+/**
+ * Removes oldest node from queue, waiting while it's empty.
+ *
+ * This may only be called by one thread at a time.
+ *
+ * @param abstime may be null to wait indefinitely and should contain
+ *     some arbitrary interval added to a `CLOCK_REALTIME` timestamp
+ * @return 0 on success, or errno on error
+ * @raise ETIMEDOUT if `abstime` was specified and the current time
+ *     exceeded its value
+ */
+errno_t cosmo_mpsc_pop(struct CosmoMpsc *q, struct CosmoMpscNode **out,
+                       const struct timespec *abstime) {
+  int rc;
+  unsigned sig;
+  for (;;) {
+    if ((*out = cosmo_mpsc_trypop(q)))
+      return 0;
+    sig = atomic_load_explicit(&q->signal, memory_order_acquire);
+    atomic_fetch_add_explicit(&q->waiters, 1, memory_order_seq_cst);
+    if ((*out = cosmo_mpsc_trypop(q))) {
+      atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+      return 0;
+    }
+    rc = nsync_futex_wait_((atomic_int *)&q->signal, sig, false, abstime);
+    atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+    if (rc == -ETIMEDOUT && abstime &&
+        timespec_cmp(*abstime, timespec_real()) <= 0) {
+      return ETIMEDOUT;
+    }
+  }
+}
@@ -0,0 +1,397 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/pool.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+#include "third_party/nsync/cv.h"
+#include "third_party/nsync/mu.h"
+
+// each worker owns a chase-lev deque. it pushes and pops tasks at the
+// bottom without contention, and idle workers steal from the top. the
+// tasks submitted by threads that aren't workers go on an injection
+// queue. workers with nothing to do spin briefly and then park on an
+// nsync condition, until an epoch counter says new work's available.
+
+#define POOL_DEQUE 1024  // must be two power
+#define POOL_SPINS 64
+
+struct PoolTask {
+  void (*func)(void *);
+  void (*range)(void *, size_t, size_t);
+  void *arg;
+  size_t lo, hi;
+  _Atomic(long) *group;
+  struct PoolTask *next;
+};
+
+struct PoolDeque {
+  _Alignas(64) _Atomic(long) top;
+  _Alignas(64) _Atomic(long) bottom;
+  _Atomic(struct PoolTask *) tasks[POOL_DEQUE];
+};
+
+struct PoolWorker {
+  struct PoolDeque deque;
+  struct CosmoPool *pool;
+  pthread_t th;
+  unsigned rand;
+};
+
+struct CosmoPool {
+  _Alignas(64) _Atomic(long) pending;
+  _Alignas(64) _Atomic(unsigned) epoch;
+  _Atomic(int) sleepers;
+  _Atomic(long) injected;
+  _Atomic(bool) shutdown;
+  int count;
+  nsync_mu mu;
+  nsync_cv work;
+  nsync_cv done;
+  struct PoolTask *head;
+  struct PoolTask *tail;
+  struct PoolWorker *workers;
+};
+
+static _Thread_local struct PoolWorker *_pool_self;
+
+static bool PoolPush(struct PoolDeque *q, struct PoolTask *t) {
+  long b, u;
+  b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  u = atomic_load_explicit(&q->top, memory_order_acquire);
+  if (b - u >= POOL_DEQUE)
+    return false;
+  atomic_store_explicit(&q->tasks[b & (POOL_DEQUE - 1)], t,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static struct PoolTask *PoolTake(struct PoolDeque *q) {
+  long b, u;
+  struct PoolTask *t;
+  b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  u = atomic_load_explicit(&q->top, memory_order_relaxed);
+  if (u <= b) {
+    t = atomic_load_explicit(&q->tasks[b & (POOL_DEQUE - 1)],
+                             memory_order_relaxed);
+    if (u == b) {
+      // racing thieves for the last task
+      if (!atomic_compare_exchange_strong_explicit(&q->top, &u, u + 1,
+                                                   memory_order_seq_cst,
+                                                   memory_order_relaxed)) {
+        t = 0;
+      }
+      atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+  } else {
+    t = 0;
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+  }
+  return t;
+}
+
+static struct PoolTask *PoolSteal(struct PoolDeque *q) {
+  long b, u;
+  struct PoolTask *t;
+  for (;;) {
+    u = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (u >= b)
+      return 0;
+    t = atomic_load_explicit(&q->tasks[u & (POOL_DEQUE - 1)],
+                             memory_order_relaxed);
+    if (atomic_compare_exchange_strong_explicit(&q->top, &u, u + 1,
+                                                memory_order_seq_cst,
+                                                memory_order_relaxed)) {
+      return t;
+    }
+  }
+}
+
+static struct PoolTask *PoolDequeue(struct CosmoPool *p) {
+  struct PoolTask *t;
+  if (!atomic_load_explicit(&p->injected, memory_order_acquire))
+    return 0;
+  nsync_mu_lock(&p->mu);
+  if ((t = p->head)) {
+    if (!(p->head = t->next))
+      p->tail = 0;
+    atomic_fetch_sub_explicit(&p->injected, 1, memory_order_relaxed);
+  }
+  nsync_mu_unlock(&p->mu);
+  return t;
+}
+
+static void PoolEnqueue(struct CosmoPool *p, struct PoolTask *t) {
+  t->next = 0;
+  nsync_mu_lock(&p->mu);
+  if (p->tail) {
+    p->tail->next = t;
+  } else {
+    p->head = t;
+  }
+  p->tail = t;
+  atomic_fetch_add_explicit(&p->injected, 1, memory_order_release);
+  nsync_mu_unlock(&p->mu);
+}
+
+static struct PoolWorker *PoolSelf(struct CosmoPool *p) {
+  struct PoolWorker *w;
+  if ((w = _pool_self) && w->pool == p)
+    return w;
+  return 0;
+}
+
+static struct PoolTask *PoolFind(struct CosmoPool *p, struct PoolWorker *w) {
+  int i, j;
+  struct PoolTask *t;
+  if (w && (t = PoolTake(&w->deque)))
+    return t;
+  if ((t = PoolDequeue(p)))
+    return t;
+  j = w ? (w->rand = w->rand * 1103515245 + 12345) >> 16 : 0;
+  for (i = 0; i < p->count; ++i) {
+    struct PoolWorker *v = p->workers + (i + j) % p->count;
+    if (v != w && (t = PoolSteal(&v->deque)))
+      return t;
+  }
+  return 0;
+}
+
+// wakes one parked worker, or all of them, if any are parked
+static void PoolPublish(struct CosmoPool *p, bool all) {
+  atomic_fetch_add_explicit(&p->epoch, 1, memory_order_seq_cst);
+  if (atomic_load_explicit(&p->sleepers, memory_order_seq_cst)) {
+    nsync_mu_lock(&p->mu);
+    if (all) {
+      nsync_cv_broadcast(&p->work);
+    } else {
+      nsync_cv_signal(&p->work);
+    }
+    nsync_mu_unlock(&p->mu);
+  }
+}
+
+static void PoolFinish(struct CosmoPool *p, _Atomic(long) *counter) {
+  if (atomic_fetch_sub_explicit(counter, 1, memory_order_acq_rel) == 1) {
+    nsync_mu_lock(&p->mu);
+    nsync_cv_broadcast(&p->done);
+    nsync_mu_unlock(&p->mu);
+  }
+}
+
+static void PoolRun(struct CosmoPool *p, struct PoolTask *t) {
+  if (t->range) {
+    t->range(t->arg, t->lo, t->hi);
+  } else {
+    t->func(t->arg);
+  }
+  if (t->group)
+    PoolFinish(p, t->group);
+  free(t);
+  PoolFinish(p, &p->pending);
+}
+
+static int PoolSubmit(struct CosmoPool *p, const struct PoolTask *task) {
+  struct PoolTask *t;
+  struct PoolWorker *w;
+  if (!(t = malloc(sizeof(*t))))
+    return ENOMEM;
+  *t = *task;
+  atomic_fetch_add_explicit(&p->pending, 1, memory_order_relaxed);
+  if (!(w = PoolSelf(p)) || !PoolPush(&w->deque, t))
+    PoolEnqueue(p, t);
+  return 0;
+}
+
+// runs tasks until counter drops to zero, and then sleeps if needed
+static void PoolHelp(struct CosmoPool *p, _Atomic(long) *counter) {
+  struct PoolTask *t;
+  struct PoolWorker *w = PoolSelf(p);
+  while (atomic_load_explicit(counter, memory_order_acquire)) {
+    if ((t = PoolFind(p, w))) {
+      PoolRun(p, t);
+    } else {
+      nsync_mu_lock(&p->mu);
+      while (atomic_load_explicit(counter, memory_order_acquire))
+        nsync_cv_wait(&p->done, &p->mu);
+      nsync_mu_unlock(&p->mu);
+    }
+  }
+}
+
+static void *PoolWorker(void *arg) {
+  int spins;
+  unsigned epoch;
+  struct PoolTask *t;
+  struct PoolWorker *w = arg;
+  struct CosmoPool *p = w->pool;
+  _pool_self = w;
+  for (spins = 0;;) {
+    epoch = atomic_load_explicit(&p->epoch, memory_order_seq_cst);
+    if ((t = PoolFind(p, w))) {
+      PoolRun(p, t);
+      spins = 0;
+    } else if (atomic_load_explicit(&p->shutdown, memory_order_acquire)) {
+      break;
+    } else if (++spins < POOL_SPINS) {
+      pthread_pause_np();
+    } else {
+      nsync_mu_lock(&p->mu);
+      atomic_fetch_add_explicit(&p->sleepers, 1, memory_order_seq_cst);
+      while (atomic_load_explicit(&p->epoch, memory_order_seq_cst) == epoch &&
+             !atomic_load_explicit(&p->shutdown, memory_order_acquire)) {
+        nsync_cv_wait(&p->work, &p->mu);
+      }
+      atomic_fetch_sub_explicit(&p->sleepers, 1, memory_order_relaxed);
+      nsync_mu_unlock(&p->mu);
+      spins = 0;
+    }
+  }
+  return 0;
+}
+
+static void PoolStop(struct CosmoPool *p, int n) {
+  int i;
+  nsync_mu_lock(&p->mu);
+  atomic_store_explicit(&p->shutdown, true, memory_order_release);
+  nsync_cv_broadcast(&p->work);
+  nsync_mu_unlock(&p->mu);
+  for (i = 0; i < n; ++i)
+    pthread_join(p->workers[i].th, 0);
+  free(p->workers);
+  free(p);
+}
+
+/**
+ * Creates work stealing thread pool.
+ *
+ * @param threads is number of worker threads, or 0 for cpu count
+ * @return new pool, or null w/ errno
+ */
+struct CosmoPool *cosmo_pool_create(int threads) {
+  int i, rc;
+  struct CosmoPool *p;
+  if (threads <= 0)
+    threads = MAX(1, __get_cpu_count());
+  if (!(p = calloc(1, sizeof(*p))))
+    return 0;
+  if (!(p->workers = memalign(64, threads * sizeof(*p->workers)))) {
+    free(p);
+    return 0;
+  }
+  bzero(p->workers, threads * sizeof(*p->workers));
+  for (i = 0; i < threads; ++i) {
+    p->workers[i].pool = p;
+    p->workers[i].rand = i + 1;
+  }
+  p->count = threads;
+  for (i = 0; i < threads; ++i) {
+    if ((rc = pthread_create(&p->workers[i].th, 0, PoolWorker,
+                             p->workers + i))) {
+      PoolStop(p, i);
+      errno = rc;
+      return 0;
+    }
+  }
+  return p;
+}
+
+/**
+ * Schedules `func(arg)` to be run by thread pool.
+ *
+ * When called by a worker, the task is pushed on its own deque, where
+ * it's likely to run soon on the same core, unless another worker is
+ * idle and steals it.
+ *
+ * @return 0 on success, or errno on error
+ * @raise ENOMEM if we require more vespene gas
+ */
+int cosmo_pool_submit(struct CosmoPool *p, void (*func)(void *), void *arg) {
+  int rc;
+  struct PoolTask t = {.func = func, .arg = arg};
+  if (!(rc = PoolSubmit(p, &t)))
+    PoolPublish(p, false);
+  return rc;
+}
+
+/**
+ * Runs `func(arg, lo, hi)` over subintervals of `[0,n)` in parallel.
+ *
+ * The calling thread participates and this function returns when all
+ * subintervals are done. It may be called from inside a task.
+ *
+ * @param grain is the size of subintervals, or 0 to choose for you
+ * @return 0 on success, or errno on error
+ * @raise ENOMEM if we require more vespene gas, in which case
+ *     subintervals that couldn't be scheduled are run by the caller
+ */
+int cosmo_pool_parallel_for(struct CosmoPool *p, size_t n, size_t grain,
+                            void func(void *, size_t, size_t), void *arg) {
+  int rc = 0;
+  size_t lo, hi;
+  _Atomic(long) group = 0;
+  if (!grain)
+    grain = MAX(1, n / (p->count * 4));
+  for (lo = 0; lo < n; lo = hi) {
+    hi = lo + MIN(grain, n - lo);
+    struct PoolTask t = {.range = func, .arg = arg, .lo = lo, .hi = hi};
+    t.group = &group;
+    atomic_fetch_add_explicit(&group, 1, memory_order_relaxed);
+    if (PoolSubmit(p, &t)) {
+      atomic_fetch_sub_explicit(&group, 1, memory_order_relaxed);
+      func(arg, lo, hi);
+      rc = ENOMEM;
+    }
+  }
+  PoolPublish(p, true);
+  PoolHelp(p, &group);
+  return rc;
+}
+
+/**
+ * Waits for all tasks that have been submitted to pool to finish.
+ *
+ * The calling thread helps run tasks while it's waiting. This must not
+ * be called from inside a task, since the task counts as unfinished.
+ */
+void cosmo_pool_wait(struct CosmoPool *p) {
+  PoolHelp(p, &p->pending);
+}
+
+/**
+ * Waits for tasks to finish and then destroys thread pool.
+ *
+ * This must not be called by one of the pool's own workers.
+ */
+void cosmo_pool_destroy(struct CosmoPool *p) {
+  if (!p)
+    return;
+  cosmo_pool_wait(p);
+  PoolStop(p, p->count);
+}
@@ -0,0 +1,16 @@
+#ifndef COSMOPOLITAN_LIBC_THREAD_POOL_H_
+#define COSMOPOLITAN_LIBC_THREAD_POOL_H_
+COSMOPOLITAN_C_START_
+
+struct CosmoPool;
+
+struct CosmoPool *cosmo_pool_create(int) libcesque;
+int cosmo_pool_submit(struct CosmoPool *, void (*)(void *), void *) libcesque;
+int cosmo_pool_parallel_for(struct CosmoPool *, size_t, size_t,
+                            void (*)(void *, size_t, size_t),
+                            void *) libcesque;
+void cosmo_pool_wait(struct CosmoPool *) libcesque;
+void cosmo_pool_destroy(struct CosmoPool *) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_THREAD_POOL_H_ */
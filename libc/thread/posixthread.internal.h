@@ -97,12 +97,14 @@ extern struct Dll *_pthread_list;
 extern struct PosixThread _pthread_static;
 extern _Atomic(pthread_key_dtor) _pthread_key_dtor[PTHREAD_KEYS_MAX];
 
+bool _pthread_stack_give(void *, size_t, size_t) libcesque;
 int _pthread_atfork(atfork_f, atfork_f, atfork_f) libcesque;
 int _pthread_reschedule(struct PosixThread *) libcesque;
 int _pthread_setschedparam_freebsd(int, int, const struct sched_param *);
 int _pthread_tid(struct PosixThread *) libcesque;
 intptr_t _pthread_syshand(struct PosixThread *) libcesque;
 long _pthread_cancel_ack(void) libcesque;
+void *_pthread_stack_take(size_t, size_t) libcesque;
 void _pthread_decimate(void) libcesque;
 void _pthread_free(struct PosixThread *, bool) libcesque;
 void _pthread_init(void) libcesque;
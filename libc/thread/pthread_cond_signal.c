@@ -16,8 +16,10 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/atomic.h"
 #include "libc/thread/thread.h"
 #include "third_party/nsync/cv.h"
+#include "third_party/nsync/futex.internal.h"
 
 /**
  * Wakes at least one thread waiting on condition, e.g.
@@ -37,6 +39,13 @@
  * @see pthread_cond_wait
  */
 errno_t pthread_cond_signal(pthread_cond_t *cond) {
+  if (cond->_pshared) {
+    if (atomic_load_explicit(&cond->_waiters, memory_order_acquire)) {
+      atomic_fetch_add_explicit(&cond->_sequence, 1, memory_order_acq_rel);
+      nsync_futex_wake_((atomic_int *)&cond->_sequence, 1, true);
+    }
+    return 0;
+  }
   nsync_cv_signal((nsync_cv *)cond);
   return 0;
 }
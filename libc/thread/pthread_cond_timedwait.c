@@ -16,13 +16,55 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/cp.internal.h"
+#include "libc/calls/struct/timespec.h"
 #include "libc/errno.h"
+#include "libc/intrin/atomic.h"
 #include "libc/thread/thread.h"
 #include "libc/thread/thread2.h"
 #include "third_party/nsync/common.internal.h"
 #include "third_party/nsync/cv.h"
+#include "third_party/nsync/futex.internal.h"
 #include "third_party/nsync/time.h"
 
+struct PthreadWait {
+  pthread_cond_t *cond;
+  pthread_mutex_t *mutex;
+};
+
+static void pthread_cond_leave(void *arg) {
+  struct PthreadWait *wait = arg;
+  atomic_fetch_sub_explicit(&wait->cond->_waiters, 1, memory_order_acq_rel);
+  pthread_mutex_lock(wait->mutex);
+}
+
+// process shared condition variables can't use *NSYNC, which keeps
+// its waiters on a linked list in private memory. so we sleep on the
+// futex of a sequence number, that signalers increment to wake us up
+static errno_t pthread_cond_timedwait_pshared(pthread_cond_t *cond,
+                                              pthread_mutex_t *mutex,
+                                              const struct timespec *abstime) {
+  int rc;
+  uint32_t seq;
+  errno_t err = 0;
+  struct PthreadWait wait = {cond, mutex};
+  BEGIN_CANCELATION_POINT;
+  seq = atomic_load_explicit(&cond->_sequence, memory_order_acquire);
+  atomic_fetch_add_explicit(&cond->_waiters, 1, memory_order_acq_rel);
+  pthread_cleanup_push(pthread_cond_leave, &wait);
+  pthread_mutex_unlock(mutex);
+  rc = nsync_futex_wait_((atomic_int *)&cond->_sequence, seq, true, abstime);
+  if (rc == -ECANCELED) {
+    err = ECANCELED;
+  } else if (rc == -ETIMEDOUT && abstime &&
+             timespec_cmp(*abstime, timespec_real()) <= 0) {
+    err = ETIMEDOUT;
+  }
+  pthread_cleanup_pop(1);
+  END_CANCELATION_POINT;
+  return err;
+}
+
 /**
  * Waits for condition with optional time limit, e.g.
  *
@@ -51,6 +93,9 @@ errno_t pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
   if (abstime && !(0 <= abstime->tv_nsec && abstime->tv_nsec < 1000000000)) {
     return EINVAL;
   }
+  if (cond->_pshared) {
+    return pthread_cond_timedwait_pshared(cond, mutex, abstime);
+  }
   if (mutex->_type != PTHREAD_MUTEX_NORMAL) {
     nsync_panic_("pthread cond needs normal mutex\n");
   }
@@ -71,7 +71,9 @@ void _pthread_free(struct PosixThread *pt, bool isfork) {
   unassert(dll_is_alone(&pt->list) && &pt->list != _pthread_list);
   if (pt->pt_flags & PT_STATIC)
     return;
-  if (pt->pt_flags & PT_OWNSTACK) {
+  if ((pt->pt_flags & PT_OWNSTACK) &&
+      !_pthread_stack_give(pt->pt_attr.__stackaddr, pt->pt_attr.__stacksize,
+                           pt->pt_attr.__guardsize)) {
     unassert(!munmap(pt->pt_attr.__stackaddr, pt->pt_attr.__stacksize));
   }
   if (!isfork) {
@@ -221,8 +223,16 @@ static errno_t pthread_create_impl(pthread_t *thread,
       _pthread_free(pt, false);
       return EINVAL;
     }
-    if (pt->pt_attr.__guardsize == pagesize &&
-        !(IsAarch64() && IsLinux() && IsQemuUser())) {
+    if ((pt->pt_attr.__stackaddr = _pthread_stack_take(
+             pt->pt_attr.__stacksize, pt->pt_attr.__guardsize))) {
+      // recycle stack of a thread that's already been joined or reaped
+      if (IsAsan()) {
+        __asan_unpoison(
+            (char *)pt->pt_attr.__stackaddr + pt->pt_attr.__guardsize,
+            pt->pt_attr.__stacksize - pt->pt_attr.__guardsize);
+      }
+    } else if (pt->pt_attr.__guardsize == pagesize &&
+               !(IsAarch64() && IsLinux() && IsQemuUser())) {
       // MAP_GROWSDOWN doesn't work very well on qemu-aarch64
       pt->pt_attr.__stackaddr =
           mmap(0, pt->pt_attr.__stacksize, PROT_READ | PROT_WRITE,
@@ -32,6 +32,7 @@
 #include "libc/thread/posixthread.internal.h"
 #include "libc/thread/thread.h"
 #include "libc/thread/tls.h"
+#include "third_party/dlmalloc/dlmalloc.h"
 #include "third_party/nsync/futex.internal.h"
 #include "third_party/nsync/wait_s.internal.h"
 
@@ -130,6 +131,11 @@ wontreturn void pthread_exit(void *rc) {
     }
   }
 
+  // give memory cached by this thread back to malloc
+  if (_weaken(dlmalloc_thread_exit)) {
+    _weaken(dlmalloc_thread_exit)();
+  }
+
   // transition the thread to a terminated state
   status = atomic_load_explicit(&pt->pt_status, memory_order_acquire);
   do {
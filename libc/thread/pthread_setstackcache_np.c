@@ -0,0 +1,128 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
+#include "libc/intrin/dll.h"
+#include "libc/runtime/runtime.h"
+#include "libc/thread/posixthread.internal.h"
+#include "libc/thread/thread.h"
+
+// stacks of threads that have been joined or reaped are kept around
+// so pthread_create() doesn't need to mmap() a new one, and then pay
+// for munmap() and its tlb shootdowns once the thread is done. since
+// this is protected by _pthread_lock() which fork() holds, the child
+// gets a consistent list, whose mappings were copied along with it.
+
+struct PosixStack {
+  struct Dll elem;
+  size_t size;
+  size_t guard;
+};
+
+#define POSIXSTACK_CONTAINER(e) DLL_CONTAINER(struct PosixStack, elem, e)
+
+static struct {
+  int count;
+  int max;
+  struct Dll *list;
+} _pthread_stacks = {.max = 16};
+
+// the bookkeeping lives at the top of the cached stack itself
+static struct PosixStack *_pthread_stack_header(void *addr, size_t size) {
+  return (struct PosixStack *)((char *)addr + size) - 1;
+}
+
+/**
+ * Returns cached stack having exactly the given size and guard size.
+ *
+ * @return stack address, or null if caller should create a new stack
+ */
+void *_pthread_stack_take(size_t size, size_t guard) {
+  struct Dll *e;
+  void *addr = 0;
+  struct PosixStack *s;
+  _pthread_lock();
+  for (e = dll_first(_pthread_stacks.list); e;
+       e = dll_next(_pthread_stacks.list, e)) {
+    s = POSIXSTACK_CONTAINER(e);
+    if (s->size == size && s->guard == guard) {
+      dll_remove(&_pthread_stacks.list, e);
+      --_pthread_stacks.count;
+      addr = (char *)(s + 1) - size;
+      break;
+    }
+  }
+  _pthread_unlock();
+  return addr;
+}
+
+/**
+ * Offers stack of dead thread to the cache.
+ *
+ * @return true if cache took ownership, otherwise caller should unmap
+ */
+bool _pthread_stack_give(void *addr, size_t size, size_t guard) {
+  bool ok = false;
+  struct PosixStack *s;
+  s = _pthread_stack_header(addr, size);
+  _pthread_lock();
+  if (_pthread_stacks.count < _pthread_stacks.max) {
+    s->size = size;
+    s->guard = guard;
+    dll_init(&s->elem);
+    dll_make_first(&_pthread_stacks.list, &s->elem);
+    ++_pthread_stacks.count;
+    ok = true;
+  }
+  _pthread_unlock();
+  return ok;
+}
+
+/**
+ * Sets maximum number of thread stacks that are kept for reuse.
+ *
+ * When a thread that has its stack allocated by pthread_create() is
+ * joined or reaped, its stack is cached so a subsequent thread with
+ * the same stack size and guard size can start without mmap(). The
+ * default limit is 16. Lowering it unmaps any excess stacks at once.
+ *
+ * @param max is the number of stacks, where 0 disables the cache
+ * @return 0 on success, or errno on error
+ * @raise EINVAL if `max` is negative
+ */
+errno_t pthread_setstackcache_np(int max) {
+  struct Dll *e, *doomed = 0;
+  struct PosixStack *s;
+  if (max < 0)
+    return EINVAL;
+  _pthread_lock();
+  _pthread_stacks.max = max;
+  while (_pthread_stacks.count > max) {
+    e = dll_last(_pthread_stacks.list);
+    dll_remove(&_pthread_stacks.list, e);
+    dll_make_first(&doomed, e);
+    --_pthread_stacks.count;
+  }
+  _pthread_unlock();
+  while ((e = dll_first(doomed))) {
+    dll_remove(&doomed, e);
+    s = POSIXSTACK_CONTAINER(e);
+    munmap((char *)(s + 1) - s->size, s->size);
+  }
+  return 0;
+}
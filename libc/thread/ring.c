@@ -0,0 +1,233 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/ring.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/limits.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+#include "third_party/nsync/futex.internal.h"
+
+// bounded queue by dmitry vyukov. every cell has a sequence number that
+// says whose turn it is: a producer may fill the cell at position i when
+// its sequence is i, and a consumer may empty it when it's i+1. so each
+// side only contends on its own index, which lives on its own line.
+
+struct RingCell {
+  _Atomic(size_t) seq;
+  void *data;
+};
+
+struct RingSide {
+  _Alignas(64) _Atomic(size_t) pos;
+  _Atomic(unsigned) signal;   // futex incremented when other side moves
+  _Atomic(unsigned) waiters;  // threads sleeping on signal
+};
+
+struct CosmoRing {
+  size_t mask;
+  int flags;
+  struct RingSide push;
+  struct RingSide pop;
+  _Alignas(64) struct RingCell cells[];
+};
+
+static void RingWake(struct RingSide *s) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&s->waiters, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&s->signal, 1, memory_order_release);
+    nsync_futex_wake_((atomic_int *)&s->signal, 1, false);
+  }
+}
+
+// sleeps until `s` is signaled, where `f` is the nonblocking operation
+static errno_t RingWait(struct CosmoRing *r, struct RingSide *s,
+                        bool f(struct CosmoRing *, void **), void **x,
+                        const struct timespec *abstime) {
+  int rc;
+  unsigned sig;
+  for (;;) {
+    if (f(r, x))
+      return 0;
+    sig = atomic_load_explicit(&s->signal, memory_order_acquire);
+    atomic_fetch_add_explicit(&s->waiters, 1, memory_order_seq_cst);
+    if (f(r, x)) {
+      atomic_fetch_sub_explicit(&s->waiters, 1, memory_order_relaxed);
+      return 0;
+    }
+    rc = nsync_futex_wait_((atomic_int *)&s->signal, sig, false, abstime);
+    atomic_fetch_sub_explicit(&s->waiters, 1, memory_order_relaxed);
+    if (rc == -ETIMEDOUT && abstime &&
+        timespec_cmp(*abstime, timespec_real()) <= 0) {
+      return ETIMEDOUT;
+    }
+  }
+}
+
+static bool RingPush(struct CosmoRing *r, void **x) {
+  intptr_t dif;
+  size_t pos, seq;
+  struct RingCell *c;
+  pos = atomic_load_explicit(&r->push.pos, memory_order_relaxed);
+  for (;;) {
+    c = r->cells + (pos & r->mask);
+    seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+    if (!(dif = (intptr_t)seq - (intptr_t)pos)) {
+      if (r->flags & COSMO_RING_SP) {
+        atomic_store_explicit(&r->push.pos, pos + 1, memory_order_relaxed);
+        break;
+      }
+      if (atomic_compare_exchange_weak_explicit(&r->push.pos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;  // full
+    } else {
+      pos = atomic_load_explicit(&r->push.pos, memory_order_relaxed);
+    }
+  }
+  c->data = *x;
+  atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+  RingWake(&r->pop);
+  return true;
+}
+
+static bool RingPop(struct CosmoRing *r, void **x) {
+  intptr_t dif;
+  size_t pos, seq;
+  struct RingCell *c;
+  pos = atomic_load_explicit(&r->pop.pos, memory_order_relaxed);
+  for (;;) {
+    c = r->cells + (pos & r->mask);
+    seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+    if (!(dif = (intptr_t)seq - (intptr_t)(pos + 1))) {
+      if (r->flags & COSMO_RING_SC) {
+        atomic_store_explicit(&r->pop.pos, pos + 1, memory_order_relaxed);
+        break;
+      }
+      if (atomic_compare_exchange_weak_explicit(&r->pop.pos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;  // empty
+    } else {
+      pos = atomic_load_explicit(&r->pop.pos, memory_order_relaxed);
+    }
+  }
+  *x = c->data;
+  atomic_store_explicit(&c->seq, pos + r->mask + 1, memory_order_release);
+  RingWake(&r->push);
+  return true;
+}
+
+/**
+ * Creates bounded lock-free queue of pointers.
+ *
+ * Threads may push and pop concurrently from any number of threads. If
+ * it's known that only one thread pushes, or only one thread pops, then
+ * passing `COSMO_RING_SP` or `COSMO_RING_SC` lets that side avoid using
+ * compare and swap.
+ *
+ * @param capacity is rounded up to a two power
+ * @param flags may have `COSMO_RING_SP` and `COSMO_RING_SC`
+ * @return new ring, or null w/ errno
+ * @raise EINVAL if `capacity` is zero or too large
+ * @raise ENOMEM if we require more vespene gas
+ */
+struct CosmoRing *cosmo_ring_create(size_t capacity, int flags) {
+  size_t i, n;
+  struct CosmoRing *r;
+  if (!capacity || capacity > SIZE_MAX / 2 / sizeof(struct RingCell) ||
+      (flags & ~(COSMO_RING_SP | COSMO_RING_SC))) {
+    errno = EINVAL;
+    return 0;
+  }
+  for (n = 1; n < capacity; n <<= 1) {
+  }
+  if (!(r = memalign(64, sizeof(*r) + n * sizeof(struct RingCell))))
+    return 0;
+  bzero(r, sizeof(*r));
+  r->mask = n - 1;
+  r->flags = flags;
+  for (i = 0; i < n; ++i)
+    atomic_init(&r->cells[i].seq, i);
+  return r;
+}
+
+/**
+ * Adds pointer to back of ring if there's room.
+ *
+ * @return true if pushed, or false if ring is full
+ */
+bool cosmo_ring_trypush(struct CosmoRing *r, void *x) {
+  return RingPush(r, &x);
+}
+
+/**
+ * Removes pointer from front of ring if there's one.
+ *
+ * @return true if popped, or false if ring is empty
+ */
+bool cosmo_ring_trypop(struct CosmoRing *r, void **x) {
+  return RingPop(r, x);
+}
+
+/**
+ * Adds pointer to back of ring, waiting while it's full.
+ *
+ * Threads only sleep on a futex when the ring is full. Pushing onto a
+ * ring with room never makes a system call, unless a popper's asleep.
+ *
+ * @param abstime may be null to wait indefinitely and should contain
+ *     some arbitrary interval added to a `CLOCK_REALTIME` timestamp
+ * @return 0 on success, or errno on error
+ * @raise ETIMEDOUT if `abstime` was specified and the current time
+ *     exceeded its value
+ */
+errno_t cosmo_ring_push(struct CosmoRing *r, void *x,
+                        const struct timespec *abstime) {
+  return RingWait(r, &r->push, RingPush, &x, abstime);
+}
+
+/**
+ * Removes pointer from front of ring, waiting while it's empty.
+ *
+ * @param abstime may be null to wait indefinitely and should contain
+ *     some arbitrary interval added to a `CLOCK_REALTIME` timestamp
+ * @return 0 on success, or errno on error
+ * @raise ETIMEDOUT if `abstime` was specified and the current time
+ *     exceeded its value
+ */
+errno_t cosmo_ring_pop(struct CosmoRing *r, void **x,
+                       const struct timespec *abstime) {
+  return RingWait(r, &r->pop, RingPop, x, abstime);
+}
+
+/**
+ * Frees ring, which must not be in use.
+ */
+void cosmo_ring_destroy(struct CosmoRing *r) {
+  free(r);
+}
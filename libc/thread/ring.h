@@ -0,0 +1,39 @@
+#ifndef COSMOPOLITAN_LIBC_THREAD_RING_H_
+#define COSMOPOLITAN_LIBC_THREAD_RING_H_
+#include "libc/calls/struct/timespec.h"
+COSMOPOLITAN_C_START_
+
+#define COSMO_RING_SP 1 /* only one thread will ever push */
+#define COSMO_RING_SC 2 /* only one thread will ever pop */
+
+struct CosmoRing;
+
+struct CosmoMpscNode {
+  _Atomic(struct CosmoMpscNode *) next;
+};
+
+struct CosmoMpsc {
+  _Alignas(64) _Atomic(struct CosmoMpscNode *) head;
+  _Alignas(64) struct CosmoMpscNode *tail;
+  struct CosmoMpscNode stub;
+  _Atomic(unsigned) signal;
+  _Atomic(unsigned) waiters;
+};
+
+struct CosmoRing *cosmo_ring_create(size_t, int) libcesque;
+bool cosmo_ring_trypush(struct CosmoRing *, void *) libcesque;
+bool cosmo_ring_trypop(struct CosmoRing *, void **) libcesque;
+errno_t cosmo_ring_push(struct CosmoRing *, void *,
+                        const struct timespec *) libcesque;
+errno_t cosmo_ring_pop(struct CosmoRing *, void **,
+                       const struct timespec *) libcesque;
+void cosmo_ring_destroy(struct CosmoRing *) libcesque;
+
+void cosmo_mpsc_init(struct CosmoMpsc *) libcesque;
+void cosmo_mpsc_push(struct CosmoMpsc *, struct CosmoMpscNode *) libcesque;
+struct CosmoMpscNode *cosmo_mpsc_trypop(struct CosmoMpsc *) libcesque;
+errno_t cosmo_mpsc_pop(struct CosmoMpsc *, struct CosmoMpscNode **,
+                       const struct timespec *) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_THREAD_RING_H_ */
@@ -78,7 +78,15 @@ typedef struct pthread_mutexattr_s {
 } pthread_mutexattr_t;
 
 typedef struct pthread_cond_s {
-  void *_nsync[2];
+  union {
+    void *_nsync[2];
+    struct {
+      uint32_t _word;
+      char _pshared;
+      _Atomic(uint32_t) _sequence;
+      _Atomic(uint32_t) _waiters;
+    };
+  };
 } pthread_cond_t;
 
 typedef struct pthread_rwlock_s {
@@ -184,6 +192,7 @@ int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *, int) libcesque paramsn
 int pthread_setcancelstate(int, int *) libcesque;
 int pthread_setcanceltype(int, int *) libcesque;
 int pthread_setname_np(pthread_t, const char *) libcesque paramsnonnull();
+int pthread_setstackcache_np(int) libcesque;
 int pthread_setschedprio(pthread_t, int) libcesque;
 int pthread_setspecific(pthread_key_t, const void *) libcesque;
 int pthread_spin_destroy(pthread_spinlock_t *) libcesque paramsnonnull();
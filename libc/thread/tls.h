@@ -38,7 +38,8 @@ struct CosmoTib {
   uint32_t tib_sigstack_flags;
   void **tib_keys;
   void *tib_nsync;
-  void *tib_todo[7];
+  void *tib_tcache;
+  void *tib_todo[6];
 } __attribute__((__aligned__(64)));
 
 extern int __threaded;
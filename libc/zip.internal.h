@@ -65,6 +65,7 @@
 
 #define kZipCompressionNone    0
 #define kZipCompressionDeflate 8
+#define kZipCompressionZstd    93
 
 #define kZipCdirHdrMagic            ZM_(0x06054b50) /* PK♣♠ "PK\5\6" */
 #define kZipCdirHdrMagicTodo        ZM_(0x19184b50) /* PK♣♠ "PK\30\31" */
@@ -118,6 +119,7 @@
 #define kZipExtraUnix                0x000d
 #define kZipExtraExtendedTimestamp   0x5455
 #define kZipExtraInfoZipNewUnixExtra 0x7875
+#define kZipExtraFlushPoints         0x4643 /* deflate full flush offsets */
 
 #define kZipCfileMagic "PK\001\002"
 
@@ -282,6 +284,8 @@ uint64_t GetZipCdirCommentSize(const uint8_t *) libcesque;
 int64_t GetZipCfileCompressedSize(const uint8_t *) libcesque;
 int64_t GetZipCfileUncompressedSize(const uint8_t *) libcesque;
 int64_t GetZipCfileOffset(const uint8_t *) libcesque;
+const uint8_t *GetZipCfileFlushPoints(const uint8_t *, uint32_t *,
+                                      size_t *) libcesque;
 int64_t GetZipLfileCompressedSize(const uint8_t *) libcesque;
 int64_t GetZipLfileUncompressedSize(const uint8_t *) libcesque;
 
@@ -0,0 +1,93 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/http2.h"
+
+// number of huffman codes of each length, from 0 to 30 bits
+static const uint8_t kHpackHuffmanCount[31] = {
+    0,  0,  0,  0,  0,  10, 26, 32, 6,  0,  5,  3,  2,  6,  2,  3,
+    0,  0,  0,  3,  8,  13, 26, 29, 12, 4,  15, 19, 29, 0,  4,
+};
+
+// symbols sorted by code, since rfc7541 appendix b is canonical
+static const uint16_t kHpackHuffmanSymbol[257] = {
+    48,  49,  50,  97,  99,  101, 105, 111, 115, 116, 32,  37,
+    45,  46,  47,  51,  52,  53,  54,  55,  56,  57,  61,  65,
+    95,  98,  100, 102, 103, 104, 108, 109, 110, 112, 114, 117,
+    58,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,
+    77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  89,
+    106, 107, 113, 118, 119, 120, 121, 122, 38,  42,  44,  59,
+    88,  90,  33,  34,  40,  41,  63,  39,  43,  124, 35,  62,
+    0,   36,  64,  91,  93,  126, 94,  125, 60,  96,  123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161,
+    167, 172, 176, 177, 179, 209, 216, 217, 227, 229, 230, 129,
+    132, 133, 134, 136, 146, 154, 156, 160, 163, 164, 169, 170,
+    173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1,   135, 137, 138, 139, 140, 141, 143, 147, 149, 150,
+    151, 152, 155, 157, 158, 165, 166, 168, 174, 175, 180, 182,
+    183, 188, 191, 197, 231, 239, 9,   142, 144, 145, 148, 159,
+    171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243,
+    255, 203, 204, 211, 212, 214, 221, 222, 223, 241, 244, 245,
+    246, 247, 248, 250, 251, 252, 253, 254, 2,   3,   4,   5,
+    6,   7,   8,   11,  12,  14,  15,  16,  17,  18,  19,  20,
+    21,  23,  24,  25,  26,  27,  28,  29,  30,  31,  127, 220,
+    249, 10,  13,  22,  256,
+};
+
+/**
+ * Decodes HPACK Huffman encoded string.
+ *
+ * Since the code is canonical, each symbol is decoded one bit at a time
+ * the same way puff does it, counting the codes of each length.
+ *
+ * @param out receives decoded bytes, which aren't NUL-terminated
+ * @param size is byte capacity of `out`, where `n * 8 / 5` is enough
+ * @return decoded length, or -1 if invalid or `out` is too small
+ * @see RFC7541 § 5.2
+ */
+ssize_t DecodeHpackHuffman(char *out, size_t size, const char *in, size_t n) {
+  size_t i, j;
+  int bit, len, code, first, index, count;
+  for (j = len = code = first = index = 0, i = 0; i < n * 8; ++i) {
+    bit = (in[i >> 3] >> (7 - (i & 7))) & 1;
+    code |= bit;
+    ++len;
+    count = kHpackHuffmanCount[len];
+    if (code - count < first) {
+      index += code - first;
+      if (kHpackHuffmanSymbol[index] == 256)
+        return -1;  // eos must not be encoded
+      if (j == size)
+        return -1;
+      out[j++] = kHpackHuffmanSymbol[index];
+      len = code = first = index = 0;
+    } else {
+      if (len == 30)
+        return -1;
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
+    }
+  }
+  // padding must be shorter than a byte and be the msb of eos
+  if (len > 7 || (len && (code >> 1) != (1 << len) - 1))
+    return -1;
+  return j;
+}
@@ -0,0 +1,110 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/str/str.h"
+#include "libc/str/tab.internal.h"
+#include "net/http/http2.h"
+
+/**
+ * Encodes HPACK integer with prefix.
+ *
+ * @param p is output buffer, which needs at most 11 bytes
+ * @param bits is prefix length, e.g. 7
+ * @param flags are high bits to set in first byte, e.g. 0x80
+ * @return pointer to end of output
+ * @see RFC7541 § 5.1
+ */
+char *EncodeHpackInt(char *p, uint64_t x, int bits, int flags) {
+  uint64_t m;
+  m = (1 << bits) - 1;
+  if (x < m) {
+    *p++ = flags | x;
+  } else {
+    *p++ = flags | m;
+    for (x -= m; x >= 128; x >>= 7) {
+      *p++ = 128 | (x & 127);
+    }
+    *p++ = x;
+  }
+  return p;
+}
+
+/**
+ * Encodes HTTP/2 `:status` response pseudo-header.
+ *
+ * Common codes use the static table and take a single byte.
+ *
+ * @param p needs at least 5 bytes
+ * @return pointer to end of output
+ */
+char *EncodeHpackStatus(char *p, unsigned code) {
+  switch (code) {
+    case 200:
+      *p++ = 0x80 | 8;
+      break;
+    case 204:
+      *p++ = 0x80 | 9;
+      break;
+    case 206:
+      *p++ = 0x80 | 10;
+      break;
+    case 304:
+      *p++ = 0x80 | 11;
+      break;
+    case 400:
+      *p++ = 0x80 | 12;
+      break;
+    case 404:
+      *p++ = 0x80 | 13;
+      break;
+    case 500:
+      *p++ = 0x80 | 14;
+      break;
+    default:
+      *p++ = 8;  // literal without indexing using name at index 8
+      *p++ = 3;
+      *p++ = '0' + code / 100 % 10;
+      *p++ = '0' + code / 10 % 10;
+      *p++ = '0' + code % 10;
+      break;
+  }
+  return p;
+}
+
+/**
+ * Encodes HPACK header field as literal without indexing.
+ *
+ * Since the dynamic table isn't used, the encoder has no state, and
+ * the peer can't be made to waste memory remembering our responses.
+ * The name is lowercased as HTTP/2 requires.
+ *
+ * @param p needs `kn + vn + 23` bytes
+ * @return pointer to end of output
+ * @see RFC7541 § 6.2.2
+ */
+char *EncodeHpackHeader(char *p, const char *k, size_t kn, const char *v,
+                        size_t vn) {
+  size_t i;
+  *p++ = 0;
+  p = EncodeHpackInt(p, kn, 7, 0);
+  for (i = 0; i < kn; ++i) {
+    *p++ = kToLower[k[i] & 255];
+  }
+  p = EncodeHpackInt(p, vn, 7, 0);
+  return mempcpy(p, v, vn);
+}
@@ -1,7 +1,7 @@
-/*-*- mode:unix-assembly; indent-tabs-mode:t; tab-width:8; coding:utf-8     -*-│
-│ vi: set noet ft=asm ts=8 sw=8 fenc=utf-8                                 :vi │
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
 ╞══════════════════════════════════════════════════════════════════════════════╡
-│ Copyright 2021 Justine Alexandra Roberts Tunney                              │
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
 │                                                                              │
 │ Permission to use, copy, modify, and/or distribute this software for         │
 │ any purpose with or without fee is hereby granted, provided that the         │
@@ -16,10 +16,22 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
-#include "libc/thread/thread.h"
-#include "libc/macros.internal.h"
+#include "libc/serialize.h"
+#include "net/http/http2.h"
 
-	.init.start 200,_init__mmi
-	movb	$16,_mmi+8
-	movl	$_mmi+24,_mmi+16
-	.init.end 200,_init__mmi
+/**
+ * Formats HTTP/2 frame header.
+ *
+ * @param p needs at least `kHttp2FrameHdrSize` bytes
+ * @param length is byte length of payload, which must fit in 24 bits
+ * @return pointer to where payload goes
+ */
+char *FormatHttp2Frame(char *p, uint32_t length, int type, int flags,
+                       uint32_t stream) {
+  *p++ = length >> 16;
+  *p++ = length >> 8;
+  *p++ = length;
+  *p++ = type;
+  *p++ = flags;
+  return WRITE32BE(p, stream & 0x7fffffff);
+}
@@ -0,0 +1,126 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2021 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/assert.h"
+#include "libc/str/str.h"
+#include "net/http/http.h"
+
+static bool IsOws(int c) {
+  return c == ' ' || c == '\t';
+}
+
+// returns true if qvalue is zero, e.g. "0" or "0.000"
+static bool IsZeroQvalue(const char *p, const char *e) {
+  if (p == e || *p != '0')
+    return false;
+  for (++p; p < e && !IsOws(*p); ++p) {
+    if (*p != '.' && *p != '0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// returns 1 if element of list is s, 2 if it's "*", otherwise 0, and
+// sets *refused if the element has a weight of zero, e.g. "br;q=0"
+static int ParseAcceptElement(const char *p, const char *e, const char *s,
+                              size_t n, bool *refused) {
+  int r;
+  const char *t;
+  while (p < e && IsOws(*p))
+    ++p;
+  for (t = p; t < e && *t != ';' && !IsOws(*t); ++t) {
+  }
+  if (t - p == n && !strncasecmp(p, s, n)) {
+    r = 1;
+  } else if (t - p == 1 && *p == '*') {
+    r = 2;
+  } else {
+    return 0;
+  }
+  *refused = false;
+  for (p = t; p < e;) {
+    if (*p++ != ';')
+      continue;
+    while (p < e && IsOws(*p))
+      ++p;
+    if (e - p >= 2 && (p[0] == 'q' || p[0] == 'Q') && p[1] == '=') {
+      *refused = IsZeroQvalue(p + 2, e);
+    }
+  }
+  return r;
+}
+
+// scans comma separated list, e.g. "gzip, br;q=0.9, *;q=0"
+static void ParseAcceptList(const char *p, const char *e, const char *s,
+                            size_t n, int *named, int *star) {
+  int r;
+  bool refused;
+  const char *t;
+  for (; p < e; p = t + 1) {
+    if (!(t = memchr(p, ',', e - p)))
+      t = e;
+    if ((r = ParseAcceptElement(p, t, s, n, &refused)) == 1) {
+      *named = !refused;
+    } else if (r == 2) {
+      *star = !refused;
+    }
+  }
+}
+
+/**
+ * Returns true if standard header lists token as being acceptable.
+ *
+ * Unlike HeaderHas() this parses the header as a list of tokens, which
+ * are compared case-insensitively. A token with a weight of zero, e.g.
+ * `br;q=0`, is refused. If the token isn't listed, then the `*` token
+ * decides. For example, given `Accept-Encoding: gzip, *;q=0` this will
+ * return true for "gzip" and false for "br" or "zstd".
+ *
+ * @param m is message parsed by ParseHttpMessage
+ * @param b is buffer that ParseHttpMessage parsed
+ * @param h is known header, e.g. kHttpAcceptEncoding
+ * @param s is token, e.g. "gzip", which should not contain comma
+ * @param n is byte length of s where -1 implies strlen
+ * @return true if token is acceptable
+ */
+bool HeaderAccepts(struct HttpMessage *m, const char *b, int h, const char *s,
+                   size_t n) {
+  size_t i;
+  int named, star;
+  unassert(0 <= h && h < kHttpHeadersMax);
+  if (n == -1)
+    n = s ? strlen(s) : 0;
+  if (!n || !m->headers[h].a)
+    return false;
+  named = star = -1;
+  ParseAcceptList(b + m->headers[h].a, b + m->headers[h].b, s, n, &named,
+                  &star);
+  if (kHttpRepeatable[h]) {
+    for (i = 0; i < m->xheaders.n; ++i) {
+      if (GetHttpHeader(b + m->xheaders.p[i].k.a,
+                        m->xheaders.p[i].k.b - m->xheaders.p[i].k.a) == h) {
+        ParseAcceptList(b + m->xheaders.p[i].v.a, b + m->xheaders.p[i].v.b, s,
+                        n, &named, &star);
+      }
+    }
+  }
+  if (named != -1)
+    return named;
+  return star == 1;
+}
@@ -0,0 +1,317 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "net/http/http2.h"
+
+#define kHpackStaticEntries 61
+
+static const struct HpackStatic {
+  const char *name;
+  const char *value;
+} kHpackStatic[kHpackStaticEntries] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+/**
+ * Initializes HPACK decoder.
+ *
+ * @param limit is SETTINGS_HEADER_TABLE_SIZE advertised to peer
+ */
+void InitHpack(struct Hpack *h, uint32_t limit) {
+  bzero(h, sizeof(*h));
+  h->limit = limit;
+  h->maxsize = limit;
+}
+
+/**
+ * Frees HPACK decoder memory.
+ */
+void DestroyHpack(struct Hpack *h) {
+  uint32_t k;
+  for (k = 0; k < h->n; ++k) {
+    free(h->p[(h->i + k) % h->c].name);
+  }
+  free(h->p);
+  free(h->buf);
+  bzero(h, sizeof(*h));
+}
+
+static void EvictHpack(struct Hpack *h, uint32_t maxsize) {
+  struct HpackEntry *e;
+  while (h->size > maxsize) {
+    e = h->p + (h->i + h->n - 1) % h->c;
+    h->size -= e->namelen + e->valuelen + 32;
+    free(e->name);
+    --h->n;
+  }
+}
+
+static int AddHpack(struct Hpack *h, const char *k, size_t kn, const char *v,
+                    size_t vn) {
+  char *s;
+  uint32_t i, c;
+  struct HpackEntry *p;
+  // an entry larger than the table empties it and isn't added
+  if (kn + vn + 32 > h->maxsize) {
+    EvictHpack(h, 0);
+    return 0;
+  }
+  EvictHpack(h, h->maxsize - (kn + vn + 32));
+  if (h->n == h->c) {
+    c = h->c ? h->c * 2 : 16;
+    if (!(p = malloc(c * sizeof(*p))))
+      return -1;
+    for (i = 0; i < h->n; ++i) {
+      p[i] = h->p[(h->i + i) % h->c];
+    }
+    free(h->p);
+    h->p = p;
+    h->c = c;
+    h->i = 0;
+  }
+  if (!(s = malloc(kn + vn + 1)))
+    return -1;
+  h->i = (h->i + h->c - 1) % h->c;
+  h->p[h->i].name = memcpy(s, k, kn);
+  h->p[h->i].value = memcpy(s + kn, v, vn);
+  h->p[h->i].namelen = kn;
+  h->p[h->i].valuelen = vn;
+  h->size += kn + vn + 32;
+  ++h->n;
+  return 0;
+}
+
+static int GetHpack(struct Hpack *h, uint64_t x, const char **k, size_t *kn,
+                    const char **v, size_t *vn) {
+  struct HpackEntry *e;
+  if (!x) {
+    return -1;
+  } else if (x <= kHpackStaticEntries) {
+    *k = kHpackStatic[x - 1].name;
+    *kn = strlen(*k);
+    *v = kHpackStatic[x - 1].value;
+    *vn = strlen(*v);
+    return 0;
+  } else if ((x -= kHpackStaticEntries + 1) < h->n) {
+    e = h->p + (h->i + x) % h->c;
+    *k = e->name;
+    *kn = e->namelen;
+    *v = e->value;
+    *vn = e->valuelen;
+    return 0;
+  } else {
+    return -1;
+  }
+}
+
+static int DecodeHpackInt(const unsigned char **p, const unsigned char *e,
+                          int bits, uint64_t *r) {
+  int shift;
+  uint64_t x, m;
+  if (*p == e)
+    return -1;
+  m = (1 << bits) - 1;
+  if ((x = *(*p)++ & m) < m) {
+    *r = x;
+    return 0;
+  }
+  for (shift = 0; shift < 35; shift += 7) {
+    if (*p == e)
+      return -1;
+    x += (uint64_t)(**p & 127) << shift;
+    if (!(*(*p)++ & 128)) {
+      *r = x;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static int ReserveHpack(struct Hpack *h, size_t need) {
+  char *b;
+  if (need > h->bufn || !h->buf) {
+    need += 64;
+    if (!(b = realloc(h->buf, need)))
+      return -1;
+    h->buf = b;
+    h->bufn = need;
+  }
+  return 0;
+}
+
+// decodes string into buffer at offset
+static int DecodeHpackString(struct Hpack *h, const unsigned char **p,
+                             const unsigned char *e, size_t *off,
+                             size_t *len) {
+  bool huff;
+  uint64_t n;
+  ssize_t rc;
+  if (*p == e)
+    return -1;
+  huff = **p & 128;
+  if (DecodeHpackInt(p, e, 7, &n) == -1 || n > e - *p)
+    return -1;
+  if (ReserveHpack(h, *off + (huff ? n * 8 / 5 + 1 : n)) == -1)
+    return -1;
+  if (huff) {
+    if ((rc = DecodeHpackHuffman(h->buf + *off, h->bufn - *off,
+                                 (const char *)*p, n)) == -1) {
+      return -1;
+    }
+    *len = rc;
+  } else {
+    memcpy(h->buf + *off, *p, n);
+    *len = n;
+  }
+  *p += n;
+  return 0;
+}
+
+/**
+ * Decodes HPACK header block.
+ *
+ * The callback is invoked once for each header field in the order they
+ * appear. The name and value pointers are only valid during the call.
+ * This function must be called for every header block on a connection
+ * even if the stream is going to be refused, since the dynamic table
+ * state is shared by all streams.
+ *
+ * @return 0 on success, or -1 on compression error, which is fatal to
+ *     the connection since the decoder state is no longer in sync
+ * @see RFC7541
+ */
+int DecodeHpack(struct Hpack *h, const char *block, size_t size, hpack_f *f,
+                void *arg) {
+  uint64_t x;
+  int c, bits;
+  const char *k, *v;
+  size_t kn, vn, ko, vo;
+  bool sawfield, indexing;
+  const unsigned char *p, *e;
+  p = (const unsigned char *)block;
+  e = p + size;
+  sawfield = false;
+  while (p < e) {
+    c = *p;
+    if (c & 128) {
+      // indexed header field
+      if (DecodeHpackInt(&p, e, 7, &x) == -1 ||
+          GetHpack(h, x, &k, &kn, &v, &vn) == -1) {
+        return -1;
+      }
+      f(arg, k, kn, v, vn);
+      sawfield = true;
+    } else if ((c & 0xe0) == 0x20) {
+      // dynamic table size update, which must come before fields
+      if (sawfield || DecodeHpackInt(&p, e, 5, &x) == -1 || x > h->limit)
+        return -1;
+      h->maxsize = x;
+      EvictHpack(h, x);
+    } else {
+      // literal header field with incremental indexing (01xxxxxx),
+      // without indexing (0000xxxx), or never indexed (0001xxxx)
+      indexing = (c & 0xc0) == 0x40;
+      bits = indexing ? 6 : 4;
+      if (DecodeHpackInt(&p, e, bits, &x) == -1)
+        return -1;
+      ko = 0;
+      if (x) {
+        // copy name since adding the entry could evict where it's from
+        if (GetHpack(h, x, &k, &kn, &v, &vn) == -1 ||
+            ReserveHpack(h, kn) == -1) {
+          return -1;
+        }
+        memcpy(h->buf, k, kn);
+      } else if (DecodeHpackString(h, &p, e, &ko, &kn) == -1) {
+        return -1;
+      }
+      vo = kn;
+      if (DecodeHpackString(h, &p, e, &vo, &vn) == -1)
+        return -1;
+      k = h->buf + ko;
+      v = h->buf + vo;
+      if (indexing && AddHpack(h, k, kn, v, vn) == -1)
+        return -1;
+      f(arg, k, kn, v, vn);
+      sawfield = true;
+    }
+  }
+  return 0;
+}
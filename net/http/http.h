@@ -187,6 +187,8 @@ void InitHttpMessage(struct HttpMessage *, int);
 void DestroyHttpMessage(struct HttpMessage *);
 int ParseHttpMessage(struct HttpMessage *, const char *, size_t);
 bool HeaderHas(struct HttpMessage *, const char *, int, const char *, size_t);
+bool HeaderAccepts(struct HttpMessage *, const char *, int, const char *,
+                   size_t);
 int64_t ParseContentLength(const char *, size_t);
 char *FormatHttpDateTime(char[hasatleast 30], struct tm *);
 bool ParseHttpRange(const char *, size_t, long, long *, long *);
@@ -0,0 +1,88 @@
+#ifndef COSMOPOLITAN_NET_HTTP_HTTP2_H_
+#define COSMOPOLITAN_NET_HTTP_HTTP2_H_
+COSMOPOLITAN_C_START_
+
+#define kHttp2Preface      "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define kHttp2FrameHdrSize 9
+
+#define kHttp2Data         0
+#define kHttp2Headers      1
+#define kHttp2Priority     2
+#define kHttp2RstStream    3
+#define kHttp2Settings     4
+#define kHttp2PushPromise  5
+#define kHttp2Ping         6
+#define kHttp2Goaway       7
+#define kHttp2WindowUpdate 8
+#define kHttp2Continuation 9
+
+#define kHttp2FlagEndStream  0x01
+#define kHttp2FlagAck        0x01
+#define kHttp2FlagEndHeaders 0x04
+#define kHttp2FlagPadded     0x08
+#define kHttp2FlagPriority   0x20
+
+#define kHttp2SettingsHeaderTableSize      1
+#define kHttp2SettingsEnablePush           2
+#define kHttp2SettingsMaxConcurrentStreams 3
+#define kHttp2SettingsInitialWindowSize    4
+#define kHttp2SettingsMaxFrameSize         5
+#define kHttp2SettingsMaxHeaderListSize    6
+
+#define kHttp2NoError            0x0
+#define kHttp2ProtocolError      0x1
+#define kHttp2InternalError      0x2
+#define kHttp2FlowControlError   0x3
+#define kHttp2SettingsTimeout    0x4
+#define kHttp2StreamClosed       0x5
+#define kHttp2FrameSizeError     0x6
+#define kHttp2RefusedStream      0x7
+#define kHttp2Cancel             0x8
+#define kHttp2CompressionError   0x9
+#define kHttp2ConnectError       0xa
+#define kHttp2EnhanceYourCalm    0xb
+#define kHttp2InadequateSecurity 0xc
+#define kHttp2Http11Required     0xd
+
+#define kHttp2DefaultWindowSize   65535
+#define kHttp2DefaultMaxFrameSize 16384
+#define kHttp2DefaultHeaderTable  4096
+#define kHttp2MaxWindowSize       0x7fffffff
+#define kHttp2MaxMaxFrameSize     0xffffff
+
+struct Http2Frame {
+  uint32_t length;
+  uint8_t type;
+  uint8_t flags;
+  uint32_t stream;
+};
+
+struct Hpack {
+  uint32_t size;    /* sum of entry sizes as defined by rfc7541 § 4.1 */
+  uint32_t maxsize; /* current limit set by table size updates */
+  uint32_t limit;   /* limit we advertised with settings */
+  uint32_t i, n, c; /* ring buffer of entries where i is the newest */
+  struct HpackEntry {
+    char *name;
+    char *value;
+    uint32_t namelen;
+    uint32_t valuelen;
+  } *p;
+  size_t bufn;
+  char *buf;
+};
+
+typedef void hpack_f(void *, const char *, size_t, const char *, size_t);
+
+void ParseHttp2Frame(struct Http2Frame *, const char *);
+char *FormatHttp2Frame(char *, uint32_t, int, int, uint32_t);
+void InitHpack(struct Hpack *, uint32_t);
+void DestroyHpack(struct Hpack *);
+int DecodeHpack(struct Hpack *, const char *, size_t, hpack_f *, void *);
+ssize_t DecodeHpackHuffman(char *, size_t, const char *, size_t);
+char *EncodeHpackInt(char *, uint64_t, int, int);
+char *EncodeHpackStatus(char *, unsigned);
+char *EncodeHpackHeader(char *, const char *, size_t, const char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_NET_HTTP_HTTP2_H_ */
@@ -1,7 +1,7 @@
 /*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
 │ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
 ╞══════════════════════════════════════════════════════════════════════════════╡
-│ Copyright 2022 Justine Alexandra Roberts Tunney                              │
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
 │                                                                              │
 │ Permission to use, copy, modify, and/or distribute this software for         │
 │ any purpose with or without fee is hereby granted, provided that the         │
@@ -16,19 +16,18 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
-#include "libc/runtime/memtrack.internal.h"
+#include "libc/serialize.h"
+#include "net/http/http2.h"
 
-unsigned __find_memory(const struct MemoryIntervals *mm, int x) {
-  unsigned l, m, r;
-  l = 0;
-  r = mm->i;
-  while (l < r) {
-    m = (l & r) + ((l ^ r) >> 1);  // floor((a+b)/2)
-    if (mm->p[m].y < x) {
-      l = m + 1;
-    } else {
-      r = m;
-    }
-  }
-  return l;
+/**
+ * Parses HTTP/2 frame header.
+ *
+ * @param p must have at least `kHttp2FrameHdrSize` bytes
+ */
+void ParseHttp2Frame(struct Http2Frame *f, const char *p) {
+  const unsigned char *s = (const unsigned char *)p;
+  f->length = (uint32_t)s[0] << 16 | s[1] << 8 | s[2];
+  f->type = s[3];
+  f->flags = s[4];
+  f->stream = READ32BE(s + 5) & 0x7fffffff;
 }
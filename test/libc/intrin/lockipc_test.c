@@ -29,9 +29,31 @@
 
 struct SharedMemory {
   pthread_mutex_t mutex;
+  pthread_cond_t cond;
   volatile long x;
+  volatile bool go;
 } * shm;
 
+void WaitForProcesses(void) {
+  int e, ws, pid;
+  for (;;) {
+    e = errno;
+    if ((pid = waitpid(-1, &ws, 0)) != -1) {
+      if (WIFSIGNALED(ws)) {
+        kprintf("process %d terminated with %G\n", pid, WTERMSIG(ws));
+        testlib_incrementfailed();
+      } else if (WEXITSTATUS(ws)) {
+        kprintf("process %d exited with %d\n", pid, WEXITSTATUS(ws));
+        testlib_incrementfailed();
+      }
+    } else {
+      ASSERT_EQ(ECHILD, errno);
+      errno = e;
+      break;
+    }
+  }
+}
+
 void Worker(void) {
   long t;
   for (int i = 0; i < ITERATIONS; ++i) {
@@ -44,7 +66,7 @@ void Worker(void) {
 }
 
 TEST(lockipc, mutex) {
-  int e, rc, ws, pid;
+  int rc;
 
   // create shared memory
   shm = _mapshared(FRAMESIZE);
@@ -66,25 +88,64 @@ TEST(lockipc, mutex) {
     }
   }
 
-  // wait for processes to finish
-  for (;;) {
-    e = errno;
-    if ((pid = waitpid(-1, &ws, 0)) != -1) {
-      if (WIFSIGNALED(ws)) {
-        kprintf("process %d terminated with %G\n", pid, WTERMSIG(ws));
-        testlib_incrementfailed();
-      } else if (WEXITSTATUS(ws)) {
-        kprintf("process %d exited with %d\n", pid, WEXITSTATUS(ws));
-        testlib_incrementfailed();
-      }
-    } else {
-      ASSERT_EQ(ECHILD, errno);
-      errno = e;
-      break;
+  WaitForProcesses();
+
+  EXPECT_EQ(PROCESSES * ITERATIONS, shm->x);
+  ASSERT_EQ(0, pthread_mutex_destroy(&shm->mutex));
+  ASSERT_SYS(0, 0, munmap(shm, FRAMESIZE));
+}
+
+void Waiter(void) {
+  pthread_mutex_lock(&shm->mutex);
+  ++shm->x;
+  pthread_cond_broadcast(&shm->cond);
+  while (!shm->go) {
+    pthread_cond_wait(&shm->cond, &shm->mutex);
+  }
+  pthread_mutex_unlock(&shm->mutex);
+}
+
+TEST(lockipc, cond) {
+  int rc;
+
+  // create shared memory
+  shm = _mapshared(FRAMESIZE);
+
+  // create shared mutex and condition
+  pthread_mutexattr_t mattr;
+  pthread_mutexattr_init(&mattr);
+  pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+  pthread_mutex_init(&shm->mutex, &mattr);
+  pthread_mutexattr_destroy(&mattr);
+  pthread_condattr_t cattr;
+  pthread_condattr_init(&cattr);
+  ASSERT_EQ(0, pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED));
+  pthread_cond_init(&shm->cond, &cattr);
+  pthread_condattr_destroy(&cattr);
+
+  // create processes
+  for (int i = 0; i < PROCESSES; ++i) {
+    ASSERT_NE(-1, (rc = fork()));
+    if (!rc) {
+      Waiter();
+      _Exit(0);
     }
   }
 
-  EXPECT_EQ(PROCESSES * ITERATIONS, shm->x);
+  // wait for everyone to go to sleep, then wake them up
+  pthread_mutex_lock(&shm->mutex);
+  while (shm->x < PROCESSES) {
+    pthread_cond_wait(&shm->cond, &shm->mutex);
+  }
+  shm->go = true;
+  pthread_cond_broadcast(&shm->cond);
+  pthread_mutex_unlock(&shm->mutex);
+
+  WaitForProcesses();
+
+  EXPECT_EQ(PROCESSES, shm->x);
+  ASSERT_EQ(0, pthread_cond_destroy(&shm->cond));
   ASSERT_EQ(0, pthread_mutex_destroy(&shm->mutex));
   ASSERT_SYS(0, 0, munmap(shm, FRAMESIZE));
 }
@@ -0,0 +1,107 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/arena.h"
+#include "libc/dce.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoArena *a;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (a = cosmo_arena_create()));
+}
+
+void TearDown(void) {
+  cosmo_arena_destroy(a);
+}
+
+TEST(arena, alloc) {
+  char *p, *q;
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 3)));
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 3)));
+  EXPECT_EQ(0, (uintptr_t)p & 15);
+  EXPECT_EQ(0, (uintptr_t)q & 15);
+  EXPECT_NE(p, q);
+  strcpy(p, "hi");
+  strcpy(q, "yo");
+  EXPECT_STREQ("hi", p);
+}
+
+TEST(arena, memalign) {
+  char *p;
+  ASSERT_NE(NULL, (p = cosmo_arena_memalign(a, 4096, 10)));
+  EXPECT_EQ(0, (uintptr_t)p & 4095);
+  EXPECT_EQ(NULL, cosmo_arena_memalign(a, 3, 10));
+}
+
+TEST(arena, big_getsItsOwnChunk) {
+  char *p;
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 1000000)));
+  memset(p, 1, 1000000);
+  ASSERT_NE(NULL, cosmo_arena_alloc(a, 16));
+}
+
+TEST(arena, reset_reusesMemory) {
+  char *p, *q;
+  struct CosmoArenaMark m;
+  m = cosmo_arena_mark(a);
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 100)));
+  cosmo_arena_reset(a, &m);
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 100)));
+  EXPECT_EQ(p, q);
+  for (int i = 0; i < 10000; ++i)
+    ASSERT_NE(NULL, cosmo_arena_alloc(a, 100));
+  cosmo_arena_reset(a, 0);
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 100)));
+  EXPECT_EQ(p, q);
+}
+
+TEST(arena, push_redirectsMalloc) {
+  char *p, *q;
+  if (IsAsan())
+    return;
+  cosmo_arena_push(a);
+  ASSERT_NE(NULL, (p = strdup("hello")));
+  ASSERT_NE(NULL, (q = realloc(p, 100)));
+  EXPECT_STREQ("hello", q);
+  EXPECT_LE(100, malloc_usable_size(q));
+  free(q);
+  cosmo_arena_pop();
+  cosmo_arena_reset(a, 0);
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 1)));
+  EXPECT_EQ(p, q);
+  ASSERT_NE(NULL, (p = malloc(1)));
+  EXPECT_NE(p, q);
+  free(p);
+}
+
+BENCH(arena, bench) {
+  struct CosmoArenaMark m;
+  struct CosmoArena *a = cosmo_arena_create();
+  m = cosmo_arena_mark(a);
+  EZBENCH2("cosmo_arena_alloc", donothing, cosmo_arena_alloc(a, 32));
+  cosmo_arena_reset(a, &m);
+  EZBENCH2("malloc+free", donothing, free(malloc(32)));
+  cosmo_arena_push(a);
+  EZBENCH2("malloc+free (arena)", donothing, free(malloc(32)));
+  cosmo_arena_pop();
+  cosmo_arena_destroy(a);
+}
@@ -0,0 +1,186 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/cpuset.h"
+#include "libc/dce.h"
+#include "libc/intrin/atomic.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/runtime/runtime.h"
+#include "libc/testlib/subprocess.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+#include "libc/thread/thread2.h"
+
+/**
+ * @fileoverview tests for dlmalloc's per-cpu arenas
+ *
+ * Arenas are picked with sched_getcpu() when it's cheap, so the tests
+ * that need two arenas pin threads to cpus one and two, which map to
+ * distinct arenas other than gm whenever there's at least three cpus.
+ */
+
+#define SIZE 4000 /* too big for the thread caches */
+#define N    100
+
+struct Job {
+  int cpu;
+  void *p[N];
+  size_t owner;
+};
+
+static bool CanPin(void) {
+  return IsLinux() && X86_HAVE(RDTSCP) && __get_cpu_count() >= 3;
+}
+
+static bool Pin(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set) &&
+         sched_getcpu() == cpu;
+}
+
+// with FOOTERS, the word after each in-use chunk is its arena xor a
+// secret, so two chunks have the same footer iff they share an arena
+static size_t Owner(void *p) {
+  size_t size = ((size_t *)p)[-1] & ~(size_t)7;
+  return *(size_t *)((char *)p - 16 + size);
+}
+
+static void *Allocate(void *arg) {
+  int i;
+  struct Job *job = arg;
+  if (!Pin(job->cpu))
+    return 0;
+  for (i = 0; i < N; ++i) {
+    job->p[i] = malloc(SIZE);
+    if (Owner(job->p[i]) != Owner(job->p[0]))
+      return 0;
+  }
+  job->owner = Owner(job->p[0]);
+  return job;
+}
+
+static bool Spawn(struct Job job[2]) {
+  int i;
+  void *res[2];
+  pthread_t th[2];
+  for (i = 0; i < 2; ++i) {
+    job[i].cpu = i + 1;
+    if (pthread_create(th + i, 0, Allocate, job + i))
+      return false;
+  }
+  for (i = 0; i < 2; ++i)
+    if (pthread_join(th[i], res + i))
+      return false;
+  return res[0] && res[1];
+}
+
+TEST(arenas, pinnedThreads_getDistinctArenas) {
+  int i;
+  struct Job job[2] = {0};
+  if (!CanPin() || !Spawn(job))
+    return;
+  ASSERT_NE(job[0].owner, job[1].owner);
+  // freed by another thread, chunks still go home through their footers
+  for (i = 0; i < N; ++i) {
+    free(job[0].p[i]);
+    free(job[1].p[i]);
+  }
+  ASSERT_TRUE(Spawn(job));
+  ASSERT_NE(job[0].owner, job[1].owner);
+  for (i = 0; i < N; ++i) {
+    free(job[1].p[i]);
+    free(job[0].p[i]);
+  }
+}
+
+TEST(arenas, statsTrimAndBulkFree_coverEveryArena) {
+  int i;
+  struct mallinfo mi;
+  struct Job job[2] = {0};
+  size_t used, footprint;
+  if (!CanPin() || !Spawn(job))
+    return;
+  mi = mallinfo();
+  used = mi.uordblks;
+  ASSERT_GE(used, 2 * N * SIZE);
+  ASSERT_EQ(0, bulk_free(job[0].p, N));
+  ASSERT_EQ(0, bulk_free(job[1].p, N));
+  for (i = 0; i < N; ++i) {
+    ASSERT_EQ(NULL, job[0].p[i]);
+    ASSERT_EQ(NULL, job[1].p[i]);
+  }
+  mi = mallinfo();
+  ASSERT_GE(used - mi.uordblks, 2 * N * SIZE);
+  footprint = malloc_footprint();
+  ASSERT_EQ(1, malloc_trim(0));
+  ASSERT_LT(malloc_footprint(), footprint);
+  ASSERT_LT(mallinfo().arena, mi.arena);
+}
+
+static atomic_int stop;
+
+static void *Hammer(void *arg) {
+  void *p;
+  if (CanPin())
+    Pin((intptr_t)arg % __get_cpu_count());
+  while (!atomic_load(&stop)) {
+    p = malloc(SIZE);
+    free(malloc(SIZE / 2));
+    free(p);
+  }
+  return 0;
+}
+
+static void *Churn(void *arg) {
+  int i;
+  void *p[N];
+  for (i = 0; i < N; ++i)
+    p[i] = malloc(SIZE);
+  for (i = 0; i < N; ++i)
+    free(p[i]);
+  return arg;
+}
+
+TEST(arenas, forkWhileOtherThreadsHoldArenaLocks) {
+  int i, j;
+  pthread_t th[4], t[4];
+  stop = 0;
+  for (i = 0; i < 4; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Hammer, (void *)(intptr_t)i));
+  for (i = 0; i < 20; ++i) {
+    SPAWN(fork);
+    // every lock must be usable, including those of arenas whose owner
+    // threads didn't make it into the child
+    ASSERT_NE(0, mallinfo().arena);
+    malloc_trim(0);
+    Churn(0);
+    for (j = 0; j < 4; ++j)
+      ASSERT_EQ(0, pthread_create(t + j, 0, Churn, 0));
+    for (j = 0; j < 4; ++j)
+      ASSERT_EQ(0, pthread_join(t[j], 0));
+    EXITS(0);
+  }
+  stop = 1;
+  for (i = 0; i < 4; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+}
@@ -178,6 +178,44 @@ TEST(memalign, roundsUpAlignmentToTwoPower) {
   free(p);
 }
 
+TEST(mallopt, hugepages) {
+  if (!IsLinux()) {
+    ASSERT_EQ(0, mallopt(M_HUGEPAGES, 1));
+    return;
+  }
+  SPAWN(fork);
+  ASSERT_EQ(1, mallopt(M_HUGEPAGES, 1));
+  ASSERT_EQ(1, mallopt(M_HUGEPAGES, 0));
+  EXITS(0);
+}
+
+TEST(mallopt, hugepages_growsHeapInAlignedRegions) {
+  char *p;
+  size_t huge, before, during;
+  if (!IsLinux())
+    return;
+  SPAWN(fork);
+  huge = 2 * 1024 * 1024;
+  ASSERT_EQ(1, mallopt(M_HUGEPAGES, 1));
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 64 * 1024 * 1024));
+  before = mallinfo().hblks;
+  ASSERT_NE(NULL, (p = malloc(4 * huge)));
+  memset(p, 1, 4 * huge);
+  // nothing else fits a chunk this big, so it's carved out of the start
+  // of a new segment, right after its header
+  ASSERT_EQ(2 * sizeof(size_t), (uintptr_t)p & (huge - 1));
+  during = mallinfo().hblks;
+  ASSERT_GE(during - before, 4 * huge);
+  ASSERT_EQ(0, during % huge);
+  free(p);
+  malloc_trim(0);
+  ASSERT_LE(mallinfo().hblks, before + huge);
+  ASSERT_NE(NULL, (p = malloc(4 * huge)));
+  memset(p, 2, 4 * huge);
+  free(p);
+  EXITS(0);
+}
+
 void *bulk[1024];
 
 void BulkFreeBenchSetup(void) {
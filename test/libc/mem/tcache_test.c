@@ -0,0 +1,164 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/dce.h"
+#include "libc/intrin/atomic.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/testlib/subprocess.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview tests for dlmalloc's per-thread caches
+ *
+ * Cached chunks are counted as allocated by mallinfo(), so uordblks
+ * is used to observe when chunks go back to the arenas.
+ */
+
+#define TCACHE_CAP 32 /* see third_party/dlmalloc/threadcache.inc */
+
+static void *Nothing(void *arg) {
+  return 0;
+}
+
+// the caches are only used once the program has become threaded
+void SetUpOnce(void) {
+  pthread_t th;
+  ASSERT_EQ(0, pthread_create(&th, 0, Nothing, 0));
+  ASSERT_EQ(0, pthread_join(th, 0));
+}
+
+static long Allocated(void) {
+  return mallinfo().uordblks;
+}
+
+static void *AllocateMany(void *arg) {
+  int i;
+  void **p = arg;
+  for (i = 0; i < 100; ++i)
+    p[i] = malloc(40);
+  return 0;
+}
+
+TEST(tcache, crossThreadFree_goesIntoFreeingThreadsCache) {
+  int i;
+  pthread_t th;
+  void *p[100];
+  ASSERT_EQ(0, pthread_create(&th, 0, AllocateMany, p));
+  ASSERT_EQ(0, pthread_join(th, 0));
+  for (i = 0; i < 100; ++i) {
+    ASSERT_NE(NULL, p[i]);
+    memset(p[i], i, 40);
+  }
+  for (i = 0; i < 100; ++i)
+    free(p[i]);
+  // the last chunk freed is the first one handed back out
+  ASSERT_EQ(p[99], malloc(40));
+  free(p[99]);
+}
+
+TEST(tcache, doubleFree_aborts) {
+  if (IsTiny())
+    return;  // built with PROCEED_ON_ERROR
+  SPAWN(fork);
+  void *p;
+  ASSERT_NE(NULL, (p = malloc(40)));
+  free(p);
+  free(p);
+  EXITS(44);
+}
+
+TEST(tcache, overflow_drainsBackToArena) {
+  int i;
+  long before;
+  void *p[100];
+  for (i = 0; i < 100; ++i)
+    ASSERT_NE(NULL, (p[i] = malloc(72)));
+  before = Allocated();
+  for (i = 0; i < 100; ++i)
+    free(p[i]);
+  // at most TCACHE_CAP chunks of this size may stay in the cache
+  ASSERT_GE(before - Allocated(), (100 - TCACHE_CAP) * 72);
+}
+
+static void *Churn(void *arg) {
+  int i, j;
+  void *p[20];
+  for (j = 16; j <= 256; j += 16) {
+    for (i = 0; i < 20; ++i)
+      p[i] = malloc(j);
+    for (i = 0; i < 20; ++i)
+      free(p[i]);
+  }
+  return 0;
+}
+
+static long Leftover(void *(*func)(void *)) {
+  pthread_t th;
+  long before = Allocated();
+  ASSERT_EQ(0, pthread_create(&th, 0, func, 0));
+  ASSERT_EQ(0, pthread_join(th, 0));
+  return Allocated() - before;
+}
+
+TEST(tcache, threadExit_returnsCachedMemory) {
+  long idle;
+  Leftover(Nothing);
+  idle = Leftover(Nothing);
+  // without dlmalloc_thread_exit() ~40kb would stay in the dead cache
+  ASSERT_LT(Leftover(Churn) - idle, 4096);
+}
+
+static atomic_int stop;
+
+static void *Worker(void *arg) {
+  void *p;
+  while (!atomic_load(&stop)) {
+    p = malloc(32);
+    free(malloc(200));
+    free(p);
+  }
+  return 0;
+}
+
+TEST(tcache, forkFromMultithreadedParent_childCanMalloc) {
+  int i, j, k;
+  pthread_t th[4], t;
+  void *p[100];
+  stop = 0;
+  for (i = 0; i < 4; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Worker, 0));
+  for (i = 0; i < 10; ++i) {
+    SPAWN(fork);
+    for (k = 0; k < 3; ++k) {
+      for (j = 0; j < 100; ++j)
+        ASSERT_NE(NULL, (p[j] = malloc(16 + j * 2)));
+      for (j = 0; j < 100; ++j)
+        free(p[j]);
+    }
+    ASSERT_EQ(0, pthread_create(&t, 0, Churn, 0));
+    ASSERT_EQ(0, pthread_join(t, 0));
+    EXITS(0);
+  }
+  stop = 1;
+  for (i = 0; i < 4; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+}
@@ -0,0 +1,113 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/internal.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/testlib/blocktronics.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/hyperion.h"
+#include "libc/testlib/moby.h"
+#include "libc/testlib/testlib.h"
+#include "libc/testlib/viewables.h"
+#include "libc/thread/pool.h"
+#include "third_party/zlib/zlib.h"
+
+#define SPAN 262144
+
+char *corpus;
+size_t corpussize;
+uint8_t *z, points[1024];
+size_t zsize, npoints;
+
+// builds a few megabytes of html/text-like content and compresses it
+// the same way zipobj does for large files
+void SetUpOnce(void) {
+  z_stream zs = {0};
+  size_t i, n, m = 8 * 1024 * 1024;
+  const char *s[] = {kHyperion, kMoby, kBlocktronics, kViewables};
+  size_t k[] = {kHyperionSize, kMobySize, kBlocktronicsSize, kViewablesSize};
+  corpus = malloc(m);
+  for (i = 0; corpussize + k[i % 4] <= m; ++i) {
+    memcpy(corpus + corpussize, s[i % 4], k[i % 4]);
+    corpussize += k[i % 4];
+  }
+  z = malloc((n = compressBound(corpussize)));
+  ASSERT_EQ(Z_OK, deflateInit2(&zs, 6, Z_DEFLATED, -MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY));
+  zs.next_in = (void *)corpus;
+  zs.next_out = z;
+  zs.avail_out = n;
+  for (i = 0; i + SPAN < corpussize; i += SPAN) {
+    if (i)
+      WRITE32LE(points + npoints++ * 4, zs.total_out);
+    zs.avail_in = SPAN;
+    ASSERT_EQ(Z_OK, deflate(&zs, Z_FULL_FLUSH));
+  }
+  WRITE32LE(points + npoints++ * 4, zs.total_out);
+  zs.avail_in = corpussize - i;
+  ASSERT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  ASSERT_EQ(Z_OK, deflateEnd(&zs));
+  zsize = zs.total_out;
+}
+
+TEST(inflate, test) {
+  char *p = gc(malloc(corpussize));
+  ASSERT_EQ(0, __inflate(p, corpussize, z, zsize));
+  ASSERT_EQ(0, memcmp(corpus, p, corpussize));
+}
+
+TEST(inflate_segments, test) {
+  char *p = gc(malloc(corpussize));
+  ASSERT_EQ(0, __inflate_segments(p, corpussize, z, zsize, SPAN, points,
+                                  npoints));
+  ASSERT_EQ(0, memcmp(corpus, p, corpussize));
+}
+
+TEST(inflate_segments, corrupt) {
+  char *p = gc(malloc(corpussize));
+  uint8_t *y = gc(memcpy(malloc(zsize), z, zsize));
+  y[READ32LE(points + 4 * 4)] = 0xff;  // reserved block type
+  ASSERT_NE(0, __inflate_segments(p, corpussize, y, zsize, SPAN, points,
+                                  npoints));
+}
+
+TEST(inflate_segments, threaded) {
+  // a pool of our own makes the process threaded, which is needed
+  // before __inflate_segments() will use the pool it keeps
+  struct CosmoPool *pool;
+  char *p = gc(malloc(corpussize));
+  uint8_t *y = gc(memcpy(malloc(zsize), z, zsize));
+  ASSERT_NE(NULL, (pool = cosmo_pool_create(1)));
+  ASSERT_EQ(0, __inflate_segments(p, corpussize, z, zsize, SPAN, points,
+                                  npoints));
+  ASSERT_EQ(0, memcmp(corpus, p, corpussize));
+  y[READ32LE(points + (npoints - 1) * 4)] = 0xff;
+  ASSERT_NE(0, __inflate_segments(p, corpussize, y, zsize, SPAN, points,
+                                  npoints));
+  cosmo_pool_destroy(pool);
+}
+
+BENCH(inflate, bench) {
+  char *p = gc(malloc(corpussize));
+  EZBENCH2("__inflate", donothing, __inflate(p, corpussize, z, zsize));
+  EZBENCH2("__inflate_segments", donothing,
+           __inflate_segments(p, corpussize, z, zsize, SPAN, points, npoints));
+}
@@ -24,6 +24,7 @@
 #include "libc/mem/mem.h"
 #include "libc/runtime/memtrack.internal.h"
 #include "libc/runtime/runtime.h"
+#include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/testlib/testlib.h"
@@ -37,65 +38,112 @@ void SetUpOnce(void) {
   ASSERT_SYS(0, 0, pledge("stdio rpath", 0));
 }
 
+struct Intervals {
+  int i;
+  struct MemoryInterval p[OPEN_MAX];
+};
+
+static int GetMemoryIntervalHeight(const struct MemoryInterval *e) {
+  return e ? e->height : 0;
+}
+
+static bool IsMemoryTreeOk(const struct MemoryInterval *e,
+                           const struct MemoryInterval *parent) {
+  int l, r;
+  if (!e)
+    return true;
+  if (e->parent != parent) {
+    STRACE("IsMemoryTreeOk() parent link is wrong!");
+    return false;
+  }
+  l = GetMemoryIntervalHeight(e->left);
+  r = GetMemoryIntervalHeight(e->right);
+  if (e->height != MAX(l, r) + 1 || l - r > 1 || r - l > 1) {
+    STRACE("IsMemoryTreeOk() tree isn't balanced!");
+    return false;
+  }
+  return IsMemoryTreeOk(e->left, e) && IsMemoryTreeOk(e->right, e);
+}
+
 bool AreMemoryIntervalsOk(const struct MemoryIntervals *mm) {
   /* asan runtime depends on this function */
-  int i;
+  size_t i;
   size_t wantsize;
-  for (i = 0; i < mm->i; ++i) {
-    if (mm->p[i].y < mm->p[i].x) {
+  struct MemoryInterval *e, *p;
+  if (!IsMemoryTreeOk(mm->root, 0))
+    return false;
+  for (i = 0, p = 0, e = __first_memory(mm); e; p = e, e = __next_memory(e)) {
+    ++i;
+    if (e->y < e->x) {
       STRACE("AreMemoryIntervalsOk() y should be >= x!");
       return false;
     }
-    wantsize = (size_t)(mm->p[i].y - mm->p[i].x) * FRAMESIZE;
-    if (!(wantsize < mm->p[i].size && mm->p[i].size <= wantsize + FRAMESIZE)) {
+    wantsize = (size_t)(e->y - e->x) * FRAMESIZE;
+    if (!(wantsize < e->size && e->size <= wantsize + FRAMESIZE)) {
       STRACE("AreMemoryIntervalsOk(%p) size is wrong!"
              " %'zu not within %'zu .. %'zu",
-             (uintptr_t)mm->p[i].x << 16, mm->p[i].size, wantsize,
-             wantsize + FRAMESIZE);
+             (uintptr_t)e->x << 16, e->size, wantsize, wantsize + FRAMESIZE);
       return false;
     }
-    if (i) {
-      if (mm->p[i].h != -1 || mm->p[i - 1].h != -1) {
-        if (mm->p[i].x <= mm->p[i - 1].y) {
+    if (p) {
+      if (e->h != -1 || p->h != -1) {
+        if (e->x <= p->y) {
           return false;
         }
       } else {
-        if (!(mm->p[i - 1].y + 1 <= mm->p[i].x)) {
+        if (!(p->y + 1 <= e->x)) {
           STRACE("AreMemoryIntervalsOk() out of order or overlap!");
           return false;
         }
       }
     }
   }
+  if (i != mm->i) {
+    STRACE("AreMemoryIntervalsOk() interval count is wrong!");
+    return false;
+  }
   return true;
 }
 
-static bool AreMemoryIntervalsEqual(const struct MemoryIntervals *mm1,
-                                    const struct MemoryIntervals *mm2) {
-  if (mm1->i != mm2->i)
-    return false;
-  if (memcmp(mm1->p, mm2->p, mm1->i * sizeof(*mm2->p)) != 0)
+static bool AreMemoryIntervalsEqual(const struct MemoryIntervals *mm,
+                                    const struct Intervals *t) {
+  int i;
+  struct MemoryInterval *e;
+  if (mm->i != t->i)
     return false;
+  for (i = 0, e = __first_memory(mm); e; ++i, e = __next_memory(e)) {
+    if (e->x != t->p[i].x || e->y != t->p[i].y || e->h != t->p[i].h ||
+        e->size != t->p[i].size || e->offset != t->p[i].offset ||
+        e->flags != t->p[i].flags || e->prot != t->p[i].prot ||
+        e->iscow != t->p[i].iscow ||
+        e->readonlyfile != t->p[i].readonlyfile) {
+      return false;
+    }
+  }
   return true;
 }
 
 static void PrintMemoryInterval(const struct MemoryIntervals *mm) {
-  int i;
-  for (i = 0; i < mm->i; ++i) {
-    if (i)
+  struct MemoryInterval *e;
+  for (e = __first_memory(mm); e; e = __next_memory(e)) {
+    if (e != __first_memory(mm))
       fprintf(stderr, ",");
-    fprintf(stderr, "{%d,%d}", mm->p[i].x, mm->p[i].y);
+    fprintf(stderr, "{%d,%d}", e->x, e->y);
   }
   fprintf(stderr, "\n");
 }
 
-static void CheckMemoryIntervalsEqual(const struct MemoryIntervals *mm1,
-                                      const struct MemoryIntervals *mm2) {
-  if (!AreMemoryIntervalsEqual(mm1, mm2)) {
+static void CheckMemoryIntervalsEqual(const struct MemoryIntervals *mm,
+                                      const struct Intervals *t) {
+  int i;
+  if (!AreMemoryIntervalsEqual(mm, t)) {
     kprintf("got:\n");
-    PrintMemoryIntervals(2, mm1);
+    PrintMemoryIntervals(2, mm);
     kprintf("want:\n");
-    PrintMemoryIntervals(2, mm2);
+    for (i = 0; i < t->i; ++i) {
+      kprintf("%08x-%08x h=%ld size=%'zu\n", t->p[i].x, t->p[i].y, t->p[i].h,
+              t->p[i].size);
+    }
     CHECK(!"memory intervals not equal");
     exit(1);
   }
@@ -109,10 +157,19 @@ static void CheckMemoryIntervalsAreOk(const struct MemoryIntervals *mm) {
   }
 }
 
-static void RunTrackMemoryIntervalTest(const struct MemoryIntervals t[2], int x,
+static struct MemoryIntervals *NewMemoryIntervals(const struct Intervals *t) {
+  struct MemoryIntervals *mm;
+  mm = memset(memalign(64, sizeof(*mm)), 0, sizeof(*mm));
+  memcpy(mm->s, t->p, t->i * sizeof(*t->p));
+  mm->n = t->i;
+  __rebuild_memory(mm, mm->s, t->i);
+  return mm;
+}
+
+static void RunTrackMemoryIntervalTest(const struct Intervals t[2], int x,
                                        int y, long h) {
   struct MemoryIntervals *mm;
-  mm = memcpy(memalign(64, sizeof(*t)), t, sizeof(*t));
+  mm = NewMemoryIntervals(t);
   CheckMemoryIntervalsAreOk(mm);
   CHECK_NE(-1, __track_memory(mm, x, y, h, 0, 0, 0, 0, 0,
                               (y - x) * FRAMESIZE + FRAMESIZE));
@@ -121,27 +178,25 @@ static void RunTrackMemoryIntervalTest(const struct MemoryIntervals t[2], int x,
   free(mm);
 }
 
-static int RunReleaseMemoryIntervalsTest(const struct MemoryIntervals t[2],
-                                         int x, int y) {
+static int RunReleaseMemoryIntervalsTest(const struct Intervals t[2], int x,
+                                         int y) {
   int rc;
   struct MemoryIntervals *mm;
-  mm = memcpy(memalign(64, sizeof(*t)), t, sizeof(*t));
+  mm = NewMemoryIntervals(t);
   CheckMemoryIntervalsAreOk(mm);
   if ((rc = __untrack_memory(mm, x, y, NULL)) != -1) {
     CheckMemoryIntervalsAreOk(mm);
-    CheckMemoryIntervalsEqual(t + 1, mm);
+    CheckMemoryIntervalsEqual(mm, t + 1);
   }
   free(mm);
   return rc;
 }
 
 TEST(__track_memory, TestEmpty) {
-  static struct MemoryIntervals mm[2] = {
-      {0, OPEN_MAX, 0, {}},
-      {1, OPEN_MAX, 0, {{2, 2, 0, FRAMESIZE}}},
+  static const struct Intervals mm[2] = {
+      {0, {}},
+      {1, {{2, 2, 0, FRAMESIZE}}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 2, 2, 0);
 }
 
@@ -150,7 +205,7 @@ TEST(__track_memory, TestFull) {
   int i;
   struct MemoryIntervals *mm;
   mm = calloc(1, sizeof(struct MemoryIntervals));
-  for (i = 0; i < mm->n; ++i) {
+  for (i = 0; i < ARRAYLEN(mm->s); ++i) {
     CheckMemoryIntervalsAreOk(mm);
     CHECK_NE(-1, __track_memory(mm, i, i, i, 0, 0, 0, 0, 0, 0));
     CheckMemoryIntervalsAreOk(mm);
@@ -163,60 +218,48 @@ TEST(__track_memory, TestFull) {
 }
 
 TEST(__track_memory, TestAppend) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(2, 2)}},
-      {1, OPEN_MAX, 0, {I(2, 3)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(2, 2)}},
+      {1, {I(2, 3)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 3, 3, 0);
 }
 
 TEST(__track_memory, TestPrepend) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(2, 2)}},
-      {1, OPEN_MAX, 0, {I(1, 2)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(2, 2)}},
+      {1, {I(1, 2)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 1, 1, 0);
 }
 
 TEST(__track_memory, TestFillHole) {
-  static struct MemoryIntervals mm[2] = {
-      {4, OPEN_MAX, 0, {I(1, 1), I(3, 4), {5, 5, 1, FRAMESIZE}, I(6, 8)}},
-      {3, OPEN_MAX, 0, {I(1, 4), {5, 5, 1, FRAMESIZE}, I(6, 8)}},
+  static const struct Intervals mm[2] = {
+      {4, {I(1, 1), I(3, 4), {5, 5, 1, FRAMESIZE}, I(6, 8)}},
+      {3, {I(1, 4), {5, 5, 1, FRAMESIZE}, I(6, 8)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 2, 2, 0);
 }
 
 TEST(__track_memory, TestAppend2) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(2, 2)}},
-      {2, OPEN_MAX, 0, {I(2, 2), {3, 3, 1, FRAMESIZE}}},
+  static const struct Intervals mm[2] = {
+      {1, {I(2, 2)}},
+      {2, {I(2, 2), {3, 3, 1, FRAMESIZE}}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 3, 3, 1);
 }
 
 TEST(__track_memory, TestPrepend2) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(2, 2)}},
-      {2, OPEN_MAX, 0, {{1, 1, 1, FRAMESIZE}, I(2, 2)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(2, 2)}},
+      {2, {{1, 1, 1, FRAMESIZE}, I(2, 2)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 1, 1, 1);
 }
 
 TEST(__track_memory, TestFillHole2) {
-  static struct MemoryIntervals mm[2] = {
+  static const struct Intervals mm[2] = {
       {4,
-       OPEN_MAX,
-       0,
        {
            I(1, 1),
            I(3, 4),
@@ -224,8 +267,6 @@ TEST(__track_memory, TestFillHole2) {
            I(6, 8),
        }},
       {5,
-       OPEN_MAX,
-       0,
        {
            I(1, 1),
            {2, 2, 1, FRAMESIZE},
@@ -234,162 +275,187 @@ TEST(__track_memory, TestFillHole2) {
            {6, 8, 0, FRAMESIZE * 3},
        }},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   RunTrackMemoryIntervalTest(mm, 2, 2, 1);
 }
 
 TEST(__find_memory, Test) {
-  static struct MemoryIntervals mm[1] = {
+  static const struct Intervals t = {
+      4,
       {
-          4,
-          OPEN_MAX,
-          0,
-          {
-              [0] = {1, 1},
-              [1] = {3, 4},
-              [2] = {5, 5, 1},
-              [3] = {6, 8},
-          },
+          [0] = {1, 1},
+          [1] = {3, 4},
+          [2] = {5, 5, 1},
+          [3] = {6, 8},
       },
   };
-  mm[0].p = mm[0].s;
-  EXPECT_EQ(0, __find_memory(mm, 0));
-  EXPECT_EQ(0, __find_memory(mm, 1));
-  EXPECT_EQ(1, __find_memory(mm, 2));
-  EXPECT_EQ(1, __find_memory(mm, 3));
-  EXPECT_EQ(1, __find_memory(mm, 4));
-  EXPECT_EQ(2, __find_memory(mm, 5));
-  EXPECT_EQ(3, __find_memory(mm, 6));
-  EXPECT_EQ(3, __find_memory(mm, 7));
-  EXPECT_EQ(3, __find_memory(mm, 8));
-  EXPECT_EQ(4, __find_memory(mm, 9));
+  struct MemoryIntervals *mm = NewMemoryIntervals(&t);
+  EXPECT_EQ(mm->s + 0, __find_memory(mm, 0));
+  EXPECT_EQ(mm->s + 0, __find_memory(mm, 1));
+  EXPECT_EQ(mm->s + 1, __find_memory(mm, 2));
+  EXPECT_EQ(mm->s + 1, __find_memory(mm, 3));
+  EXPECT_EQ(mm->s + 1, __find_memory(mm, 4));
+  EXPECT_EQ(mm->s + 2, __find_memory(mm, 5));
+  EXPECT_EQ(mm->s + 3, __find_memory(mm, 6));
+  EXPECT_EQ(mm->s + 3, __find_memory(mm, 7));
+  EXPECT_EQ(mm->s + 3, __find_memory(mm, 8));
+  EXPECT_EQ(NULL, __find_memory(mm, 9));
+  free(mm);
 }
 
 TEST(__untrack_memory, TestEmpty) {
-  static struct MemoryIntervals mm[2] = {
-      {0, OPEN_MAX, 0, {}},
-      {0, OPEN_MAX, 0, {}},
+  static const struct Intervals mm[2] = {
+      {0, {}},
+      {0, {}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 2, 2));
 }
 
 TEST(__untrack_memory, TestRemoveElement_UsesInclusiveRange) {
-  static struct MemoryIntervals mm[2] = {
-      {3, OPEN_MAX, 0, {I(0, 0), I(2, 2), I(4, 4)}},
-      {2, OPEN_MAX, 0, {I(0, 0), I(4, 4)}},
+  static const struct Intervals mm[2] = {
+      {3, {I(0, 0), I(2, 2), I(4, 4)}},
+      {2, {I(0, 0), I(4, 4)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 2, 2));
 }
 
 TEST(__untrack_memory, TestPunchHole) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(0, 9)}},
-      {2, OPEN_MAX, 0, {I(0, 3), I(6, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {2, {I(0, 3), I(6, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 4, 5));
 }
 
 TEST(__untrack_memory, TestShortenLeft) {
   if (IsWindows())
     return;
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(0, 9)}},
-      {1, OPEN_MAX, 0, {I(0, 7)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {1, {I(0, 7)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 8, 9));
 }
 
 TEST(__untrack_memory, TestShortenRight) {
   if (IsWindows())
     return;
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(0, 9)}},
-      {1, OPEN_MAX, 0, {I(3, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {1, {I(3, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 0, 2));
 }
 
 TEST(__untrack_memory, TestShortenLeft2) {
   if (IsWindows())
     return;
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(0, 9)}},
-      {1, OPEN_MAX, 0, {I(0, 7)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {1, {I(0, 7)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 8, 11));
 }
 
 TEST(__untrack_memory, TestShortenRight2) {
   if (IsWindows())
     return;
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(0, 9)}},
-      {1, OPEN_MAX, 0, {I(3, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {1, {I(3, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, -3, 2));
 }
 
 TEST(__untrack_memory, TestZeroZero) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(3, 9)}},
-      {1, OPEN_MAX, 0, {I(3, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(3, 9)}},
+      {1, {I(3, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 0, 0));
 }
 
 TEST(__untrack_memory, TestNoopLeft) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(3, 9)}},
-      {1, OPEN_MAX, 0, {I(3, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(3, 9)}},
+      {1, {I(3, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 1, 2));
 }
 
 TEST(__untrack_memory, TestNoopRight) {
-  static struct MemoryIntervals mm[2] = {
-      {1, OPEN_MAX, 0, {I(3, 9)}},
-      {1, OPEN_MAX, 0, {I(3, 9)}},
+  static const struct Intervals mm[2] = {
+      {1, {I(3, 9)}},
+      {1, {I(3, 9)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 10, 10));
 }
 
 TEST(__untrack_memory, TestBigFree) {
-  static struct MemoryIntervals mm[2] = {
-      {2, OPEN_MAX, 0, {I(0, 3), I(6, 9)}},
-      {0, OPEN_MAX, 0, {}},
+  static const struct Intervals mm[2] = {
+      {2, {I(0, 3), I(6, 9)}},
+      {0, {}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, INT_MIN, INT_MAX));
 }
 
 TEST(__untrack_memory, TestWeirdGap) {
-  static struct MemoryIntervals mm[2] = {
-      {3, OPEN_MAX, 0, {I(10, 10), I(20, 20), I(30, 30)}},
-      {2, OPEN_MAX, 0, {I(10, 10), I(30, 30)}},
+  static const struct Intervals mm[2] = {
+      {3, {I(10, 10), I(20, 20), I(30, 30)}},
+      {2, {I(10, 10), I(30, 30)}},
   };
-  mm[0].p = mm[0].s;
-  mm[1].p = mm[1].s;
   EXPECT_NE(-1, RunReleaseMemoryIntervalsTest(mm, 15, 25));
 }
+
+TEST(__untrack_memory, TestPunchHoleThenFill) {
+  static const struct Intervals mm[2] = {
+      {1, {I(0, 9)}},
+      {1, {I(0, 9)}},
+  };
+  struct MemoryIntervals *m = NewMemoryIntervals(mm);
+  ASSERT_NE(-1, __untrack_memory(m, 4, 5, NULL));
+  ASSERT_EQ(2, m->i);
+  ASSERT_NE(-1, __track_memory(m, 4, 5, 0, 0, 0, 0, 0, 0, FRAMESIZE * 2));
+  CheckMemoryIntervalsAreOk(m);
+  CheckMemoryIntervalsEqual(m, mm + 1);
+  free(m);
+}
+
+// compares the tree against an array of which handle owns each frame
+// there's only room for 16 nodes, since the slab belongs to _mmi
+TEST(__track_memory, fuzzAgainstFrameArray) {
+  long want[16];
+  long h;
+  int i, j, x, y, k, f;
+  struct MemoryInterval *e;
+  struct MemoryIntervals *mm;
+  static const struct Intervals empty;
+  for (k = 0; k < 100; ++k) {
+    mm = NewMemoryIntervals(&empty);
+    for (i = 0; i < 16; ++i)
+      want[i] = -1;
+    for (i = 0; i < 200; ++i) {
+      x = lemur64() % 16;
+      y = x + lemur64() % (16 - x);
+      ASSERT_NE(-1, __untrack_memory(mm, x, y, NULL));
+      for (j = x; j <= y; ++j)
+        want[j] = -1;
+      if (lemur64() & 1) {
+        h = lemur64() & 1;
+        ASSERT_NE(-1, __track_memory(mm, x, y, h, 0, 0, 0, 0, 0,
+                                     (size_t)(y - x + 1) * FRAMESIZE));
+        for (j = x; j <= y; ++j)
+          want[j] = h;
+      }
+      CheckMemoryIntervalsAreOk(mm);
+      for (f = 0, e = __first_memory(mm); e; e = __next_memory(e)) {
+        for (; f < e->x; ++f)
+          ASSERT_EQ(-1, want[f]);
+        for (; f <= e->y; ++f)
+          ASSERT_EQ(want[f], e->h);
+      }
+      for (; f < 16; ++f)
+        ASSERT_EQ(-1, want[f]);
+    }
+    free(mm);
+  }
+}
@@ -18,6 +18,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "ape/sections.internal.h"
 #include "libc/calls/calls.h"
+#include "libc/calls/struct/timespec.h"
 #include "libc/calls/ucontext.h"
 #include "libc/dce.h"
 #include "libc/errno.h"
@@ -45,6 +46,7 @@
 #include "libc/sysv/consts/sig.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
 #include "libc/x/xspawn.h"
 #include "third_party/xed/x86.h"
 
@@ -260,15 +262,27 @@ TEST(mmap, ziposCannotBeAnonymous) {
   close(fd);
 }
 
-TEST(mmap, ziposCannotBeShared) {
+TEST(mmap, ziposCannotBeSharedWritable) {
   int fd;
   void *p;
   ASSERT_NE(-1, (fd = open(ziposLifePath, O_RDONLY), "%s", ziposLifePath));
   EXPECT_SYS(EINVAL, MAP_FAILED,
-             (p = mmap(NULL, 0x00010000, PROT_READ, MAP_SHARED, fd, 0)));
+             (p = mmap(NULL, 0x00010000, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0)));
   close(fd);
 }
 
+TEST(mmap, ziposSharedReadonly) {
+  int fd;
+  void *p;
+  ASSERT_NE(-1, (fd = open(ziposLifePath, O_RDONLY), "%s", ziposLifePath));
+  EXPECT_NE(MAP_FAILED,
+            (p = mmap(NULL, 0x00010000, PROT_READ, MAP_SHARED, fd, 0)));
+  EXPECT_STREQN("\177ELF", ((const char *)p), 4);
+  EXPECT_NE(-1, munmap(p, 0x00010000));
+  EXPECT_NE(-1, close(fd));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // zipos NON-SHARED READ-ONLY FILE MEMORY
 
@@ -484,3 +498,75 @@ BENCH(mmap, bench) {
   EZBENCH2("mmap", donothing, BenchMmapPrivate());
   EZBENCH2("munmap", donothing, BenchUnmap());
 }
+
+#define MAPPERS 8
+#define MAPS    2000
+
+void *Mapper(void *arg) {
+  int i, j;
+  void *t, **maps = arg;
+  for (i = 0; i < MAPS; ++i) {
+    maps[i] = mmap(0, FRAMESIZE, PROT_READ | PROT_WRITE,
+                   MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (maps[i] == MAP_FAILED)
+      abort();
+  }
+  // unmap in random order so holes open up all over the intervals
+  for (i = MAPS; i > 1; --i) {
+    j = _rand64() % i;
+    t = maps[i - 1];
+    maps[i - 1] = maps[j];
+    maps[j] = t;
+  }
+  for (i = 0; i < MAPS; ++i) {
+    if (munmap(maps[i], FRAMESIZE))
+      abort();
+  }
+  return 0;
+}
+
+BENCH(mmap, manySmallMapsFromManyThreads) {
+  int i;
+  struct timespec t1;
+  pthread_t th[MAPPERS];
+  void **maps = gc(malloc(MAPPERS * MAPS * sizeof(void *)));
+  t1 = timespec_real();
+  for (i = 0; i < MAPPERS; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Mapper, maps + i * MAPS));
+  for (i = 0; i < MAPPERS; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+  printf("%d threads mapped and unmapped %d frames in %g seconds\n", MAPPERS,
+         MAPPERS * MAPS,
+         timespec_tonanos(timespec_sub(timespec_real(), t1)) / 1e9);
+}
+
+#define INTERVALS 20000
+
+char *dense;
+
+void BenchRemapMiddle(void) {
+  char *p = dense + (INTERVALS / 2 + count++ % 64 * 2) * FRAMESIZE;
+  if (munmap(p, FRAMESIZE))
+    abort();
+  if (mmap(p, FRAMESIZE, PROT_READ, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE,
+           -1, 0) != p)
+    abort();
+}
+
+// alternating protections keep each frame its own interval, which used
+// to make every insert or removal in the middle memmove the tail half
+BENCH(mmap, remapInTheMiddleOfManyIntervals) {
+  int i;
+  size_t n = (size_t)INTERVALS * FRAMESIZE;
+  dense = mmap(0, n, PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  ASSERT_NE(MAP_FAILED, dense);
+  for (i = 1; i < INTERVALS; i += 2)
+    ASSERT_EQ(dense + (size_t)i * FRAMESIZE,
+              mmap(dense + (size_t)i * FRAMESIZE, FRAMESIZE,
+                   PROT_READ | PROT_WRITE,
+                   MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+  ASSERT_GE(_mmi.i, INTERVALS);
+  count = 0;
+  EZBENCH2("remap middle", donothing, BenchRemapMiddle());
+  ASSERT_SYS(0, 0, munmap(dense, n));
+}
@@ -30,12 +30,16 @@
 #include "libc/testlib/subprocess.h"
 #include "libc/testlib/testlib.h"
 #include "libc/thread/thread.h"
+#include "third_party/zlib/zlib.h"
 
 __static_yoink("zipos");
 __static_yoink("libc/testlib/hyperion.txt");
 __static_yoink("inflate");
 __static_yoink("inflateInit2");
 __static_yoink("inflateEnd");
+__static_yoink("inflateReset");
+__static_yoink("inflatePrime");
+__static_yoink("inflateSetDictionary");
 
 void *Worker(void *arg) {
   int i, fd;
@@ -63,6 +67,18 @@ TEST(zipos, test) {
   __print_maps();
 }
 
+TEST(zipos, sharedContent_outlivesOtherHandles) {
+  char *b1 = gc(malloc(kHyperionSize));
+  char *b2 = gc(malloc(kHyperionSize));
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
+  ASSERT_SYS(0, 4, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
+  ASSERT_SYS(0, 100, read(3, b1, 100));
+  ASSERT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, kHyperionSize, read(4, b2, kHyperionSize));
+  ASSERT_EQ(0, memcmp(b2, kHyperion, kHyperionSize));
+  ASSERT_SYS(0, 0, close(4));
+}
+
 TEST(zipos, erofs) {
   ASSERT_SYS(EROFS, -1, creat("/zip/foo.txt", 0644));
 }
@@ -182,3 +198,32 @@ TEST(zipos, ultraPosixAtomicSeekRead) {
   EXPECT_EQ(960, lseek(3, 0, SEEK_CUR));
   ASSERT_SYS(0, 0, close(3));
 }
+
+TEST(zipos_stream, inflatesOnDemand) {
+  z_stream zs = {0};
+  struct ZiposStream *s;
+  size_t i, n = 5 * 1024 * 1024;
+  char *p = gc(malloc(n));
+  char *z = gc(malloc(n));
+  char *b = gc(malloc(n));
+  for (i = 0; i < n; ++i)
+    p[i] = "0123456789abcdef"[(i * 2654435761u >> 13) % (i % 7 + 10)];
+  ASSERT_EQ(Z_OK, deflateInit2(&zs, 6, Z_DEFLATED, -MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY));
+  zs.next_in = (void *)p;
+  zs.avail_in = n;
+  zs.next_out = (void *)z;
+  zs.avail_out = n;
+  ASSERT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  ASSERT_EQ(Z_OK, deflateEnd(&zs));
+  ASSERT_NE(NULL, (s = __zipos_stream_open(z, zs.total_out, n, 0)));
+  for (i = 0; i < n; i += 4000)
+    ASSERT_EQ(MIN(4000, n - i), __zipos_stream_pread(s, b + i, 4000, i));
+  ASSERT_EQ(0, memcmp(p, b, n));
+  for (i = n - 5000; i > 777777; i -= 777777) {
+    ASSERT_EQ(5000, __zipos_stream_pread(s, b, 5000, i));
+    ASSERT_EQ(0, memcmp(p + i, b, 5000));
+  }
+  ASSERT_EQ(0, __zipos_stream_pread(s, b, 1, n));
+  __zipos_stream_close(s);
+}
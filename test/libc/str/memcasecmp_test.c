@@ -30,4 +30,7 @@ TEST(memcasecmp, test) {
   EXPECT_EQ(+17, memcasecmp("yelloyello", "HELLOHELLO", 10));
   EXPECT_EQ(0, memcasecmp("\0ELLo\0ELLo", "\0ELLO\0ELLO", 10));
   EXPECT_NE(0, memcasecmp("\0ELLo\0ELLo", "\0ELL-\0ELL-", 10));
+  EXPECT_EQ(-1, memcasecmp("hellohellohelloX", "hellohellohelloY", 16));
+  EXPECT_EQ(-1, memcasecmp("hellohellohellohellohellohellohelloX",
+                           "HELLOHELLOHELLOHELLOHELLOHELLOHELLOY", 36));
 }
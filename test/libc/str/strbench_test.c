@@ -0,0 +1,222 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/str/tab.internal.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/moby.h"
+#include "libc/testlib/testlib.h"
+
+/**
+ * @fileoverview string function throughput by size bucket
+ *
+ * The sizes straddle each vector width, so that every function goes
+ * through its 16, 32 and 64 byte loops, as well as their tails. The
+ * benchmarks report bytes per tsc cycle, where bigger is better.
+ */
+
+#define MAXSIZE 65536
+
+static const size_t kSizes[] = {
+    1,  7,   15,  16,  31,  32,   33,   63,   64,   100,  127,
+    128, 255, 256, 511, 1024, 4095, 4096, 16384, 65536,
+};
+
+static char *a, *b;
+
+void SetUpOnce(void) {
+  a = malloc(MAXSIZE + 1);
+  b = malloc(MAXSIZE + 1);
+}
+
+// fills a with text that doesn't contain '@' or '~', and b with the
+// same text in upper case; both are nul-terminated after n bytes
+static void Fill(size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    a[i] = kMoby[i % kMobySize];
+    if (a[i] == '@' || a[i] == '~' || !a[i])
+      a[i] = ' ';
+    b[i] = kToUpper[a[i] & 255];
+  }
+  a[n] = 0;
+  b[n] = 0;
+}
+
+static void Report(const char *name, size_t n, double cycles) {
+  printf(" *     %-16s n=%-8zu %8.2f bytes/cycle\n", name, n,
+         n / (cycles < 1 ? 1 : cycles));
+}
+
+#define BENCH_BYTES(NAME, SIZE, EXPR)                             \
+  do {                                                            \
+    EXPR;                                                         \
+    Report(NAME, SIZE, BENCHLOOPER(__startbench, __endbench, 64, \
+                                   (EXPR)));                      \
+  } while (0)
+
+static void *NaiveMemmem(const char *h, size_t n, const char *q, size_t k) {
+  size_t i;
+  for (i = 0; i + k <= n; ++i)
+    if (!memcmp(h + i, q, k))
+      return (char *)h + i;
+  return 0;
+}
+
+static void CheckEverySizeAndAlignment(void) {
+  char *p;
+  size_t i, j, n;
+  for (i = 0; i < ARRAYLEN(kSizes) && kSizes[i] <= 1024; ++i) {
+    for (j = 0; j < 64; ++j) {
+      n = kSizes[i];
+      Fill(n + j);
+      p = a + j;
+      ASSERT_EQ(n, strlen(p));
+      ASSERT_EQ(NULL, memchr(p, '@', n));
+      ASSERT_EQ(NULL, memrchr(p, '@', n));
+      ASSERT_EQ(n, strspn(p, p));
+      ASSERT_EQ(n, strcspn(p, "@~"));
+      ASSERT_EQ(NULL, strpbrk(p, "@~"));
+      ASSERT_EQ(0, memcasecmp(p, b + j, n));
+      p[n - 1] = '@';
+      ASSERT_EQ(p + n - 1, memchr(p, '@', n));
+      ASSERT_EQ(p + n - 1, memrchr(p, '@', n));
+      ASSERT_EQ(p + n - 1, strpbrk(p, "~@"));
+      ASSERT_EQ(n - 1, strcspn(p, "~@"));
+      ASSERT_NE(0, memcasecmp(p, b + j, n));
+      ASSERT_EQ(NaiveMemmem(p, n, p + n / 2, n - n / 2),
+                memmem(p, n, p + n / 2, n - n / 2));
+      ASSERT_EQ(NaiveMemmem(p, n, "e@", 2), memmem(p, n, "e@", 2));
+      ASSERT_EQ(p + n - 1, strstr(p, "@"));
+      ASSERT_EQ(p + n - 1, strcasestr(p, "@"));
+      b[j + n - 1] = '@';
+      if (n > 1)
+        ASSERT_EQ(b + j + n - 2, strcasestr(b + j, p + n - 2));
+    }
+  }
+}
+
+static char *NaiveStrcasestr(const char *h, const char *q) {
+  size_t i;
+  for (;; ++h) {
+    for (i = 0; q[i] && kToLower[h[i] & 255] == kToLower[q[i] & 255]; ++i) {
+    }
+    if (!q[i])
+      return (char *)h;
+    if (!*h)
+      return 0;
+  }
+}
+
+static size_t NaiveStrspn(const char *s, const char *set, bool reject) {
+  size_t i;
+  for (i = 0; s[i] && !strchr(set, s[i]) == reject; ++i) {
+  }
+  return i;
+}
+
+// uses a small alphabet so that needles and sets match often, and puts
+// the nul at random offsets, so vector loops see it in every lane
+static void CheckRandomStrings(void) {
+  int i, j, n, k;
+  char *p, q[8];
+  static const char kAlphabet[] = "abAB@~ \x80";
+  for (i = 0; i < 20000; ++i) {
+    p = a + lemur64() % 64;
+    n = lemur64() % 300;
+    k = 1 + lemur64() % 5;
+    for (j = 0; j < n + 32; ++j)
+      p[j] = kAlphabet[lemur64() % (sizeof(kAlphabet) - 1)];
+    for (j = 0; j < k; ++j)
+      q[j] = kAlphabet[lemur64() % (sizeof(kAlphabet) - 1)];
+    p[n] = 0;
+    q[k] = 0;
+    ASSERT_EQ(NaiveMemmem(p, n, q, k), strstr(p, q));
+    ASSERT_EQ(NaiveMemmem(p, n, q, k), memmem(p, n, q, k));
+    ASSERT_EQ(NaiveStrcasestr(p, q), strcasestr(p, q));
+    ASSERT_EQ(NaiveStrspn(p, q, false), strspn(p, q));
+    ASSERT_EQ(NaiveStrspn(p, q, true), strcspn(p, q));
+    ASSERT_EQ(p + NaiveStrspn(p, q, true), strpbrk(p, q) ?: p + n);
+  }
+}
+
+TEST(strbench, everySizeAndAlignment_agreesWithNaive) {
+  CheckEverySizeAndAlignment();
+}
+
+TEST(strbench, randomStrings_agreeWithNaive) {
+  CheckRandomStrings();
+}
+
+#ifdef __x86_64__
+
+// clears cpuid bits so the dispatchers pick the narrower code paths
+static void CheckWithout(unsigned bits) {
+  unsigned *ebx, save;
+  ebx = (unsigned *)&KCPUIDS(7H, EBX);
+  save = *ebx;
+  *ebx &= ~bits;
+  CheckEverySizeAndAlignment();
+  CheckRandomStrings();
+  *ebx = save;
+}
+
+TEST(strbench, avx2_agreesWithNaive) {
+  if (!X86_HAVE(AVX2))
+    return;
+  CheckWithout(1u << X86_BIT(AVX512BW));
+}
+
+TEST(strbench, sse_agreesWithNaive) {
+  CheckWithout(1u << X86_BIT(AVX512BW) | 1u << X86_BIT(AVX2));
+}
+
+#endif /* __x86_64__ */
+
+BENCH(strbench, bench) {
+  size_t i, n;
+  if (X86_HAVE(AVX512BW)) {
+    printf(" *     using avx512bw\n");
+  } else if (X86_HAVE(AVX2)) {
+    printf(" *     using avx2\n");
+  }
+#ifdef __aarch64__
+  printf(" *     using neon\n");
+#endif
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    Fill((n = kSizes[i]));
+    printf("\n");
+    BENCH_BYTES("memchr", n, __expropriate(memchr(a, '@', n)));
+    BENCH_BYTES("memrchr", n, __expropriate(memrchr(a, '@', n)));
+    BENCH_BYTES("strlen", n, __expropriate(strlen(a)));
+    BENCH_BYTES("memmem", n, __expropriate(memmem(a, n, "the@", 4)));
+    BENCH_BYTES("strstr", n, __expropriate(strstr(a, "the@")));
+    BENCH_BYTES("strcasestr", n, __expropriate(strcasestr(a, "THE@")));
+    BENCH_BYTES("strspn", n,
+                __expropriate(strspn(a, " etaoinshrdlucmfwygpbvkxjqz"
+                                        "ETAOINSHRDLUCMFWYGPBVKXJQZ"
+                                        "0123456789\n,.;:!?'\"-()*_&[]#")));
+    BENCH_BYTES("strcspn", n, __expropriate(strcspn(a, "@~")));
+    BENCH_BYTES("strpbrk", n, __expropriate(strpbrk(a, "@~")));
+    BENCH_BYTES("memcasecmp", n, __expropriate(memcasecmp(a, b, n)));
+  }
+}
@@ -102,6 +102,7 @@ TEST(strcasestr, test) {
   ASSERT_EQ(NULL, strcasestr("-Wl,--gc-sections", "stack-protector"));
   ASSERT_EQ(NULL, strcasestr("-Wl,--gc-sections", "sanitize"));
   ASSERT_STREQ("x", strcasestr("x", "x"));
+  ASSERT_STREQ("GCC", strcasestr("X86_64-LINUX-MUSL-GCC", "gcc"));
 }
 
 /*
@@ -0,0 +1,91 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2022 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+#include "third_party/nsync/mu.h"
+
+__static_yoink("nsync_mu_profile_lock_");
+
+#define THREADS    4
+#define ITERATIONS 20000
+
+nsync_mu mu;
+volatile long counter;
+
+static void *Contend(void *arg) {
+  int i;
+  for (i = 0; i < ITERATIONS; ++i) {
+    nsync_mu_lock(&mu);
+    ++counter;
+    nsync_mu_unlock(&mu);
+  }
+  return 0;
+}
+
+// runs when this test re-executes itself with LOCKPROF=1, in which case
+// the profiler prints its report to stderr once we call exit()
+__attribute__((__constructor__)) static textstartup void TestInit(int argc,
+                                                                  char **argv) {
+  int i;
+  pthread_t th[THREADS];
+  if (argc == 2 && !strcmp(argv[1], "contend")) {
+    for (i = 0; i < THREADS; ++i)
+      pthread_create(th + i, 0, Contend, 0);
+    for (i = 0; i < THREADS; ++i)
+      pthread_join(th[i], 0);
+    exit(counter == THREADS * ITERATIONS ? 0 : 1);
+  }
+}
+
+TEST(lockprof, reportsContendedLock) {
+  ssize_t rc;
+  size_t n = 0;
+  int ws, pid, sites, fds[2];
+  static char buf[65536];
+  char mubuf[32], *p;
+  ASSERT_SYS(0, 0, pipe(fds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    dup2(fds[1], 2);
+    execve(GetProgramExecutableName(),
+           (char *const[]){GetProgramExecutableName(), "contend", 0},
+           (char *const[]){"LOCKPROF=1", 0});
+    _Exit(127);
+  }
+  close(fds[1]);
+  while ((rc = read(fds[0], buf + n, sizeof(buf) - 1 - n)) > 0)
+    n += rc;
+  buf[n] = 0;
+  close(fds[0]);
+  ASSERT_NE(-1, wait(&ws));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(0, WEXITSTATUS(ws));
+  ASSERT_NE(NULL, (p = strstr(buf, "lockprof: ")));
+  ASSERT_EQ(1, sscanf(p, "lockprof: %d contended lock sites", &sites));
+  ASSERT_GE(sites, 1);
+  ASSERT_NE(NULL, strstr(p, "wait_us"));
+  // the contended site is our mutex
+  snprintf(mubuf, sizeof(mubuf), "%#lx", (unsigned long)&mu);
+  ASSERT_NE(NULL, strstr(p, mubuf));
+}
@@ -0,0 +1,76 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/pool.h"
+#include "libc/atomic.h"
+#include "libc/intrin/atomic.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoPool *pool;
+atomic_long total;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (pool = cosmo_pool_create(4)));
+  total = 0;
+}
+
+void TearDown(void) {
+  cosmo_pool_destroy(pool);
+}
+
+void Increment(void *arg) {
+  atomic_fetch_add(&total, (long)arg);
+}
+
+TEST(pool, submit) {
+  for (long i = 1; i <= 1000; ++i)
+    ASSERT_EQ(0, cosmo_pool_submit(pool, Increment, (void *)i));
+  cosmo_pool_wait(pool);
+  ASSERT_EQ(1000 * 1001 / 2, total);
+}
+
+void Sum(void *arg, size_t lo, size_t hi) {
+  long sum = 0;
+  for (size_t i = lo; i < hi; ++i)
+    sum += ((int *)arg)[i];
+  atomic_fetch_add(&total, sum);
+}
+
+TEST(pool, parallelFor) {
+  static int a[10000];
+  for (int i = 0; i < 10000; ++i)
+    a[i] = i;
+  ASSERT_EQ(0, cosmo_pool_parallel_for(pool, 10000, 0, Sum, a));
+  ASSERT_EQ(10000 * 9999 / 2, total);
+  total = 0;
+  ASSERT_EQ(0, cosmo_pool_parallel_for(pool, 10000, 1, Sum, a));
+  ASSERT_EQ(10000 * 9999 / 2, total);
+}
+
+void Nested(void *arg, size_t lo, size_t hi) {
+  for (size_t i = lo; i < hi; ++i)
+    ASSERT_EQ(0, cosmo_pool_parallel_for(pool, 100, 7, Sum, arg));
+}
+
+TEST(pool, nestedParallelFor) {
+  static int a[100];
+  for (int i = 0; i < 100; ++i)
+    a[i] = 1;
+  ASSERT_EQ(0, cosmo_pool_parallel_for(pool, 50, 1, Nested, a));
+  ASSERT_EQ(50 * 100, total);
+}
@@ -152,6 +152,29 @@ TEST(pthread_create, testBiggerGuardSize) {
   ASSERT_EQ(0, pthread_join(id, 0));
 }
 
+static void *ReturnStackAddress(void *arg) {
+  return _pthread_self()->pt_attr.__stackaddr;
+}
+
+TEST(pthread_create, recyclesStacks) {
+  pthread_t id;
+  void *a, *b;
+  pthread_attr_t attr;
+  ASSERT_EQ(0, pthread_attr_init(&attr));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attr, 196608));
+  ASSERT_EQ(0, pthread_create(&id, &attr, ReturnStackAddress, 0));
+  ASSERT_EQ(0, pthread_join(id, &a));
+  ASSERT_EQ(0, pthread_create(&id, &attr, ReturnStackAddress, 0));
+  ASSERT_EQ(0, pthread_join(id, &b));
+  EXPECT_EQ(a, b);
+  ASSERT_EQ(0, pthread_setstackcache_np(0));
+  ASSERT_EQ(0, pthread_create(&id, &attr, ReturnStackAddress, 0));
+  ASSERT_EQ(0, pthread_join(id, 0));
+  ASSERT_EQ(0, pthread_setstackcache_np(16));
+  ASSERT_EQ(0, pthread_attr_destroy(&attr));
+  EXPECT_EQ(EINVAL, pthread_setstackcache_np(-1));
+}
+
 TEST(pthread_create, testCustomStack_withReallySmallSize) {
   char *stk;
   size_t siz;
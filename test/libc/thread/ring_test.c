@@ -0,0 +1,204 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/ring.h"
+#include "libc/atomic.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/stdio.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+#include "third_party/nsync/cv.h"
+#include "third_party/nsync/mu.h"
+
+#define THREADS 4
+#define ITEMS   100000
+
+atomic_long total;
+struct CosmoRing *ring;
+
+TEST(cosmo_ring_create, rejectsZero) {
+  ASSERT_EQ(NULL, cosmo_ring_create(0, 0));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_ring_trypush, fullAndEmpty) {
+  void *x;
+  ASSERT_NE(NULL, (ring = cosmo_ring_create(3, 0)));
+  ASSERT_FALSE(cosmo_ring_trypop(ring, &x));
+  for (long i = 0; i < 4; ++i)
+    ASSERT_TRUE(cosmo_ring_trypush(ring, (void *)i));
+  ASSERT_FALSE(cosmo_ring_trypush(ring, 0));
+  for (long i = 0; i < 4; ++i) {
+    ASSERT_TRUE(cosmo_ring_trypop(ring, &x));
+    ASSERT_EQ(i, (long)x);
+  }
+  ASSERT_FALSE(cosmo_ring_trypop(ring, &x));
+  cosmo_ring_destroy(ring);
+}
+
+TEST(cosmo_ring_pop, timesOut) {
+  void *x;
+  struct timespec ts = timespec_add(timespec_real(), timespec_frommillis(10));
+  ASSERT_NE(NULL, (ring = cosmo_ring_create(1, 0)));
+  ASSERT_EQ(ETIMEDOUT, cosmo_ring_pop(ring, &x, &ts));
+  cosmo_ring_destroy(ring);
+}
+
+void *Producer(void *arg) {
+  for (long i = 1; i <= ITEMS; ++i)
+    cosmo_ring_push(ring, (void *)i, 0);
+  return 0;
+}
+
+void *Consumer(void *arg) {
+  void *x;
+  long sum = 0;
+  for (long i = 0; i < ITEMS; ++i) {
+    cosmo_ring_pop(ring, &x, 0);
+    sum += (long)x;
+  }
+  atomic_fetch_add(&total, sum);
+  return 0;
+}
+
+void RunRing(int producers, int consumers, int flags) {
+  pthread_t th[THREADS * 2];
+  total = 0;
+  ASSERT_NE(NULL, (ring = cosmo_ring_create(64, flags)));
+  for (int i = 0; i < consumers; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Consumer, 0));
+  for (int i = 0; i < producers; ++i)
+    ASSERT_EQ(0, pthread_create(th + consumers + i, 0, Producer, 0));
+  for (int i = 0; i < producers + consumers; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+  ASSERT_EQ((long)producers * ITEMS * (ITEMS + 1) / 2, total);
+  cosmo_ring_destroy(ring);
+}
+
+TEST(cosmo_ring, spsc) {
+  RunRing(1, 1, COSMO_RING_SP | COSMO_RING_SC);
+}
+
+TEST(cosmo_ring, mpmc) {
+  RunRing(THREADS, THREADS, 0);
+}
+
+struct Item {
+  struct CosmoMpscNode node;
+  long value;
+};
+
+struct CosmoMpsc mpsc;
+
+void *MpscProducer(void *arg) {
+  struct Item *items = arg;
+  for (long i = 0; i < ITEMS; ++i) {
+    items[i].value = i + 1;
+    cosmo_mpsc_push(&mpsc, &items[i].node);
+  }
+  return 0;
+}
+
+TEST(cosmo_mpsc, test) {
+  long sum = 0;
+  pthread_t th[THREADS];
+  struct CosmoMpscNode *n;
+  struct Item *items = malloc(THREADS * ITEMS * sizeof(struct Item));
+  cosmo_mpsc_init(&mpsc);
+  ASSERT_EQ(NULL, cosmo_mpsc_trypop(&mpsc));
+  for (int i = 0; i < THREADS; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, MpscProducer, items + i * ITEMS));
+  for (long i = 0; i < THREADS * ITEMS; ++i) {
+    ASSERT_EQ(0, cosmo_mpsc_pop(&mpsc, &n, 0));
+    sum += ((struct Item *)n)->value;
+  }
+  for (int i = 0; i < THREADS; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+  ASSERT_EQ(NULL, cosmo_mpsc_trypop(&mpsc));
+  ASSERT_EQ((long)THREADS * ITEMS * (ITEMS + 1) / 2, sum);
+  free(items);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BENCHMARKS
+
+// the traditional way of handing work between threads
+struct Handoff {
+  nsync_mu mu;
+  nsync_cv notempty;
+  nsync_cv notfull;
+  unsigned head, tail;
+  void *items[64];
+} handoff;
+
+void *HandoffProducer(void *arg) {
+  for (long i = 1; i <= ITEMS; ++i) {
+    nsync_mu_lock(&handoff.mu);
+    while (handoff.tail - handoff.head == 64)
+      nsync_cv_wait(&handoff.notfull, &handoff.mu);
+    handoff.items[handoff.tail++ % 64] = (void *)i;
+    nsync_cv_signal(&handoff.notempty);
+    nsync_mu_unlock(&handoff.mu);
+  }
+  return 0;
+}
+
+void *HandoffConsumer(void *arg) {
+  long sum = 0;
+  for (long i = 0; i < ITEMS; ++i) {
+    nsync_mu_lock(&handoff.mu);
+    while (handoff.tail == handoff.head)
+      nsync_cv_wait(&handoff.notempty, &handoff.mu);
+    sum += (long)handoff.items[handoff.head++ % 64];
+    nsync_cv_signal(&handoff.notfull);
+    nsync_mu_unlock(&handoff.mu);
+  }
+  atomic_fetch_add(&total, sum);
+  return 0;
+}
+
+void RunHandoff(int threads) {
+  pthread_t th[THREADS * 2];
+  for (int i = 0; i < threads; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, HandoffConsumer, 0));
+  for (int i = 0; i < threads; ++i)
+    ASSERT_EQ(0, pthread_create(th + threads + i, 0, HandoffProducer, 0));
+  for (int i = 0; i < threads * 2; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+}
+
+void Report(const char *name, int threads, struct timespec t1) {
+  double secs = timespec_tonanos(timespec_sub(timespec_real(), t1)) / 1e9;
+  printf("%-16s %d:%d %10g items/sec\n", name, threads, threads,
+         threads * ITEMS / secs);
+}
+
+BENCH(cosmo_ring, bench) {
+  struct timespec t1;
+  for (int n = 1; n <= THREADS; n *= 2) {
+    t1 = timespec_real();
+    RunHandoff(n);
+    Report("nsync handoff", n, t1);
+    t1 = timespec_real();
+    RunRing(n, n, n == 1 ? COSMO_RING_SP | COSMO_RING_SC : 0);
+    Report("cosmo_ring", n, t1);
+  }
+}
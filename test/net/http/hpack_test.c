@@ -0,0 +1,190 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+#include "net/http/http2.h"
+
+struct Hpack h;
+char fields[1024];
+
+void SetUp(void) {
+  InitHpack(&h, kHttp2DefaultHeaderTable);
+  fields[0] = 0;
+}
+
+void TearDown(void) {
+  DestroyHpack(&h);
+}
+
+void OnField(void *arg, const char *k, size_t kn, const char *v, size_t vn) {
+  char *p = fields + strlen(fields);
+  p = mempcpy(p, k, kn);
+  p = stpcpy(p, ": ");
+  p = mempcpy(p, v, vn);
+  p = stpcpy(p, "\n");
+}
+
+int Decode(const char *s, size_t n) {
+  fields[0] = 0;
+  return DecodeHpack(&h, s, n, OnField, 0);
+}
+
+TEST(DecodeHpack, rfc7541_c3_requestsWithoutHuffman) {
+  ASSERT_EQ(0, Decode("\x82\x86\x84\x41\x0f\x77\x77\x77\x2e\x65\x78\x61"
+                      "\x6d\x70\x6c\x65\x2e\x63\x6f\x6d",
+                      20));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: http\n"
+               ":path: /\n"
+               ":authority: www.example.com\n",
+               fields);
+  EXPECT_EQ(57, h.size);
+  ASSERT_EQ(0, Decode("\x82\x86\x84\xbe\x58\x08\x6e\x6f\x2d\x63\x61\x63"
+                      "\x68\x65",
+                      14));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: http\n"
+               ":path: /\n"
+               ":authority: www.example.com\n"
+               "cache-control: no-cache\n",
+               fields);
+  EXPECT_EQ(110, h.size);
+  ASSERT_EQ(0, Decode("\x82\x87\x85\xbf\x40\x0a\x63\x75\x73\x74\x6f\x6d"
+                      "\x2d\x6b\x65\x79\x0c\x63\x75\x73\x74\x6f\x6d\x2d"
+                      "\x76\x61\x6c\x75\x65",
+                      29));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: https\n"
+               ":path: /index.html\n"
+               ":authority: www.example.com\n"
+               "custom-key: custom-value\n",
+               fields);
+  EXPECT_EQ(164, h.size);
+}
+
+TEST(DecodeHpack, rfc7541_c4_requestsWithHuffman) {
+  ASSERT_EQ(0, Decode("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b"
+                      "\xa0\xab\x90\xf4\xff",
+                      17));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: http\n"
+               ":path: /\n"
+               ":authority: www.example.com\n",
+               fields);
+  ASSERT_EQ(0, Decode("\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf", 12));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: http\n"
+               ":path: /\n"
+               ":authority: www.example.com\n"
+               "cache-control: no-cache\n",
+               fields);
+  ASSERT_EQ(0, Decode("\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9"
+                      "\x7d\x7f\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf",
+                      24));
+  EXPECT_STREQ(":method: GET\n"
+               ":scheme: https\n"
+               ":path: /index.html\n"
+               ":authority: www.example.com\n"
+               "custom-key: custom-value\n",
+               fields);
+  EXPECT_EQ(164, h.size);
+}
+
+TEST(DecodeHpack, tableSizeUpdate_evicts) {
+  ASSERT_EQ(0, Decode("\x40\x01\x61\x01\x62", 5));  // a: b
+  EXPECT_EQ(34, h.size);
+  ASSERT_EQ(0, Decode("\x20", 1));
+  EXPECT_EQ(0, h.size);
+  EXPECT_EQ(-1, Decode("\xbe", 1));
+}
+
+TEST(DecodeHpack, tableSizeUpdateAfterField_isError) {
+  EXPECT_EQ(-1, Decode("\x82\x20", 2));
+}
+
+TEST(DecodeHpack, tableSizeUpdateAboveSetting_isError) {
+  EXPECT_EQ(-1, Decode("\x3f\xe2\x1f", 3));  // 4097
+}
+
+TEST(DecodeHpack, badIndex_isError) {
+  EXPECT_EQ(-1, Decode("\x80", 1));
+  EXPECT_EQ(-1, Decode("\xbe", 1));
+}
+
+TEST(DecodeHpack, truncated_isError) {
+  EXPECT_EQ(-1, Decode("\x41\x0f\x77", 3));
+  EXPECT_EQ(-1, Decode("\xff", 1));
+}
+
+TEST(DecodeHpack, literalWithIndexedNameFromEvictedEntry) {
+  InitHpack(&h, 40);
+  ASSERT_EQ(0, Decode("\x40\x01\x61\x01\x62", 5));  // a: b
+  ASSERT_EQ(0, Decode("\x7e\x01\x63", 3));          // a: c
+  EXPECT_STREQ("a: c\n", fields);
+  EXPECT_EQ(34, h.size);
+}
+
+TEST(DecodeHpackHuffman, test) {
+  char buf[16];
+  ASSERT_EQ(8, DecodeHpackHuffman(buf, sizeof(buf),
+                                  "\xa8\xeb\x10\x64\x9c\xbf", 6));
+  EXPECT_EQ(0, memcmp(buf, "no-cache", 8));
+  EXPECT_EQ(-1, DecodeHpackHuffman(buf, 7, "\xa8\xeb\x10\x64\x9c\xbf", 6));
+}
+
+TEST(DecodeHpackHuffman, badPadding_isError) {
+  char buf[16];
+  EXPECT_EQ(-1, DecodeHpackHuffman(buf, sizeof(buf), "\x00", 1));
+  EXPECT_EQ(-1, DecodeHpackHuffman(buf, sizeof(buf), "\xff\xff\xff\xff", 4));
+}
+
+TEST(EncodeHpack, roundTrip) {
+  char b[128], *p = b;
+  p = EncodeHpackStatus(p, 200);
+  p = EncodeHpackStatus(p, 302);
+  p = EncodeHpackHeader(p, "Content-Type", 12, "text/html", 9);
+  ASSERT_EQ(0, Decode(b, p - b));
+  EXPECT_STREQ(":status: 200\n"
+               ":status: 302\n"
+               "content-type: text/html\n",
+               fields);
+  EXPECT_EQ(0, h.size);
+}
+
+TEST(EncodeHpackInt, rfc7541_c1) {
+  char b[8];
+  EXPECT_EQ(1, EncodeHpackInt(b, 10, 5, 0) - b);
+  EXPECT_EQ(10, b[0]);
+  EXPECT_EQ(3, EncodeHpackInt(b, 1337, 5, 0) - b);
+  EXPECT_EQ(31, b[0] & 255);
+  EXPECT_EQ(154, b[1] & 255);
+  EXPECT_EQ(10, b[2] & 255);
+}
+
+TEST(FormatHttp2Frame, roundTrip) {
+  char b[kHttp2FrameHdrSize];
+  struct Http2Frame f;
+  EXPECT_EQ(b + 9, FormatHttp2Frame(b, 0x123456, kHttp2Headers,
+                                    kHttp2FlagEndHeaders, 0x80000003));
+  ParseHttp2Frame(&f, b);
+  EXPECT_EQ(0x123456, f.length);
+  EXPECT_EQ(kHttp2Headers, f.type);
+  EXPECT_EQ(kHttp2FlagEndHeaders, f.flags);
+  EXPECT_EQ(3, f.stream);
+}
@@ -333,6 +333,53 @@ Accept-Encoding: deflate, gzip, bzip2\r\n\
   EXPECT_FALSE(HeaderHas(req, m, kHttpAcceptEncoding, "funzip", -1));
 }
 
+TEST(HeaderAccepts, testTokens_areNotSubstrings) {
+  static const char m[] = "\
+GET / HTTP/1.1\r\n\
+Accept-Encoding: gzip, deflate, brotli, xzstd\r\n\
+\r\n";
+  InitHttpMessage(req, kHttpRequest);
+  EXPECT_EQ(strlen(m), ParseHttpMessage(req, m, strlen(m)));
+  EXPECT_TRUE(HeaderAccepts(req, m, kHttpAcceptEncoding, "gzip", -1));
+  EXPECT_TRUE(HeaderAccepts(req, m, kHttpAcceptEncoding, "deflate", -1));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "br", -1));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "zstd", -1));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "gz", -1));
+}
+
+TEST(HeaderAccepts, testCaseAndWeights) {
+  static const char m[] = "\
+GET / HTTP/1.1\r\n\
+Accept-Encoding: GZIP;q=0.5, Br ; Q=0.000, zstd;q=0.001\r\n\
+\r\n";
+  InitHttpMessage(req, kHttpRequest);
+  EXPECT_EQ(strlen(m), ParseHttpMessage(req, m, strlen(m)));
+  EXPECT_TRUE(HeaderAccepts(req, m, kHttpAcceptEncoding, "gzip", -1));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "br", -1));
+  EXPECT_TRUE(HeaderAccepts(req, m, kHttpAcceptEncoding, "zstd", -1));
+}
+
+TEST(HeaderAccepts, testWildcard_decidesUnlistedTokens) {
+  static const char m[] = "\
+GET / HTTP/1.1\r\n\
+Accept-Encoding: br;q=0\r\n\
+Accept-Encoding: *\r\n\
+\r\n";
+  InitHttpMessage(req, kHttpRequest);
+  EXPECT_EQ(strlen(m), ParseHttpMessage(req, m, strlen(m)));
+  EXPECT_TRUE(HeaderAccepts(req, m, kHttpAcceptEncoding, "gzip", -1));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "br", -1));
+}
+
+TEST(HeaderAccepts, testAbsentHeader) {
+  static const char m[] = "\
+GET / HTTP/1.1\r\n\
+\r\n";
+  InitHttpMessage(req, kHttpRequest);
+  EXPECT_EQ(strlen(m), ParseHttpMessage(req, m, strlen(m)));
+  EXPECT_FALSE(HeaderAccepts(req, m, kHttpAcceptEncoding, "gzip", -1));
+}
+
 TEST(ParseHttpMessage, testHeaderValuesWithWhitespace_getsTrimmed) {
   static const char m[] = "\
 OPTIONS * HTTP/1.0\r\n\
@@ -70,6 +70,17 @@ o/$(MODE)/test/tool/net/%.dbg:					\
 		$(APE_NO_MODIFY_SELF)
 	@$(APELINK)
 
+o/$(MODE)/test/tool/net/assetindex_test.dbg:			\
+		$(TEST_TOOL_NET_DEPS)				\
+		$(TEST_TOOL_NET_A)				\
+		o/$(MODE)/test/tool/net/assetindex_test.o	\
+		o/$(MODE)/tool/net/assetindex.o			\
+		$(TEST_TOOL_NET_A).pkg				\
+		$(LIBC_TESTMAIN)				\
+		$(CRT)						\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
 .PRECIOUS: o/$(MODE)/test/tool/net/redbean-tester
 o/$(MODE)/test/tool/net/redbean-tester.dbg:			\
 		$(TOOL_NET_DEPS)				\
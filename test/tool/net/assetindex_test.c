@@ -0,0 +1,124 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "tool/net/assetindex.h"
+#include "libc/calls/calls.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+#include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
+
+#define N 100000
+
+char **names;
+struct AssetIndex x;
+
+void SetUpOnce(void) {
+  int i;
+  names = xcalloc(N, sizeof(*names));
+  for (i = 0; i < N; ++i) {
+    names[i] = xasprintf("static/js/%d/chunk-%08x.js", i % 100,
+                         i * 2654435761u);
+  }
+}
+
+void SetUp(void) {
+  InitAssetIndex(&x, N * 4);
+}
+
+void TearDown(void) {
+  FreeAssetIndex(&x);
+}
+
+TEST(FindAssetIndex, empty) {
+  struct AssetIndex empty = {0};
+  EXPECT_EQ(-1, FindAssetIndex(&empty, "index.html", 10));
+}
+
+TEST(FindAssetIndex, test) {
+  int i;
+  uint32_t *slots = gc(xcalloc(N, sizeof(*slots)));
+  for (i = 0; i < N; ++i) {
+    slots[i] = AddAssetIndex(&x, names[i], strlen(names[i]));
+  }
+  for (i = 0; i < N; ++i) {
+    ASSERT_EQ(slots[i], FindAssetIndex(&x, names[i], strlen(names[i])));
+  }
+  EXPECT_EQ(-1, FindAssetIndex(&x, "static/js/", 10));
+  EXPECT_EQ(-1, FindAssetIndex(&x, "index.html", 10));
+}
+
+TEST(FindAssetIndex, prefixIsNotMatch) {
+  AddAssetIndex(&x, "index.html", 10);
+  EXPECT_EQ(-1, FindAssetIndex(&x, "index.htm", 9));
+  EXPECT_NE(-1, FindAssetIndex(&x, "index.html", 10));
+}
+
+TEST(FindAssetIndex, duplicates_returnsFirst) {
+  uint32_t a, b;
+  a = AddAssetIndex(&x, "a", 1);
+  b = AddAssetIndex(&x, "a", 1);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, FindAssetIndex(&x, "a", 1));
+}
+
+TEST(FindAssetIndex, namesMovedToNewMapping_findsOldAndNew) {
+  char *m1, *m2;
+  m1 = mmap(0, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+            0);
+  ASSERT_NE(MAP_FAILED, m1);
+  strcpy(m1, "index.html");
+  strcpy(m1 + 100, "style.css");
+  x.base = m1;
+  AddAssetIndex(&x, m1, 10);
+  AddAssetIndex(&x, m1 + 100, 9);
+  // as if the zip got appended to and mapped again somewhere else
+  m2 = mmap(0, 8192, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+            0);
+  ASSERT_NE(MAP_FAILED, m2);
+  memcpy(m2, m1, 4096);
+  strcpy(m2 + 4096, "app.js");
+  ASSERT_SYS(0, 0, munmap(m1, 4096));
+  x.base = m2;
+  AddAssetIndex(&x, m2 + 4096, 6);
+  EXPECT_NE(-1, FindAssetIndex(&x, "index.html", 10));
+  EXPECT_NE(-1, FindAssetIndex(&x, "style.css", 9));
+  EXPECT_NE(-1, FindAssetIndex(&x, "app.js", 6));
+  EXPECT_EQ(-1, FindAssetIndex(&x, "app.css", 7));
+  ASSERT_SYS(0, 0, munmap(m2, 8192));
+}
+
+BENCH(FindAssetIndex, bench) {
+  int i;
+  char *hit, miss[] = "static/js/99/chunk-ffffffff.jz";
+  for (i = 0; i < N; ++i) {
+    AddAssetIndex(&x, names[i], strlen(names[i]));
+  }
+  hit = names[N / 2];
+  EZBENCH2("FindAssetIndex hit", donothing,
+           FindAssetIndex(&x, hit, strlen(hit)));
+  EZBENCH2("FindAssetIndex miss", donothing,
+           FindAssetIndex(&x, miss, strlen(miss)));
+  EZBENCH2("HashAssetName", donothing, HashAssetName(hit, strlen(hit)));
+}
@@ -293,4 +293,137 @@ Z\n",
   EXPECT_NE(-1, sigprocmask(SIG_SETMASK, &savemask, 0));
 }
 
+TEST(redbean, testStoreAsset_findsOldAndNewAssets) {
+  if (IsWindows() || IsOpenbsd() || IsNetbsd())
+    return;
+  int pid, ws, pipefds[2];
+  char portbuf[16];
+  sigset_t chldmask, savemask;
+  ASSERT_NE(-1, xbarf("a.txt", "hello\n", -1));
+  ASSERT_NE(-1, xbarf("b.txt", "there\n", -1));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    // each store appends to the zip and reindexes it incrementally,
+    // after which looking up the next name touches the old records
+    execv("bin/redbean-tester",
+          (char *const[]){"bin/redbean-tester", "-A", "a.txt", "-A", "b.txt",
+                          0});
+    _exit(127);
+  }
+  ASSERT_NE(-1, waitpid(pid, &ws, 0));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(0, WEXITSTATUS(ws));
+  sigaddset(&chldmask, SIGCHLD);
+  EXPECT_NE(-1, sigprocmask(SIG_BLOCK, &chldmask, &savemask));
+  ASSERT_NE(-1, pipe(pipefds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    setpgrp();
+    close(0);
+    open("/dev/null", O_RDWR);
+    close(pipefds[0]);
+    dup2(pipefds[1], 1);
+    sigprocmask(SIG_SETMASK, &savemask, NULL);
+    execv("bin/redbean-tester",
+          (char *const[]){"bin/redbean-tester", "-vvszXp0", "-l127.0.0.1",
+                          __strace > 0 ? "--strace" : 0, 0});
+    _exit(127);
+  }
+  EXPECT_NE(-1, close(pipefds[1]));
+  EXPECT_NE(-1, read(pipefds[0], portbuf, sizeof(portbuf)));
+  port = atoi(portbuf);
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n.*\r\n\r\nhello\n$",
+                      gc(SendHttpRequest("GET /a.txt HTTP/1.1\r\n\r\n"))));
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n.*\r\n\r\nthere\n$",
+                      gc(SendHttpRequest("GET /b.txt HTTP/1.1\r\n\r\n"))));
+  EXPECT_TRUE(Matches("HTTP/1\\.1 206 Partial Content\r\n.*\r\n\r\nJ\n$",
+                      gc(SendHttpRequest("GET /seekable.txt HTTP/1.1\r\n"
+                                         "Range: bytes=18-19\r\n"
+                                         "\r\n"))));
+  EXPECT_EQ(0, close(pipefds[0]));
+  EXPECT_NE(-1, kill(pid, SIGTERM));
+  EXPECT_NE(-1, wait(0));
+  EXPECT_NE(-1, sigprocmask(SIG_SETMASK, &savemask, 0));
+}
+
+TEST(redbean, testWorkerThreads) {
+  if (IsWindows())
+    return;
+  char *p;
+  size_t n;
+  char portbuf[16];
+  int ws, pid, pipefds[2];
+  sigset_t chldmask, savemask;
+  // give a copy of the tester some lua, which each thread runs itself
+  ASSERT_NE(NULL, (p = gc(xslurp("bin/redbean-tester", &n))));
+  ASSERT_NE(-1, xbarf("bin/redbean-threads", p, n));
+  ASSERT_NE(-1, chmod("bin/redbean-threads", 0755));
+  ASSERT_NE(-1, xbarf(".init.lua",
+                      "ProgramHeader('X-Init', 'yes')\n"
+                      "function OnWorkerStart() started = '!' end\n",
+                      -1));
+  ASSERT_NE(-1, xbarf("hits.lua",
+                      "hits = (hits or 0) + 1\n"
+                      "Write(tostring(hits) .. (started or ''))\n",
+                      -1));
+  ASSERT_NE(-1, xbarf("brand.lua", "ProgramBrand('nope')\n", -1));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    execv("bin/redbean-threads",
+          (char *const[]){"bin/redbean-threads", "-A", ".init.lua", "-A",
+                          "hits.lua", "-A", "brand.lua", 0});
+    _exit(127);
+  }
+  ASSERT_NE(-1, waitpid(pid, &ws, 0));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(0, WEXITSTATUS(ws));
+  sigaddset(&chldmask, SIGCHLD);
+  EXPECT_NE(-1, sigprocmask(SIG_BLOCK, &chldmask, &savemask));
+  ASSERT_NE(-1, pipe(pipefds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    setpgrp();
+    close(0);
+    open("/dev/null", O_RDWR);
+    close(pipefds[0]);
+    dup2(pipefds[1], 1);
+    sigprocmask(SIG_SETMASK, &savemask, NULL);
+    execv("bin/redbean-threads",
+          (char *const[]){"bin/redbean-threads", "-vvszXp0", "-n1",
+                          "-l127.0.0.1", __strace > 0 ? "--strace" : 0, 0});
+    _exit(127);
+  }
+  EXPECT_NE(-1, close(pipefds[1]));
+  EXPECT_NE(-1, read(pipefds[0], portbuf, sizeof(portbuf)));
+  port = atoi(portbuf);
+  // the thread keeps its lua globals between connections, whereas a
+  // forked worker would start over from the main process each time
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n"
+                      ".*\r\n\r\n1!"
+                      "HTTP/1\\.1 200 OK\r\n"
+                      ".*\r\n\r\n2!$",
+                      gc(SendHttpRequest("GET /hits.lua HTTP/1.1\r\n\r\n"
+                                         "GET /hits.lua HTTP/1.1\r\n"
+                                         "\r\n"))));
+  p = gc(SendHttpRequest("GET /hits.lua HTTP/1.1\r\n\r\n"));
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n.*\r\n\r\n3!$", p));
+  // the thread's run of .init.lua didn't program the header twice
+  EXPECT_TRUE(Matches("X-Init: yes\r\n", p));
+  EXPECT_FALSE(Matches("X-Init.*X-Init", p));
+  EXPECT_TRUE(
+      Matches("HTTP/1\\.1 500 ",
+              gc(SendHttpRequest("GET /brand.lua HTTP/1.1\r\n\r\n"))));
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n"
+                      ".*Content-Length: 52\r\n"
+                      "\r\nA\nB\n.*Z\n$",
+                      gc(SendHttpRequest("GET /seekable.txt HTTP/1.1\r\n"
+                                         "\r\n"))));
+  EXPECT_TRUE(Matches("HTTP/1\\.1 404 Not Found\r\n",
+                      gc(SendHttpRequest("GET /nope.txt HTTP/1.1\r\n\r\n"))));
+  EXPECT_EQ(0, close(pipefds[0]));
+  EXPECT_NE(-1, kill(pid, SIGTERM));
+  EXPECT_NE(-1, wait(0));
+  EXPECT_NE(-1, sigprocmask(SIG_SETMASK, &savemask, 0));
+}
+
 #endif /* __x86_64__ */
@@ -2,14 +2,17 @@
 #include "libc/assert.h"
 #include "libc/atomic.h"
 #include "libc/calls/calls.h"
+#include "libc/calls/struct/cpuset.h"
 #include "libc/dce.h"
 #include "libc/errno.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/bsr.h"
+#include "libc/intrin/dll.h"
 #include "libc/intrin/likely.h"
 #include "libc/intrin/weaken.h"
 #include "libc/macros.internal.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/nexgen32e/rdtsc.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
@@ -25,8 +28,8 @@
 #include "third_party/dlmalloc/vespene.internal.h"
 #include "third_party/nsync/mu.h"
 
-#define FOOTERS 0
-#define MSPACES 0
+#define FOOTERS 1
+#define MSPACES 1
 
 #define HAVE_MMAP 1
 #define HAVE_MREMAP 0
@@ -184,6 +187,16 @@ static void* sys_alloc(mstate m, size_t nb) {
     RELEASE_MALLOC_GLOBAL_LOCK();
   }
 
+  if (HAVE_MMAP && tbase == CMFAIL && mparams.hugepages &&
+      !(asize & (HUGE_PAGE_SIZE - 1))) {  /* Try huge MMAP */
+    char* mp = (char*)(dlmalloc_requires_more_huge_gas(asize, HUGE_PAGE_SIZE));
+    if (mp != 0 && mp != CMFAIL) {
+      tbase = mp;
+      tsize = asize;
+      mmap_flag = USE_MMAP_BIT | HUGE_BIT;
+    }
+  }
+
   if (HAVE_MMAP && tbase == CMFAIL) {  /* Try MMAP */
     char* mp = (char*)(dlmalloc_requires_more_vespene_gas(asize));
     if (mp != CMFAIL) {
@@ -245,7 +258,7 @@ static void* sys_alloc(mstate m, size_t nb) {
         sp = (NO_SEGMENT_TRAVERSAL) ? 0 : sp->next;
       if (sp != 0 &&
           !is_extern_segment(sp) &&
-          (sp->sflags & USE_MMAP_BIT) == mmap_flag &&
+          (sp->sflags & (USE_MMAP_BIT | HUGE_BIT)) == mmap_flag &&
           segment_holds(sp, m->top)) { /* append */
         sp->size += tsize;
         init_top(m, m->top, m->topsize + tsize);
@@ -258,7 +271,7 @@ static void* sys_alloc(mstate m, size_t nb) {
           sp = (NO_SEGMENT_TRAVERSAL) ? 0 : sp->next;
         if (sp != 0 &&
             !is_extern_segment(sp) &&
-            (sp->sflags & USE_MMAP_BIT) == mmap_flag) {
+            (sp->sflags & (USE_MMAP_BIT | HUGE_BIT)) == mmap_flag) {
           char* oldbase = sp->base;
           sp->base = tbase;
           sp->size += tsize;
@@ -584,7 +597,10 @@ static void* tmalloc_small(mstate m, size_t nb) {
 
 #if !ONLY_MSPACES
 
-void* dlmalloc(size_t bytes) {
+#include "third_party/dlmalloc/arenas.inc"
+#include "third_party/dlmalloc/threadcache.inc"
+
+static void* dlmalloc_locked(mstate m, size_t bytes) {
   /*
      Basic algorithm:
      If a small request (< 256 bytes minus per-chunk overhead):
@@ -605,14 +621,10 @@ void* dlmalloc(size_t bytes) {
        4. If request size >= mmap threshold, try to directly mmap this chunk.
        5. If available, get memory from system and use it
 
-     The ugly goto's here ensure that postaction occurs along all paths.
+     The caller must hold the lock of arena m, see dlmalloc() below.
   */
 
-#if USE_LOCKS
-  ensure_initialization(); /* initialize in sys_alloc if not using locks */
-#endif
-
-  if (!PREACTION(gm)) {
+  {
     void* mem;
     size_t nb;
     if (bytes <= MAX_SMALL_REQUEST) {
@@ -620,22 +632,22 @@ void* dlmalloc(size_t bytes) {
       binmap_t smallbits;
       nb = (bytes < MIN_REQUEST)? MIN_CHUNK_SIZE : pad_request(bytes);
       idx = small_index(nb);
-      smallbits = gm->smallmap >> idx;
+      smallbits = m->smallmap >> idx;
 
       if ((smallbits & 0x3U) != 0) { /* Remainderless fit to a smallbin. */
         mchunkptr b, p;
         idx += ~smallbits & 1;       /* Uses next bin if idx empty */
-        b = smallbin_at(gm, idx);
+        b = smallbin_at(m, idx);
         p = b->fd;
         assert(chunksize(p) == small_index2size(idx));
-        unlink_first_small_chunk(gm, b, p, idx);
-        set_inuse_and_pinuse(gm, p, small_index2size(idx));
+        unlink_first_small_chunk(m, b, p, idx);
+        set_inuse_and_pinuse(m, p, small_index2size(idx));
         mem = chunk2mem(p);
-        check_malloced_chunk(gm, mem, nb);
-        goto postaction;
+        check_malloced_chunk(m, mem, nb);
+        return mem;
       }
 
-      else if (nb > gm->dvsize) {
+      else if (nb > m->dvsize) {
         if (smallbits != 0) { /* Use chunk in next nonempty smallbin */
           mchunkptr b, p, r;
           size_t rsize;
@@ -643,28 +655,28 @@ void* dlmalloc(size_t bytes) {
           binmap_t leftbits = (smallbits << idx) & left_bits(idx2bit(idx));
           binmap_t leastbit = least_bit(leftbits);
           compute_bit2idx(leastbit, i);
-          b = smallbin_at(gm, i);
+          b = smallbin_at(m, i);
           p = b->fd;
           assert(chunksize(p) == small_index2size(i));
-          unlink_first_small_chunk(gm, b, p, i);
+          unlink_first_small_chunk(m, b, p, i);
           rsize = small_index2size(i) - nb;
           /* Fit here cannot be remainderless if 4byte sizes */
           if (SIZE_T_SIZE != 4 && rsize < MIN_CHUNK_SIZE)
-            set_inuse_and_pinuse(gm, p, small_index2size(i));
+            set_inuse_and_pinuse(m, p, small_index2size(i));
           else {
-            set_size_and_pinuse_of_inuse_chunk(gm, p, nb);
+            set_size_and_pinuse_of_inuse_chunk(m, p, nb);
             r = chunk_plus_offset(p, nb);
             set_size_and_pinuse_of_free_chunk(r, rsize);
-            replace_dv(gm, r, rsize);
+            replace_dv(m, r, rsize);
           }
           mem = chunk2mem(p);
-          check_malloced_chunk(gm, mem, nb);
-          goto postaction;
+          check_malloced_chunk(m, mem, nb);
+          return mem;
         }
 
-        else if (gm->treemap != 0 && (mem = tmalloc_small(gm, nb)) != 0) {
-          check_malloced_chunk(gm, mem, nb);
-          goto postaction;
+        else if (m->treemap != 0 && (mem = tmalloc_small(m, nb)) != 0) {
+          check_malloced_chunk(m, mem, nb);
+          return mem;
         }
       }
     }
@@ -672,57 +684,65 @@ void* dlmalloc(size_t bytes) {
       nb = MAX_SIZE_T; /* Too big to allocate. Force failure (in sys alloc) */
     else {
       nb = pad_request(bytes);
-      if (gm->treemap != 0 && (mem = tmalloc_large(gm, nb)) != 0) {
-        check_malloced_chunk(gm, mem, nb);
-        goto postaction;
+      if (m->treemap != 0 && (mem = tmalloc_large(m, nb)) != 0) {
+        check_malloced_chunk(m, mem, nb);
+        return mem;
       }
     }
 
-    if (nb <= gm->dvsize) {
-      size_t rsize = gm->dvsize - nb;
-      mchunkptr p = gm->dv;
+    if (nb <= m->dvsize) {
+      size_t rsize = m->dvsize - nb;
+      mchunkptr p = m->dv;
       if (rsize >= MIN_CHUNK_SIZE) { /* split dv */
-        mchunkptr r = gm->dv = chunk_plus_offset(p, nb);
-        gm->dvsize = rsize;
+        mchunkptr r = m->dv = chunk_plus_offset(p, nb);
+        m->dvsize = rsize;
         set_size_and_pinuse_of_free_chunk(r, rsize);
-        set_size_and_pinuse_of_inuse_chunk(gm, p, nb);
+        set_size_and_pinuse_of_inuse_chunk(m, p, nb);
       }
       else { /* exhaust dv */
-        size_t dvs = gm->dvsize;
-        gm->dvsize = 0;
-        gm->dv = 0;
-        set_inuse_and_pinuse(gm, p, dvs);
+        size_t dvs = m->dvsize;
+        m->dvsize = 0;
+        m->dv = 0;
+        set_inuse_and_pinuse(m, p, dvs);
       }
       mem = chunk2mem(p);
-      check_malloced_chunk(gm, mem, nb);
-      goto postaction;
+      check_malloced_chunk(m, mem, nb);
+      return mem;
     }
 
-    else if (nb < gm->topsize) { /* Split top */
-      size_t rsize = gm->topsize -= nb;
-      mchunkptr p = gm->top;
-      mchunkptr r = gm->top = chunk_plus_offset(p, nb);
+    else if (nb < m->topsize) { /* Split top */
+      size_t rsize = m->topsize -= nb;
+      mchunkptr p = m->top;
+      mchunkptr r = m->top = chunk_plus_offset(p, nb);
       r->head = rsize | PINUSE_BIT;
-      set_size_and_pinuse_of_inuse_chunk(gm, p, nb);
+      set_size_and_pinuse_of_inuse_chunk(m, p, nb);
       mem = chunk2mem(p);
-      check_top_chunk(gm, gm->top);
-      check_malloced_chunk(gm, mem, nb);
-      goto postaction;
+      check_top_chunk(m, m->top);
+      check_malloced_chunk(m, mem, nb);
+      return mem;
     }
 
-    mem = sys_alloc(gm, nb);
-    POSTACTION(gm);
-    if (mem == MAP_FAILED && _weaken(__oom_hook)) {
-      _weaken(__oom_hook)(bytes);
-    }
-    return mem;
+    return sys_alloc(m, nb);
+  }
+}
 
-  postaction:
-    POSTACTION(gm);
+void* dlmalloc(size_t bytes) {
+  void* mem;
+  mstate m;
+  if ((mem = tcache_malloc(bytes)) != 0)
     return mem;
+#if USE_LOCKS
+  ensure_initialization(); /* initialize in sys_alloc if not using locks */
+#endif
+  m = arena_choose();
+  if (PREACTION(m))
+    return 0;
+  mem = dlmalloc_locked(m, bytes);
+  POSTACTION(m);
+  if (mem == MAP_FAILED && _weaken(__oom_hook)) {
+    _weaken(__oom_hook)(bytes);
   }
-
-  return 0;
+  return mem;
 }
 
 /* ---------------------------- free --------------------------- */
@@ -745,6 +765,8 @@ void dlfree(void* mem) {
 #else /* FOOTERS */
 #define fm gm
 #endif /* FOOTERS */
+    if (tcache_free(fm, p))
+      return;
     if (!PREACTION(fm)) {
       check_inuse_chunk(fm, p);
       if (RTCHECK(ok_address(fm, p) && ok_inuse(p))) {
@@ -1302,12 +1324,16 @@ void* dlmemalign(size_t alignment, size_t bytes) {
   if (alignment <= MALLOC_ALIGNMENT) {
     return dlmalloc(bytes);
   }
-  return internal_memalign(gm, alignment, bytes);
+  ensure_initialization();
+  return internal_memalign(arena_choose(), alignment, bytes);
 }
 
 #if USE_LOCKS
 void dlmalloc_atfork(void) {
-  bzero(&gm->mutex, sizeof(gm->mutex));
+  int i;
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      bzero(&arenas[i]->mutex, sizeof(arenas[i]->mutex));
   bzero(&malloc_global_mutex, sizeof(malloc_global_mutex));
 }
 #endif
@@ -1324,7 +1350,12 @@ void** dlindependent_comalloc(size_t n_elements, size_t sizes[],
 }
 
 size_t dlbulk_free(void* array[], size_t nelem) {
-  return internal_bulk_free(gm, array, nelem);
+  int i;
+  size_t unfreed = 0;
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      unfreed = internal_bulk_free(arenas[i], array, nelem);
+  return unfreed;
 }
 
 #if MALLOC_INSPECT_ALL
@@ -1333,30 +1364,47 @@ void dlmalloc_inspect_all(void(*handler)(void *start,
                                          size_t used_bytes,
                                          void* callback_arg),
                           void* arg) {
+  int i;
   ensure_initialization();
-  if (!PREACTION(gm)) {
-    internal_inspect_all(gm, handler, arg);
-    POSTACTION(gm);
+  for (i = 0; i < MAX_ARENAS; ++i) {
+    mstate m = arenas[i];
+    if (m && !PREACTION(m)) {
+      internal_inspect_all(m, handler, arg);
+      POSTACTION(m);
+    }
   }
 }
 #endif /* MALLOC_INSPECT_ALL */
 
 int dlmalloc_trim(size_t pad) {
-  int result = 0;
+  int i, result = 0;
   ensure_initialization();
-  if (!PREACTION(gm)) {
-    result = sys_trim(gm, pad);
-    POSTACTION(gm);
+  for (i = 0; i < MAX_ARENAS; ++i) {
+    mstate m = arenas[i];
+    if (m && !PREACTION(m)) {
+      result |= sys_trim(m, pad);
+      POSTACTION(m);
+    }
   }
   return result;
 }
 
 size_t dlmalloc_footprint(void) {
-  return gm->footprint;
+  int i;
+  size_t sum = 0;
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      sum += arenas[i]->footprint;
+  return sum;
 }
 
 size_t dlmalloc_max_footprint(void) {
-  return gm->max_footprint;
+  int i;
+  size_t sum = 0;
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      sum += arenas[i]->max_footprint;
+  return sum;
 }
 
 size_t dlmalloc_footprint_limit(void) {
@@ -1365,6 +1413,7 @@ size_t dlmalloc_footprint_limit(void) {
 }
 
 size_t dlmalloc_set_footprint_limit(size_t bytes) {
+  int i;
   size_t result;  /* invert sense of 0 */
   if (bytes == 0)
     result = granularity_align(1); /* Use minimal size */
@@ -1372,18 +1421,41 @@ size_t dlmalloc_set_footprint_limit(size_t bytes) {
     result = 0;                    /* disable */
   else
     result = granularity_align(bytes);
-  return gm->footprint_limit = result;
+  ACQUIRE_LOCK(&arena_mutex);
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      arenas[i]->footprint_limit = result;
+  RELEASE_LOCK(&arena_mutex);
+  return result;
 }
 
 #if !NO_MALLINFO
 struct mallinfo dlmallinfo(void) {
-  return internal_mallinfo(gm);
+  int i;
+  struct mallinfo m, sum = {0};
+  for (i = 0; i < MAX_ARENAS; ++i) {
+    if (arenas[i]) {
+      m = internal_mallinfo(arenas[i]);
+      sum.arena += m.arena;
+      sum.ordblks += m.ordblks;
+      sum.hblks += m.hblks;
+      sum.hblkhd += m.hblkhd;
+      sum.usmblks += m.usmblks;
+      sum.uordblks += m.uordblks;
+      sum.fordblks += m.fordblks;
+      sum.keepcost += m.keepcost;
+    }
+  }
+  return sum;
 }
 #endif /* NO_MALLINFO */
 
 #if !NO_MALLOC_STATS
 void dlmalloc_stats() {
-  internal_malloc_stats(gm);
+  int i;
+  for (i = 0; i < MAX_ARENAS; ++i)
+    if (arenas[i])
+      internal_malloc_stats(arenas[i]);
 }
 #endif /* NO_MALLOC_STATS */
 
@@ -16,6 +16,7 @@
 #define dlmalloc_max_footprint       __dlmalloc_max_footprint
 #define dlmalloc_set_footprint_limit __dlmalloc_set_footprint_limit
 #define dlmalloc_stats               __dlmalloc_stats
+#define dlmalloc_thread_exit         __dlmalloc_thread_exit
 #define dlmalloc_trim                __dlmalloc_trim
 #define dlmalloc_usable_size         __dlmalloc_usable_size
 #define dlmallopt                    __dlmallopt
@@ -127,6 +128,12 @@ void* dlmemalign(size_t, size_t);
   M_TRIM_THRESHOLD     -1   2*1024*1024   any   (-1U disables trimming)
   M_GRANULARITY        -2     page size   any power of 2 >= page size
   M_MMAP_THRESHOLD     -3      256*1024   any   (or 0 if no MMAP support)
+  M_HUGEPAGES          -9             0   0 or 1 (only supported on Linux)
+
+  M_HUGEPAGES grows the heap in 2 MiB aligned regions that are advised
+  to be backed by transparent huge pages, and trims it in 2 MiB units.
+  It's also enabled by the MALLOC_HUGEPAGES environment variable. Its
+  number is chosen so it doesn't collide with glibc's mallopt params.
 */
 int dlmallopt(int, int);
 
@@ -217,7 +224,8 @@ void dlmalloc_inspect_all(void (*handler)(void*, void*, size_t, void*),
   arena:     current total non-mmapped bytes allocated from system
   ordblks:   the number of free chunks
   smblks:    always zero.
-  hblks:     current number of mmapped regions
+  hblks:     total bytes held in transparent huge page segments, see
+                M_HUGEPAGES. Note this is in bytes rather than a count.
   hblkhd:    total bytes held in mmapped regions
   usmblks:   the maximum total allocated space. This will be greater
                 than current total if trimming has occurred.
@@ -506,6 +514,7 @@ void mspace_inspect_all(mspace msp,
                         void* arg);
 
 void dlmalloc_atfork(void);
+void dlmalloc_thread_exit(void);
 void dlmalloc_abort(void) relegated wontreturn;
 
 COSMOPOLITAN_C_END_
@@ -16,10 +16,14 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
 #include "libc/dce.h"
 #include "libc/intrin/asan.internal.h"
 #include "libc/intrin/asancodes.h"
 #include "libc/runtime/runtime.h"
+#include "libc/sysv/consts/madv.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/prot.h"
 #include "third_party/dlmalloc/vespene.internal.h"
 
 /**
@@ -35,3 +39,35 @@ void *dlmalloc_requires_more_vespene_gas(size_t size) {
   }
   return p;
 }
+
+/**
+ * Acquires more system memory for dlmalloc, aligned to huge pages.
+ *
+ * The kernel is asked to back the region with transparent huge pages.
+ * This is done by mapping `size + align` bytes and then unmapping the
+ * misaligned head and tail.
+ *
+ * @param size must be a multiple of `align`
+ * @param align is huge page size, which must be a two power
+ * @return memory map address on success, or null w/ errno
+ */
+void *dlmalloc_requires_more_huge_gas(size_t size, size_t align) {
+  char *p, *q;
+  size_t head, tail;
+  p = mmap(0, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+           -1, 0);
+  if (p == MAP_FAILED)
+    return 0;
+  q = (char *)(((uintptr_t)p + align - 1) & -align);
+  head = q - p;
+  tail = align - head;
+  if (head)
+    munmap(p, head);
+  if (tail)
+    munmap(q + size, tail);
+  madvise(q, size, MADV_HUGEPAGE);
+  if (IsAsan()) {
+    __asan_poison(q, size, kAsanHeapFree);
+  }
+  return q;
+}
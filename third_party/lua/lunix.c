@@ -120,7 +120,9 @@
  * @support Linux, Mac, Windows, FreeBSD, NetBSD, OpenBSD
  */
 
-static lua_State *GL;
+// signal handlers run on the main thread, but redbean -n gives each of
+// its worker threads a lua_State of its own too
+static _Thread_local lua_State *GL;
 
 static void *LuaRealloc(lua_State *L, void *p, size_t n) {
   void *p2;
@@ -270,6 +270,9 @@ struct nsync_note_s_ {
 void nsync_mu_lock_slow_(nsync_mu *mu, waiter *w, uint32_t clear,
                          lock_type *l_type);
 void nsync_mu_unlock_slow_(nsync_mu *mu, lock_type *l_type);
+void nsync_mu_profile_lock_(nsync_mu *mu, void *frame);
+void nsync_mu_profile_unlock_(nsync_mu *mu);
+extern int nsync_mu_profiling_;
 struct Dll *nsync_remove_from_mu_queue_(struct Dll *mu_queue, struct Dll *e);
 void nsync_maybe_merge_conditions_(struct Dll *p, struct Dll *n);
 nsync_time nsync_note_notified_deadline_(nsync_note n);
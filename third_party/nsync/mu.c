@@ -17,6 +17,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/blockcancel.internal.h"
 #include "libc/intrin/dll.h"
+#include "libc/intrin/weaken.h"
 #include "libc/str/str.h"
 #include "third_party/nsync/atomic.h"
 #include "third_party/nsync/common.internal.h"
@@ -143,8 +144,19 @@ int nsync_mu_trylock (nsync_mu *mu) {
 	return (result);
 }
 
+/* Returns nonzero if the lock profiler is linked and LOCKPROF is set.
+   mu_profile.c is only linked into programs that yoink it, see
+   README.cosmo, so other programs don't pay for its startup code. */
+static inline int nsync_mu_profiling (void) {
+	return _weaken (nsync_mu_profiling_) && *_weaken (nsync_mu_profiling_);
+}
+
 /* Block until *mu is free and then acquire it in writer mode. */
 void nsync_mu_lock (nsync_mu *mu) {
+	if (nsync_mu_profiling ()) {
+		_weaken (nsync_mu_profile_lock_) (mu, __builtin_frame_address (0));
+		return;
+	}
 	IGNORE_RACES_START ();
 	if (!ATM_CAS_ACQ (&mu->word, 0, MU_WADD_TO_ACQUIRE)) { /* acquire CAS */
 		uint32_t old_word = ATM_LOAD (&mu->word);
@@ -450,6 +462,9 @@ void nsync_mu_unlock_slow_ (nsync_mu *mu, lock_type *l_type) {
 
 /* Unlock *mu, which must be held in write mode, and wake waiters, if appropriate. */
 void nsync_mu_unlock (nsync_mu *mu) {
+	if (nsync_mu_profiling ()) {
+		_weaken (nsync_mu_profile_unlock_) (mu);
+	}
 	IGNORE_RACES_START ();
 	/* C is not a garbage-collected language, so we cannot release until we
 	   can be sure that we will not have to touch the mutex again to wake a
@@ -0,0 +1,255 @@
+/*-*- mode:c;indent-tabs-mode:t;c-basic-offset:8;tab-width:8;coding:utf-8   -*-│
+│ vi: set noet ft=c ts=8 sw=8 fenc=utf-8                                   :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/intrin/weaken.h"
+#include "libc/nexgen32e/stackframe.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/symbols.internal.h"
+#include "libc/thread/thread.h"
+#include "third_party/nsync/common.internal.h"
+#include "third_party/nsync/mu.h"
+
+/* Lock contention profiler.
+
+   This file is only linked into programs that say:
+
+       __static_yoink("nsync_mu_profile_lock_");
+
+   In those, when the LOCKPROF environment variable is nonzero,
+   every nsync_mu_lock() and nsync_mu_unlock() in the process, which
+   includes pthread_mutex_lock() on normal mutexes, is timed. Statistics
+   are kept per lock address and call site, where the call site is the
+   two innermost return addresses, so locks taken via pthread functions
+   can be traced back to the code that called them. At exit, the sites
+   that spent the most time waiting are reported on standard error.
+
+   Since we're measuring how long locks are held anyway, contended lock
+   operations also spin for a little while before going to sleep, when
+   the site's average hold time is short enough that waking up after a
+   context switch would likely take longer than the lock is held. */
+
+#define LOCKPROF_SITES  1024 /* must be two power */
+#define LOCKPROF_HELD   16   /* max nested locks tracked per thread */
+#define LOCKPROF_REPORT 40   /* number of sites reported at exit */
+#define LOCKPROF_SPIN   20000 /* max nanoseconds to spin before sleeping */
+
+struct LockSite {
+	atomic_ulong key;
+	nsync_mu *mu;
+	intptr_t site[2];
+	atomic_ulong acquires;
+	atomic_ulong contended;
+	atomic_ulong spinwins;
+	atomic_ulong wait_ns;
+	atomic_ulong hold_ns;
+};
+
+struct LockHeld {
+	nsync_mu *mu;
+	struct LockSite *s;
+	uint64_t start;
+};
+
+int nsync_mu_profiling_;
+static atomic_ulong lockprof_dropped;
+static struct LockSite lockprof_sites[LOCKPROF_SITES];
+static _Thread_local int lockprof_depth;
+static _Thread_local struct LockHeld lockprof_held[LOCKPROF_HELD];
+
+static uint64_t lockprof_now (void) {
+	struct timespec ts = timespec_mono ();
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t lockprof_hash (uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return x | 1;
+}
+
+/* Returns statistics for lock at call site, or null if table is full. */
+static struct LockSite *lockprof_site (nsync_mu *mu, struct StackFrame *f) {
+	unsigned i, n;
+	uint64_t key, old;
+	intptr_t site0, site1;
+	struct LockSite *s;
+	site0 = f ? f->addr : 0;
+	site1 = f && f->next ? f->next->addr : 0;
+	key = lockprof_hash ((uintptr_t) mu ^ lockprof_hash (site0 ^
+	                     lockprof_hash (site1)));
+	for (i = key, n = 0; n < LOCKPROF_SITES; ++i, ++n) {
+		s = lockprof_sites + (i & (LOCKPROF_SITES - 1));
+		old = atomic_load_explicit (&s->key, memory_order_acquire);
+		if (old == key) {
+			return s;
+		}
+		if (!old) {
+			if (atomic_compare_exchange_strong_explicit (
+				    &s->key, &old, key, memory_order_acq_rel,
+				    memory_order_acquire)) {
+				s->mu = mu;
+				s->site[0] = site0;
+				s->site[1] = site1;
+				return s;
+			}
+			if (old == key) {
+				return s;
+			}
+		}
+	}
+	atomic_fetch_add_explicit (&lockprof_dropped, 1, memory_order_relaxed);
+	return 0;
+}
+
+/* Returns how long a contended lock at site should spin before sleeping. */
+static uint64_t lockprof_spin_budget (struct LockSite *s) {
+	uint64_t n, hold;
+	if (!s || !(n = atomic_load_explicit (&s->acquires, memory_order_relaxed))) {
+		return 0;
+	}
+	hold = atomic_load_explicit (&s->hold_ns, memory_order_relaxed) / n;
+	if (hold > LOCKPROF_SPIN) {
+		return 0;
+	}
+	return hold * 2 < LOCKPROF_SPIN ? hold * 2 : LOCKPROF_SPIN;
+}
+
+/* Implements nsync_mu_lock() when profiling. */
+void nsync_mu_profile_lock_ (nsync_mu *mu, void *frame) {
+	waiter *w;
+	struct LockSite *s;
+	uint64_t start, now, budget;
+	s = lockprof_site (mu, frame);
+	start = lockprof_now ();
+	now = start;
+	if (!nsync_mu_trylock (mu)) {
+		if (s) {
+			atomic_fetch_add_explicit (&s->contended, 1,
+						   memory_order_relaxed);
+		}
+		budget = lockprof_spin_budget (s);
+		for (;;) {
+			if (now - start >= budget) {
+				w = nsync_waiter_new_ ();
+				nsync_mu_lock_slow_ (mu, w, 0, nsync_writer_type_);
+				nsync_waiter_free_ (w);
+				break;
+			}
+			pthread_pause_np ();
+			if (nsync_mu_trylock (mu)) {
+				if (s) {
+					atomic_fetch_add_explicit (
+						&s->spinwins, 1, memory_order_relaxed);
+				}
+				break;
+			}
+			now = lockprof_now ();
+		}
+		now = lockprof_now ();
+	}
+	if (s) {
+		atomic_fetch_add_explicit (&s->acquires, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit (&s->wait_ns, now - start,
+					   memory_order_relaxed);
+	}
+	if (lockprof_depth < LOCKPROF_HELD) {
+		lockprof_held[lockprof_depth].mu = mu;
+		lockprof_held[lockprof_depth].s = s;
+		lockprof_held[lockprof_depth].start = now;
+	}
+	++lockprof_depth;
+}
+
+/* Called by nsync_mu_unlock() when profiling. */
+void nsync_mu_profile_unlock_ (nsync_mu *mu) {
+	int i;
+	struct LockHeld *h;
+	for (i = lockprof_depth < LOCKPROF_HELD ? lockprof_depth : LOCKPROF_HELD;
+	     i--;) {
+		h = lockprof_held + i;
+		if (h->mu == mu) {
+			if (h->s) {
+				atomic_fetch_add_explicit (&h->s->hold_ns,
+							   lockprof_now () - h->start,
+							   memory_order_relaxed);
+			}
+			/* locks aren't always released in reverse order */
+			for (; i + 1 < LOCKPROF_HELD && i + 1 < lockprof_depth; ++i) {
+				lockprof_held[i] = lockprof_held[i + 1];
+			}
+			--lockprof_depth;
+			return;
+		}
+	}
+	/* lock was acquired by trylock, or before profiling began */
+}
+
+static void nsync_mu_profile_report_ (void) {
+	int i, j, n, k;
+	uint64_t acquires;
+	static struct LockSite *v[LOCKPROF_SITES];
+	struct LockSite *t;
+	nsync_mu_profiling_ = 0;
+	for (n = i = 0; i < LOCKPROF_SITES; ++i) {
+		if (atomic_load_explicit (&lockprof_sites[i].key, memory_order_acquire) &&
+		    atomic_load_explicit (&lockprof_sites[i].contended, memory_order_relaxed)) {
+			v[n++] = lockprof_sites + i;
+		}
+	}
+	/* sort by wait time descending */
+	for (i = 1; i < n; ++i) {
+		t = v[i];
+		for (j = i; j && v[j - 1]->wait_ns < t->wait_ns; --j) {
+			v[j] = v[j - 1];
+		}
+		v[j] = t;
+	}
+	if (_weaken (GetSymbolTable)) {
+		_weaken (GetSymbolTable) ();
+	}
+	kprintf ("\nlockprof: %d contended lock sites", n);
+	if (lockprof_dropped) {
+		kprintf (" (%lu acquisitions not tracked)", lockprof_dropped);
+	}
+	kprintf ("\n%12s %12s %10s %10s %10s %-14s %s\n", "wait_us", "hold_us",
+		 "acquires", "contended", "spinwins", "mutex", "call site");
+	for (k = 0; k < n && k < LOCKPROF_REPORT; ++k) {
+		t = v[k];
+		acquires = t->acquires;
+		kprintf ("%12lu %12lu %10lu %10lu %10lu %-14p %t <- %t\n",
+			 t->wait_ns / 1000, t->hold_ns / 1000, acquires,
+			 (uint64_t) t->contended, (uint64_t) t->spinwins, t->mu,
+			 t->site[0], t->site[1]);
+	}
+}
+
+__attribute__((__constructor__(90))) static textstartup void
+nsync_mu_profile_init_ (void) {
+	const char *s;
+	if ((s = getenv ("LOCKPROF")) && *s && *s != '0') {
+		nsync_mu_profiling_ = 1;
+		atexit (nsync_mu_profile_report_);
+	}
+}
@@ -40,6 +40,12 @@
 
 #define ZIP_CFILE_HDR_SIZE (kZipCfileHdrMinSize + 36)
 
+// large files get a full flush every FLUSH_SPAN bytes, which lets the
+// runtime inflate them on several threads and seek within them. the
+// offsets are stored in a kZipExtraFlushPoints field of the cdir.
+#define FLUSH_SPAN       262144
+#define FLUSH_POINTS_MAX ((65535 - kZipExtraHdrSize - 4) / 4)
+
 static bool ShouldCompress(const char *name, size_t namesize,
                            const unsigned char *data, size_t datasize,
                            bool nocompress) {
@@ -90,7 +96,9 @@ static void EmitZipCdirHdr(unsigned char *p, const void *name, size_t namesize,
                            uint16_t iattrs, uint16_t dosmode, uint16_t unixmode,
                            size_t compsize, size_t uncompsize,
                            size_t commentsize, struct timespec mtim,
-                           struct timespec atim, struct timespec ctim) {
+                           struct timespec atim, struct timespec ctim,
+                           const uint32_t *points, size_t npoints) {
+  size_t i;
   uint64_t mt, at, ct;
   p = WRITE32LE(p, kZipCfileHdrMagic);
   *p++ = kZipCosmopolitanVersion;
@@ -106,7 +114,7 @@ static void EmitZipCdirHdr(unsigned char *p, const void *name, size_t namesize,
   p = WRITE32LE(p, compsize);
   p = WRITE32LE(p, uncompsize);
   p = WRITE16LE(p, namesize);
-  p = WRITE16LE(p, 36); /* extra size */
+  p = WRITE16LE(p, 36 + (npoints ? kZipExtraHdrSize + 4 + npoints * 4 : 0));
   /* 32 */
   p = WRITE16LE(p, commentsize);
   p = WRITE16LE(p, 0); /* disk */
@@ -128,6 +136,13 @@ static void EmitZipCdirHdr(unsigned char *p, const void *name, size_t namesize,
   p = WRITE64LE(p, mt);
   p = WRITE64LE(p, at);
   p = WRITE64LE(p, ct);
+  if (npoints) {
+    p = WRITE16LE(p, kZipExtraFlushPoints);
+    p = WRITE16LE(p, 4 + npoints * 4);
+    p = WRITE32LE(p, FLUSH_SPAN);
+    for (i = 0; i < npoints; ++i)
+      p = WRITE32LE(p, points[i]);
+  }
 }
 
 /**
@@ -140,8 +155,10 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
   z_stream zs;
   uint8_t era;
   uint32_t crc;
+  uint32_t *points;
   unsigned char *lfile, *cfile;
   struct ElfWriterSymRef lfilesym;
+  size_t i, npoints, cfilesize;
   size_t lfilehdrsize, uncompsize, compsize, commentsize;
   uint16_t method, gflags, mtime, mdate, iattrs, dosmode;
 
@@ -156,6 +173,8 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
 
   gflags = 0;
   iattrs = 0;
+  npoints = 0;
+  points = 0;
   compsize = size;
   commentsize = 0;
   uncompsize = size;
@@ -181,17 +200,32 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
                                 Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
                                 MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY));
     zs.next_in = data;
-    zs.avail_in = uncompsize;
     zs.next_out = ((lfile = elfwriter_reserve(
                         elf, (lfilehdrsize +
                               (zs.avail_out = compressBound(uncompsize))))) +
                    lfilehdrsize);
+    if (uncompsize > FLUSH_SPAN &&
+        (uncompsize - 1) / FLUSH_SPAN <= FLUSH_POINTS_MAX) {
+      points = gc(calloc((uncompsize - 1) / FLUSH_SPAN, sizeof(*points)));
+      for (i = 0; i + FLUSH_SPAN < uncompsize; i += FLUSH_SPAN) {
+        if (i)
+          points[npoints++] = zs.total_out;
+        zs.avail_in = FLUSH_SPAN;
+        CHECK_EQ(Z_OK, deflate(&zs, Z_FULL_FLUSH));
+        CHECK_EQ(0, zs.avail_in);
+      }
+      points[npoints++] = zs.total_out;
+      zs.avail_in = uncompsize - i;
+    } else {
+      zs.avail_in = uncompsize;
+    }
     CHECK_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
     CHECK_EQ(Z_OK, deflateEnd(&zs));
     if (zs.total_out < uncompsize) {
       compsize = zs.total_out;
     } else {
       method = kZipCompressionNone;
+      npoints = 0;
     }
   } else {
     lfile = elfwriter_reserve(elf, lfilehdrsize + uncompsize);
@@ -213,15 +247,18 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
   /* emit central directory record */
   elfwriter_align(elf, 1, 0);
   elfwriter_startsection(elf, ".zip.cdir", SHT_PROGBITS, 0);
-  EmitZipCdirHdr(
-      (cfile = elfwriter_reserve(elf, ZIP_CFILE_HDR_SIZE + namesize)), name,
-      namesize, crc, era, gflags, method, mtime, mdate, iattrs, dosmode, mode,
-      compsize, uncompsize, commentsize, mtim, atim, ctim);
+  cfilesize = ZIP_CFILE_HDR_SIZE + namesize;
+  if (npoints)
+    cfilesize += kZipExtraHdrSize + 4 + npoints * 4;
+  EmitZipCdirHdr((cfile = elfwriter_reserve(elf, cfilesize)), name, namesize,
+                 crc, era, gflags, method, mtime, mdate, iattrs, dosmode, mode,
+                 compsize, uncompsize, commentsize, mtim, atim, ctim, points,
+                 npoints);
   elfwriter_appendsym(elf, gc(xasprintf("%s%s", "zip+cdir:", name)),
                       ELF64_ST_INFO(STB_LOCAL, STT_OBJECT), STV_DEFAULT, 0,
-                      ZIP_CFILE_HDR_SIZE + namesize);
+                      cfilesize);
   elfwriter_appendrela(elf, kZipCfileOffsetOffset, lfilesym,
                        elfwriter_relatype_pc32(elf), 0);
-  elfwriter_commit(elf, ZIP_CFILE_HDR_SIZE + namesize);
+  elfwriter_commit(elf, cfilesize);
   elfwriter_finishsection(elf);
 }
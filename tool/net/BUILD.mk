@@ -67,6 +67,7 @@ TOOL_NET_DIRECTDEPS =							\
 	THIRD_PARTY_SQLITE3						\
 	THIRD_PARTY_TZ							\
 	THIRD_PARTY_ZLIB						\
+	THIRD_PARTY_ZSTD						\
 	TOOL_ARGS							\
 	TOOL_BUILD_LIB							\
 	TOOL_DECODE_LIB							\
@@ -92,6 +93,7 @@ o/$(MODE)/tool/net/%.dbg:						\
 # The little web server that could!
 
 TOOL_NET_REDBEAN_LUA_MODULES =						\
+	o/$(MODE)/tool/net/assetindex.o					\
 	o/$(MODE)/tool/net/lfuncs.o					\
 	o/$(MODE)/tool/net/lpath.o					\
 	o/$(MODE)/tool/net/lfinger.o					\
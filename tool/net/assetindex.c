@@ -0,0 +1,149 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "tool/net/assetindex.h"
+#include "libc/intrin/bsr.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/crc32.h"
+#include "libc/str/str.h"
+#include "libc/x/x.h"
+
+/**
+ * @fileoverview redbean zip asset name index
+ *
+ * This is an open addressing hash table in the style of SwissTable.
+ * Each slot has a one byte tag holding seven bits of the hash, which
+ * are stored contiguously, so a probe can compare sixteen slots with
+ * one vector instruction, before touching the lengths, full hashes,
+ * or names of the candidates. The central directory records, which
+ * are scattered across the zip, only get read once a match is likely.
+ *
+ * Names are remembered as offsets relative to `base` rather than as
+ * pointers, so that when the zip gets mapped again at some different
+ * address, the index can be kept by assigning the new mapping to it.
+ */
+
+#define GROUP 16
+
+static unsigned MatchTags(const uint8_t *p, uint8_t tag) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+  return __builtin_ia32_pmovmskb128(*(const xmm_t *)p ==
+                                    (xmm_t){0} + (char)tag);
+#else
+  unsigned i, m;
+  for (m = i = 0; i < GROUP; ++i)
+    m |= (unsigned)(p[i] == tag) << i;
+  return m;
+#endif
+}
+
+static uint8_t GetTag(uint32_t hash) {
+  return 0x80 | hash >> 25;  // zero means empty
+}
+
+/**
+ * Hashes asset name.
+ */
+uint32_t HashAssetName(const char *name, size_t size) {
+  return crc32c(0, name, size);
+}
+
+/**
+ * Allocates index with room for at least `count` slots.
+ *
+ * The caller should ask for more slots than there'll be entries, since
+ * lookups of missing names need to find an empty slot.
+ */
+void InitAssetIndex(struct AssetIndex *x, size_t count) {
+  x->n = MAX(GROUP, count > 1 ? 2ul << bsrl(count - 1) : 1);
+  x->tags = xcalloc(x->n + GROUP, 1);
+  x->sizes = xcalloc(x->n, sizeof(*x->sizes));
+  x->hashes = xcalloc(x->n, sizeof(*x->hashes));
+  x->names = xcalloc(x->n, sizeof(*x->names));
+}
+
+/**
+ * Frees index.
+ */
+void FreeAssetIndex(struct AssetIndex *x) {
+  free(x->tags);
+  free(x->sizes);
+  free(x->hashes);
+  free(x->names);
+  bzero(x, sizeof(*x));
+}
+
+/**
+ * Adds name to index.
+ *
+ * The name memory isn't copied, so it needs to stay at the same offset
+ * from `x->base` for as long as the index does. There must be an empty
+ * slot left.
+ *
+ * @return slot index of new entry
+ */
+uint32_t AddAssetIndex(struct AssetIndex *x, const char *name, size_t size) {
+  unsigned m;
+  uint8_t tag;
+  uint32_t h, i, j, step;
+  h = HashAssetName(name, size);
+  tag = GetTag(h);
+  for (i = h, step = 0;; i += (step += GROUP)) {
+    i &= x->n - 1;
+    if ((m = MatchTags(x->tags + i, 0))) {
+      j = (i + __builtin_ctz(m)) & (x->n - 1);
+      x->tags[j] = tag;
+      if (j < GROUP)
+        x->tags[x->n + j] = tag;  // mirror so groups can wrap around
+      x->sizes[j] = size;
+      x->hashes[j] = h;
+      x->names[j] = (uintptr_t)name - (uintptr_t)x->base;
+      return j;
+    }
+  }
+}
+
+/**
+ * Looks up name in index.
+ *
+ * @return slot index of first entry with name, or -1 if not found
+ */
+long FindAssetIndex(const struct AssetIndex *x, const char *name,
+                    size_t size) {
+  unsigned m;
+  uint8_t tag;
+  uint32_t h, i, j, step;
+  if (!x->n)
+    return -1;
+  h = HashAssetName(name, size);
+  tag = GetTag(h);
+  for (i = h, step = 0;; i += (step += GROUP)) {
+    i &= x->n - 1;
+    for (m = MatchTags(x->tags + i, tag); m; m &= m - 1) {
+      j = (i + __builtin_ctz(m)) & (x->n - 1);
+      if (x->hashes[j] == h && x->sizes[j] == size &&
+          !memcmp(x->base + x->names[j], name, size)) {
+        return j;
+      }
+    }
+    if (MatchTags(x->tags + i, 0))
+      return -1;
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef COSMOPOLITAN_TOOL_NET_ASSETINDEX_H_
+#define COSMOPOLITAN_TOOL_NET_ASSETINDEX_H_
+COSMOPOLITAN_C_START_
+
+struct AssetIndex {
+  uint32_t n;          /* number of slots, a power of two */
+  uint8_t *tags;       /* n+16 tags, where zero means empty */
+  uint16_t *sizes;     /* name length of each slot */
+  uint32_t *hashes;    /* full hash of each slot */
+  uint64_t *names;     /* name of each slot, as offset from base */
+  const char *base;    /* memory holding the names, e.g. zip mapping */
+};
+
+void InitAssetIndex(struct AssetIndex *, size_t);
+void FreeAssetIndex(struct AssetIndex *);
+uint32_t AddAssetIndex(struct AssetIndex *, const char *, size_t);
+long FindAssetIndex(const struct AssetIndex *, const char *, size_t);
+uint32_t HashAssetName(const char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_TOOL_NET_ASSETINDEX_H_ */
@@ -1120,6 +1120,16 @@ function EvadeDragnetSurveillance(bool) end
 ---   If the table includes the `close` field set to a true value,
 ---   then the connection is closed after the request is made and the
 ---   host is removed from the mapping table.
+--- - `pool` (default = `true`): returns the connection to a per-process pool
+---   once the response has been read, so later requests to the same scheme,
+---   host and port can reuse it. This works for both HTTP and HTTPS, and TLS
+---   sessions are also remembered so new connections to a host can resume them
+---   rather than doing a full handshake. Up to 8 idle connections are kept for
+---   30 seconds. Pooling is disabled when the `keepalive` option is used.
+--- - `ondata`: a function that is called with each piece of the response body
+---   as it arrives, so large bodies don't have to be buffered in memory. The
+---   returned body is then empty. Returning `false` from the callback stops
+---   reading and closes the connection.
 ---
 --- When the redirect is being followed, the same method and body values are being
 --- sent in all cases except when 303 status is returned. In that case the method
@@ -1127,10 +1137,10 @@ function EvadeDragnetSurveillance(bool) end
 --- that if these (method/body) values are provided as table fields, they will be
 --- modified in place.
 ---@param url string
----@param body? string|{ headers: table<string,string>, value: string, method: string, body: string, maxredirects: integer?, keepalive: boolean? }
+---@param body? string|{ headers: table<string,string>, value: string, method: string, body: string, maxredirects: integer?, keepalive: boolean?, pool: boolean?, ondata: fun(data: string): boolean? }
 ---@return integer status, table<string,string> headers, string body/
 ---@nodiscard
----@overload fun(url:string, body?: string|{ headers: table<string,string>, value: string, method: string, body: string, maxredirects?: integer, keepalive: boolean? }): nil, error: string
+---@overload fun(url:string, body?: string|{ headers: table<string,string>, value: string, method: string, body: string, maxredirects?: integer, keepalive: boolean?, pool: boolean?, ondata: fun(data: string): boolean? }): nil, error: string
 function Fetch(url, body) end
 
 --- Converts UNIX timestamp to an RFC1123 string that looks like this:
@@ -1661,6 +1671,27 @@ function ProgramHeader(name, value) end
 ---@param milliseconds integer Negative values `(<0)` sets the interval in seconds.
 function ProgramHeartbeatInterval(milliseconds) end
 
+--- Enables HTTP/2 support. When enabled, TLS clients are offered `h2` using
+--- ALPN, and plaintext clients may speak HTTP/2 with prior knowledge. Each
+--- stream is dispatched as an ordinary request, so `OnHttpRequest` and Lua
+--- server pages work the same. Request handlers run one at a time, but their
+--- responses are multiplexed as HTTP/2 flow control permits. The default is
+--- `false`. This function should only be called from `/.init.lua`. The current
+--- value is returned.
+---@param bool boolean?
+---@return boolean
+function ProgramHttp2(bool) end
+
+--- Sets the size of the memory region which is shared by all workers for caching
+--- compressed zip assets that had to be decoded because the client didn't accept
+--- their encoding. The least recently used entries are evicted when it's full.
+--- Assets larger than a quarter of the cache are always inflated on the fly. The
+--- default is 8mb and `0` disables the cache. This function should only be
+--- called from `/.init.lua`. The current value is returned.
+---@param bytes integer?
+---@return integer
+function ProgramInflateCacheSize(bytes) end
+
 ---@param milliseconds integer Negative values `(<0)` sets the interval in seconds.
 --- Default timeout is 60000ms. Minimal value of timeout is 10(ms).
 --- This should only be called from `/.init.lua`.
@@ -1672,6 +1703,35 @@ function ProgramTimeout(milliseconds) end
 ---@param uint16 integer
 function ProgramPort(uint16) end
 
+--- Same as the `-N` flag if called from `.init.lua`. When this is nonzero,
+--- redbean launches this many long-lived worker processes up front, which take
+--- turns accepting connections from the listening sockets. Each worker serves
+--- many connections, so the `OnWorkerStart` hook and the sandbox are only
+--- applied once per worker. Workers which exit are replaced automatically. On
+--- Linux, workers hand idle plaintext keep-alive connections over to epoll, so a
+--- single worker can hold thousands of them open and only resumes serving one
+--- when its next request arrives. The default is `0` which forks a new worker
+--- for each connection. The current value is returned.
+---@param workers integer?
+---@return integer
+function ProgramPreforkWorkers(workers) end
+
+--- Same as the `-n` flag if called from `.init.lua`. When this is nonzero,
+--- redbean serves connections on this many threads of the main process, rather
+--- than forking. Each thread has its own buffers, message parser and Lua
+--- interpreter, which runs `.init.lua` again when the thread starts, and then
+--- `OnWorkerStart`. `Program*()` and `StoreAsset()` calls are ignored while a
+--- thread runs `.init.lua`, and raise an error if a thread calls them later,
+--- since they'd change the configuration of every thread. Lua globals set while
+--- serving a request are only seen by requests served later on the same thread.
+--- The zip asset index is shared by all threads, so the zip isn't reloaded while
+--- they're running. TLS and the sandbox aren't thread safe, so if `-X` isn't
+--- passed, or if `-u`, `-N` or `-S` are used, a warning is logged and processes
+--- are used. The default is `0`. The current value is returned.
+---@param threads integer?
+---@return integer
+function ProgramWorkerThreads(threads) end
+
 --- Sets the maximum HTTP message payload size in bytes. The
 --- default is very conservatively set to 65536 so this is
 --- something many people will want to increase. This limit is
@@ -1858,6 +1918,15 @@ function ProgramPidPath(str) end
 ---@return boolean
 function ProgramUniprocess(bool) end
 
+--- Enables zstd content encoding of dynamic responses, for clients that accept
+--- it, at the specified compression level. The default is `0` which means
+--- responses are gzip encoded as usual. Levels 1 through 3 are usually faster
+--- than gzip, while also compressing better. This function should only be
+--- called from `/.init.lua`. The current value is returned.
+---@param level integer?
+---@return integer
+function ProgramZstdLevel(level) end
+
 --- Reads all data from file the easy way.
 ---
 --- This function reads file data from local file system. Zip file assets can be
@@ -121,14 +121,15 @@ struct sdb {
 static const char *const sqlite_meta      = ":sqlite3";
 static const char *const sqlite_vm_meta   = ":sqlite3:vm";
 static const char *const sqlite_ctx_meta  = ":sqlite3:ctx";
-static int sqlite_ctx_meta_ref;
+/* registry refs are per lua_State, and redbean -n has one per thread */
+static _Thread_local int sqlite_ctx_meta_ref;
 #ifdef SQLITE_ENABLE_SESSION
 static const char *const sqlite_ses_meta  = ":sqlite3:ses";
 static const char *const sqlite_reb_meta  = ":sqlite3:reb";
 static const char *const sqlite_itr_meta  = ":sqlite3:itr";
-static int sqlite_ses_meta_ref;
-static int sqlite_reb_meta_ref;
-static int sqlite_itr_meta_ref;
+static _Thread_local int sqlite_ses_meta_ref;
+static _Thread_local int sqlite_reb_meta_ref;
+static _Thread_local int sqlite_itr_meta_ref;
 #endif
 /* global config configuration */
 static int log_cb = LUA_NOREF; /* log callback */
@@ -2029,11 +2030,11 @@ static int db_create_rebaser(lua_State *L) {
 
 /* session/changeset callbacks */
 
-static int changeset_conflict_cb = LUA_NOREF;
-static int changeset_filter_cb = LUA_NOREF;
-static int changeset_cb_udata = LUA_NOREF;
-static int session_filter_cb = LUA_NOREF;
-static int session_cb_udata = LUA_NOREF;
+static _Thread_local int changeset_conflict_cb = LUA_NOREF;
+static _Thread_local int changeset_filter_cb = LUA_NOREF;
+static _Thread_local int changeset_cb_udata = LUA_NOREF;
+static _Thread_local int session_filter_cb = LUA_NOREF;
+static _Thread_local int session_cb_udata = LUA_NOREF;
 
 static int db_changeset_conflict_callback(
         void *user,               /* Copy of sixth arg to _apply_v2() */
@@ -47,6 +47,7 @@
 #include "libc/log/log.h"
 #include "libc/macros.internal.h"
 #include "libc/math.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/alloca.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
@@ -61,6 +62,7 @@
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
 #include "libc/serialize.h"
+#include "libc/sock/epoll.h"
 #include "libc/sock/goodsocket.internal.h"
 #include "libc/sock/sock.h"
 #include "libc/sock/struct/pollfd.h"
@@ -77,6 +79,7 @@
 #include "libc/sysv/consts/clock.h"
 #include "libc/sysv/consts/clone.h"
 #include "libc/sysv/consts/dt.h"
+#include "libc/sysv/consts/epoll.h"
 #include "libc/sysv/consts/ex.h"
 #include "libc/sysv/consts/exit.h"
 #include "libc/sysv/consts/f.h"
@@ -105,6 +108,7 @@
 #include "libc/zip.internal.h"
 #include "net/http/escape.h"
 #include "net/http/http.h"
+#include "net/http/http2.h"
 #include "net/http/ip.h"
 #include "net/http/tokenbucket.h"
 #include "net/http/url.h"
@@ -127,8 +131,10 @@
 #include "third_party/mbedtls/x509_crt.h"
 #include "third_party/musl/netdb.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 #include "tool/args/args.h"
 #include "tool/build/lib/case.h"
+#include "tool/net/assetindex.h"
 #include "tool/net/lfinger.h"
 #include "tool/net/lfuncs.h"
 #include "tool/net/ljson.h"
@@ -171,7 +177,10 @@ __static_yoink("blink_xnu_aarch64");    // is apple silicon
 
 #define VERSION          0x020200
 #define HASH_LOAD_FACTOR /* 1. / */ 4
+#define SENDFILE_MIN     16384
+#define INFLATE_SLOTS    256
 #define MONITOR_MICROS   150000
+#define EPOLL_CLIENT     0x100000000ull
 #define READ(F, P, N)    readv(F, &(struct iovec){P, N}, 1)
 #define WRITE(F, P, N)   writev(F, &(struct iovec){P, N}, 1)
 #define AppendCrlf(P)    mempcpy(P, "\r\n", 2)
@@ -211,11 +220,11 @@ __static_yoink("blink_xnu_aarch64");    // is apple silicon
     }                       \
   } while (0)
 
-// letters not used: INOQYnoqwxy
+// letters not used: IOQYnoqxy
 // digits not used:  0123456789
 // puncts not used:  !"#$&'()+,-./;<=>@[\]^_`{|}~
 #define GETOPTS \
-  "*%BEJSVXZabdfghijkmsuvzA:C:D:F:G:H:K:L:M:P:R:T:U:W:c:e:l:p:r:t:w:"
+  "*%BEJSVXZabdfghijkmsuvzA:C:D:F:G:H:K:L:M:N:P:R:T:U:W:c:e:l:n:p:r:t:w:"
 
 static const uint8_t kGzipHeader[] = {
     0x1F,        // MAGNUM
@@ -242,6 +251,12 @@ static const char *const kAlpn[] = {
     NULL,
 };
 
+static const char *const kAlpnHttp2[] = {
+    "h2",
+    "http/1.1",
+    NULL,
+};
+
 struct Buffer {
   size_t n, c;
   char *p;
@@ -290,12 +305,12 @@ static struct Servers {
   } *p;
 } servers;
 
-static struct Freelist {
+static _Thread_local struct Freelist {
   size_t n, c;
   void **p;
 } freelist;
 
-static struct Unmaplist {
+static _Thread_local struct Unmaplist {
   size_t n, c;
   struct Unmap {
     int f;
@@ -336,9 +351,11 @@ static struct Redirects {
 
 static struct Assets {
   uint32_t n;
+  uint32_t live;
+  struct AssetIndex index;
   struct Asset {
     bool istext;
-    uint32_t hash;
+    bool isverified;
     uint64_t cf;
     uint64_t lf;
     int64_t lastmodified;
@@ -350,6 +367,20 @@ static struct Assets {
   } *p;
 } assets;
 
+static struct Keepalives {
+  size_t n;
+  size_t idle;
+  struct Keepalive {
+    bool isparked;
+    bool isregistered;
+    int messageshandled;
+    struct sockaddr_in clientaddr;
+    struct sockaddr_in *serveraddr;
+    struct timespec startconnection;
+    struct timespec lastactive;
+  } *p;
+} keepalives;
+
 static struct TrustedIps {
   size_t n;
   struct TrustedIp {
@@ -391,6 +422,22 @@ static struct Shared {
   pthread_spinlock_t montermlock;
 } *shared;
 
+static struct InflateCache {
+  atomic_ulong owner;  // pid<<32|tid of thread holding lock, or zero
+  int filling;         // slot being written by owner, or -1
+  uint64_t tick;
+  size_t size;
+  struct InflateEntry {
+    uint64_t ino;
+    uint64_t cf;
+    uint32_t crc;
+    size_t size;
+    size_t off;
+    uint64_t lastuse;
+  } e[INFLATE_SLOTS];
+  char data[];
+} *inflatecache;
+
 static const char kCounterNames[] =
 #define C(x) #x "\0"
 #include "tool/net/counters.inc"
@@ -400,7 +447,7 @@ static const char kCounterNames[] =
 typedef ssize_t (*reader_f)(int, void *, size_t);
 typedef ssize_t (*writer_f)(int, struct iovec *, int);
 
-struct ClearedPerMessage {
+_Thread_local struct ClearedPerMessage {
   bool istext;
   bool branded;
   bool hascontenttype;
@@ -412,6 +459,7 @@ struct ClearedPerMessage {
   char *outbuf;
   char *content;
   size_t gzipped;
+  const char *encoding;
   size_t contentlength;
   char *luaheaderp;
   const char *referrerpolicy;
@@ -421,10 +469,50 @@ struct ClearedPerMessage {
   struct HttpMessage msg;
 } cpm;
 
+static _Thread_local struct Http2 {
+  bool closing;
+  bool goaway;
+  bool gotsettings;
+  bool contend;
+  uint32_t contid;
+  uint32_t lastid;
+  uint32_t maxframe;
+  int64_t window;
+  int64_t initwindow;
+  size_t n, inlen, incap, outlen;
+  char *in, *out, *block;
+  struct Hpack hpack;
+  struct Http2Stream {
+    bool done;
+    bool ended;
+    bool reset;
+    bool handled;
+    bool toolarge;
+    bool malformed;
+    bool gotheaders;
+    bool gotregular;
+    uint8_t pseudos;
+    uint32_t id;
+    int64_t window;
+    char *method;
+    char *path;
+    char *authority;
+    char *head;
+    char *cookie;
+    char *body;
+    char *hdrs;
+    char *own;
+    const char *data;
+    size_t hdrslen;
+    size_t datalen;
+    size_t sent;
+  } *p, *cur;
+} h2;
+
 static bool suiteb;
+static bool http2;
 static bool killed;
 static bool zombied;
-static bool usingssl;
 static bool funtrace;
 static bool systrace;
 static bool meltdown;
@@ -440,6 +528,7 @@ static bool loglatency;
 static bool terminated;
 static bool uniprocess;
 static bool invalidated;
+static bool needworkers;
 static bool logmessages;
 static bool isinitialized;
 static bool sslinitialized;
@@ -447,7 +536,6 @@ static bool sslfetchverify;
 static bool selfmodifiable;
 static bool interpretermode;
 static bool sslclientverify;
-static bool connectionclose;
 static bool hasonloglatency;
 static bool hasonworkerstop;
 static bool isexitingworker;
@@ -455,50 +543,47 @@ static bool hasonworkerstart;
 static bool leakcrashreports;
 static bool hasonhttprequest;
 static bool hasonerror;
-static bool ishandlingrequest;
 static bool listeningonport443;
 static bool hasonprocesscreate;
 static bool hasonprocessdestroy;
-static bool ishandlingconnection;
 static bool hasonclientconnection;
 static bool evadedragnetsurveillance;
 
 static int zfd;
+static int zmapfd = -1;
+static int epfd = -1;
 static int gmtoff;
-static int client;
 static int mainpid;
 static int sandboxed;
 static int changeuid;
 static int changegid;
 static int maxworkers;
+static int preforkworkers;
+static int workerthreads;
+static int respawnfailures;
 static int shutdownsig;
 static int sslpskindex;
 static int oldloglevel;
-static int messageshandled;
 static int sslticketlifetime;
-static uint32_t clientaddrsize;
 static atomic_int terminatemonitor;
 
 static char *brand;
 static size_t zsize;
-static lua_State *GL;
-static lua_State *YL;
 static uint8_t *zmap;
 static uint8_t *zcdir;
-static size_t hdrsize;
-static size_t amtread;
-static reader_f reader;
-static writer_f writer;
+static uint32_t zcdircrc;
+static uint64_t zcdiroffset;
+static uint64_t zcdirsize;
 static char *extrahdrs;
 static const char *zpath;
 static char *serverheader;
-static char gzip_footer[8];
 static long maxpayloadsize;
+static long inflatecachesize = 8 * 1024 * 1024;
+static int zstdlevel;
 static const char *pidpath;
 static const char *logpath;
 static uint32_t *interfaces;
 static struct pollfd *polls;
-static size_t payloadlength;
 static int64_t cacheseconds;
 static char *cachedirective;
 static const char *monitortty;
@@ -508,25 +593,14 @@ static const char *launchbrowser;
 static const char ctIdx = 'c';  // a pseudo variable to get address of
 
 static pthread_t monitorth;
-static struct Buffer inbuf_actual;
-static struct Buffer inbuf;
-static struct Buffer oldin;
-static struct Buffer hdrbuf;
 static struct timeval timeout;
-static struct Buffer effectivepath;
 static struct timespec heartbeatinterval;
 
-static struct Url url;
-
 static struct stat zst;
-static struct timespec startread;
 static struct timespec lastrefresh;
 static struct timespec startserver;
-static struct timespec startrequest;
 static struct timespec lastheartbeat;
-static struct timespec startconnection;
-static struct sockaddr_in clientaddr;
-static struct sockaddr_in *serveraddr;
+static struct timespec respawnafter;
 
 static mbedtls_ssl_config conf;
 static mbedtls_ssl_context ssl;
@@ -534,12 +608,43 @@ static mbedtls_ctr_drbg_context rng;
 static mbedtls_ssl_ticket_context ssltick;
 
 static mbedtls_ssl_config confcli;
-static mbedtls_ssl_context sslcli;
 static mbedtls_ctr_drbg_context rngcli;
 
 static struct TlsBio g_bio;
-static char slashpath[PATH_MAX];
-static struct DeflateGenerator dg;
+
+// per-connection state is thread local, so that -n can serve clients on
+// threads which each have their own lua interpreter. tls state is not,
+// since -n falls back to forking when tls is enabled.
+static _Thread_local bool usingssl;
+static _Thread_local bool isinitializingthread;
+static _Thread_local bool clientparked;
+static _Thread_local bool connectionclose;
+static _Thread_local bool ishandlingrequest;
+static _Thread_local bool ishandlingconnection;
+static _Thread_local int client;
+static _Thread_local int messageshandled;
+static _Thread_local uint32_t clientaddrsize;
+static _Thread_local lua_State *GL;
+static _Thread_local lua_State *YL;
+static _Thread_local size_t hdrsize;
+static _Thread_local size_t amtread;
+static _Thread_local size_t payloadlength;
+static _Thread_local reader_f reader;
+static _Thread_local writer_f writer;
+static _Thread_local char gzip_footer[8];
+static _Thread_local struct Buffer inbuf_actual;
+static _Thread_local struct Buffer inbuf;
+static _Thread_local struct Buffer oldin;
+static _Thread_local struct Buffer hdrbuf;
+static _Thread_local struct Buffer effectivepath;
+static _Thread_local struct Url url;
+static _Thread_local struct timespec startread;
+static _Thread_local struct timespec startrequest;
+static _Thread_local struct timespec startconnection;
+static _Thread_local struct sockaddr_in clientaddr;
+static _Thread_local struct sockaddr_in *serveraddr;
+static _Thread_local char slashpath[PATH_MAX];
+static _Thread_local struct DeflateGenerator dg;
 
 static char *Route(const char *, size_t, const char *, size_t);
 static char *RouteHost(const char *, size_t, const char *, size_t);
@@ -547,6 +652,8 @@ static char *RoutePath(const char *, size_t);
 static char *HandleAsset(struct Asset *, const char *, size_t);
 static char *ServeAsset(struct Asset *, const char *, size_t);
 static char *SetStatus(unsigned, const char *);
+static bool QueueHttp2Response(char *);
+static void RecoverInflateCache(int);
 
 static void TlsInit(void);
 
@@ -826,6 +933,14 @@ static void ProgramPort(long port) {
   ports.p[ports.n - 1] = port;
 }
 
+static void ProgramPreforkWorkers(long x) {
+  preforkworkers = MAX(0, MIN(x, 4096));
+}
+
+static void ProgramWorkerThreads(long x) {
+  workerthreads = MAX(0, MIN(x, 4096));
+}
+
 static void ProgramMaxPayloadSize(long x) {
   maxpayloadsize = MAX(1450, x);
 }
@@ -990,7 +1105,7 @@ static char *DescribeClient(void) {
   char str[40];
   uint16_t port;
   uint32_t client;
-  static char description[128];
+  static _Thread_local char description[128];
   GetClientAddr(&client, &port);
   if (HasHeader(kHttpXForwardedFor) && IsTrustedIp(client)) {
     DescribeAddress(str, client, port);
@@ -1006,7 +1121,7 @@ static char *DescribeClient(void) {
 static char *DescribeServer(void) {
   uint32_t ip;
   uint16_t port;
-  static char serveraddrstr[40];
+  static _Thread_local char serveraddrstr[40];
   GetServerAddr(&ip, &port);
   DescribeAddress(serveraddrstr, ip, port);
   return serveraddrstr;
@@ -1384,7 +1499,22 @@ static void ReportWorkerResources(int pid, struct rusage *ru) {
 }
 
 static void HandleWorkerExit(int pid, int ws, struct rusage *ru) {
-  LockInc(&shared->c.connectionshandled);
+  if (!preforkworkers) {
+    LockInc(&shared->c.connectionshandled);
+  } else {
+    needworkers = true;
+    if (WIFEXITED(ws) && !WEXITSTATUS(ws)) {
+      respawnfailures = 0;
+    } else {
+      // back off exponentially, so a worker that crashes as soon as it
+      // starts, e.g. in OnWorkerStart, can't turn us into a fork bomb
+      ++respawnfailures;
+      respawnafter = timespec_add(
+          timespec_real(),
+          timespec_frommillis(MIN(60000, 100l << MIN(respawnfailures, 10))));
+    }
+  }
+  RecoverInflateCache(pid);
   rusage_add(&shared->children, ru);
   ReportWorkerExit(pid, ws);
   ReportWorkerResources(pid, ru);
@@ -1722,7 +1852,7 @@ static void CertsDestroy(void) {
 }
 
 static void WipeServingKeys(void) {
-  if (uniprocess)
+  if (uniprocess || preforkworkers)
     return;
   mbedtls_ssl_ticket_free(&ssltick);
   mbedtls_ssl_key_cert_free(conf.key_cert), conf.key_cert = 0;
@@ -2117,7 +2247,17 @@ static void LoadCertificates(void) {
 
 static bool ClientAcceptsGzip(void) {
   return cpm.msg.version >= 10 && /* RFC1945 § 3.5 */
-         HeaderHas(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "gzip", 4);
+         HeaderAccepts(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "gzip", 4);
+}
+
+static bool ClientAcceptsZstd(void) {
+  return cpm.msg.version >= 10 && /* RFC8878 § 7.2 */
+         HeaderAccepts(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "zstd", 4);
+}
+
+static bool ClientAcceptsBrotli(void) {
+  return cpm.msg.version >= 10 && /* RFC7932 § 13 */
+         HeaderAccepts(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "br", 2);
 }
 
 char *FormatUnixHttpDateTime(char *s, int64_t t) {
@@ -2142,9 +2282,13 @@ static int64_t GetGmtOffset(int64_t t) {
   return tm.tm_gmtoff;
 }
 
+forceinline int GetMethod(struct Asset *a) {
+  return a->file ? kZipCompressionNone
+                 : ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf);
+}
+
 forceinline bool IsCompressed(struct Asset *a) {
-  return !a->file &&
-         ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) == kZipCompressionDeflate;
+  return GetMethod(a) != kZipCompressionNone;
 }
 
 forceinline int GetMode(struct Asset *a) {
@@ -2152,16 +2296,8 @@ forceinline int GetMode(struct Asset *a) {
 }
 
 forceinline bool IsCompressionMethodSupported(int method) {
-  return method == kZipCompressionNone || method == kZipCompressionDeflate;
-}
-
-static inline unsigned Hash(const void *p, unsigned long n) {
-  unsigned h, i;
-  for (h = i = 0; i < n; i++) {
-    h += ((unsigned char *)p)[i];
-    h *= 0x9e3779b1;
-  }
-  return MAX(1, h);
+  return method == kZipCompressionNone || method == kZipCompressionDeflate ||
+         method == kZipCompressionZstd;
 }
 
 static void FreeAssets(void) {
@@ -2170,7 +2306,9 @@ static void FreeAssets(void) {
     Free(&assets.p[i].lastmodifiedstr);
   }
   Free(&assets.p);
+  FreeAssetIndex(&assets.index);
   assets.n = 0;
+  assets.live = 0;
 }
 
 static void FreeStrings(struct Strings *l) {
@@ -2182,56 +2320,128 @@ static void FreeStrings(struct Strings *l) {
   l->n = 0;
 }
 
-static unsigned long roundup2pow(unsigned long x) {
-  return x > 1 ? 2ul << bsrl(x - 1) : x ? 1 : 0;
+static bool IsIndexable(uint64_t cf) {
+  if (IsCompressionMethodSupported(ZIP_CFILE_COMPRESSIONMETHOD(zmap + cf))) {
+    return true;
+  } else {
+    WARNF("(zip) don't understand zip compression method %d used by %`'.*s",
+          ZIP_CFILE_COMPRESSIONMETHOD(zmap + cf), ZIP_CFILE_NAMESIZE(zmap + cf),
+          ZIP_CFILE_NAME(zmap + cf));
+    return false;
+  }
+}
+
+static void SetAsset(struct Asset *a, uint64_t cf) {
+  struct timespec lm;
+  GetZipCfileTimestamps(zmap + cf, &lm, 0, 0, gmtoff);
+  Free(&a->lastmodifiedstr);
+  a->cf = cf;
+  a->lf = GetZipCfileOffset(zmap + cf);
+  a->istext = !!(ZIP_CFILE_INTERNALATTRIBUTES(zmap + cf) & kZipIattrText);
+  a->isverified = false;
+  a->lastmodified = lm.tv_sec;
+}
+
+static void RememberCdir(void) {
+  zcdiroffset = GetZipCdirOffset(zcdir);
+  zcdirsize = GetZipCdirSize(zcdir);
+  zcdircrc = crc32_z(0, zmap + zcdiroffset, zcdirsize);
 }
 
 static void IndexAssets(void) {
   uint64_t cf;
-  struct Asset *p;
-  struct timespec lm;
-  uint32_t i, n, m, step, hash;
+  uint32_t i, n;
   DEBUGF("(zip) indexing assets (inode %#lx)", zst.st_ino);
   FreeAssets();
   CHECK_GE(HASH_LOAD_FACTOR, 2);
   CHECK(READ32LE(zcdir) == kZipCdir64HdrMagic ||
         READ32LE(zcdir) == kZipCdirHdrMagic);
   n = GetZipCdirRecords(zcdir);
-  m = roundup2pow(MAX(1, n) * HASH_LOAD_FACTOR);
-  p = xcalloc(m, sizeof(struct Asset));
+  InitAssetIndex(&assets.index, MAX(1, n) * HASH_LOAD_FACTOR);
+  assets.index.base = (const char *)zmap;
+  assets.n = assets.index.n;
+  assets.p = xcalloc(assets.n, sizeof(struct Asset));
   for (cf = GetZipCdirOffset(zcdir); n--; cf += ZIP_CFILE_HDRSIZE(zmap + cf)) {
     CHECK_EQ(kZipCfileHdrMagic, ZIP_CFILE_MAGIC(zmap + cf));
-    if (!IsCompressionMethodSupported(ZIP_CFILE_COMPRESSIONMETHOD(zmap + cf))) {
-      WARNF("(zip) don't understand zip compression method %d used by %`'.*s",
-            ZIP_CFILE_COMPRESSIONMETHOD(zmap + cf),
-            ZIP_CFILE_NAMESIZE(zmap + cf), ZIP_CFILE_NAME(zmap + cf));
+    if (!IsIndexable(cf))
+      continue;
+    i = AddAssetIndex(&assets.index, ZIP_CFILE_NAME(zmap + cf),
+                      ZIP_CFILE_NAMESIZE(zmap + cf));
+    SetAsset(assets.p + i, cf);
+    ++assets.live;
+  }
+  RememberCdir();
+}
+
+// updates index after the zip was appended to, e.g. by StoreAsset(),
+// which leaves the old central directory where it was in the file, so
+// records that didn't change still point to valid names and are only
+// compared rather than hashed and formatted all over again
+static bool IndexAssetsIncrementally(void) {
+  long i;
+  uint32_t n, seen, added;
+  uint64_t cf, of, oe, size;
+  CHECK(READ32LE(zcdir) == kZipCdir64HdrMagic ||
+        READ32LE(zcdir) == kZipCdirHdrMagic);
+  n = GetZipCdirRecords(zcdir);
+  if (n > assets.n / 2 ||                       //
+      zcdiroffset + zcdirsize > zst.st_size ||  //
+      crc32_z(0, zmap + zcdiroffset, zcdirsize) != zcdircrc) {
+    return false;
+  }
+  DEBUGF("(zip) reindexing assets incrementally (inode %#lx)", zst.st_ino);
+  assets.index.base = (const char *)zmap;  // old mapping is gone
+  seen = added = 0;
+  cf = GetZipCdirOffset(zcdir);
+  of = zcdiroffset;
+  oe = zcdiroffset + zcdirsize;
+  for (; n && of < oe; --n) {
+    CHECK_EQ(kZipCfileHdrMagic, ZIP_CFILE_MAGIC(zmap + cf));
+    size = ZIP_CFILE_HDRSIZE(zmap + cf);
+    if (size != ZIP_CFILE_HDRSIZE(zmap + of) ||
+        memcmp(zmap + cf, zmap + of, size)) {
+      break;
+    }
+    seen +=
+        IsCompressionMethodSupported(ZIP_CFILE_COMPRESSIONMETHOD(zmap + cf));
+    of += size;
+    cf += size;
+  }
+  for (; n--; cf += ZIP_CFILE_HDRSIZE(zmap + cf)) {
+    CHECK_EQ(kZipCfileHdrMagic, ZIP_CFILE_MAGIC(zmap + cf));
+    if (!IsIndexable(cf))
       continue;
+    i = FindAssetIndex(&assets.index, ZIP_CFILE_NAME(zmap + cf),
+                       ZIP_CFILE_NAMESIZE(zmap + cf));
+    if (i != -1) {
+      ++seen;
+      if (assets.p[i].lf == GetZipCfileOffset(zmap + cf))
+        continue;  // record only moved
+    } else {
+      ++added;
+      i = AddAssetIndex(&assets.index, ZIP_CFILE_NAME(zmap + cf),
+                        ZIP_CFILE_NAMESIZE(zmap + cf));
     }
-    hash = Hash(ZIP_CFILE_NAME(zmap + cf), ZIP_CFILE_NAMESIZE(zmap + cf));
-    step = 0;
-    do {
-      i = (hash + ((step * (step + 1)) >> 1)) & (m - 1);
-      ++step;
-    } while (p[i].hash);
-    GetZipCfileTimestamps(zmap + cf, &lm, 0, 0, gmtoff);
-    p[i].hash = hash;
-    p[i].cf = cf;
-    p[i].lf = GetZipCfileOffset(zmap + cf);
-    p[i].istext = !!(ZIP_CFILE_INTERNALATTRIBUTES(zmap + cf) & kZipIattrText);
-    p[i].lastmodified = lm.tv_sec;
-    p[i].lastmodifiedstr = FormatUnixHttpDateTime(xmalloc(30), lm.tv_sec);
+    SetAsset(assets.p + i, cf);
+  }
+  if (seen != assets.live) {
+    return false;  // something got deleted
   }
-  assets.p = p;
-  assets.n = m;
+  assets.live += added;
+  RememberCdir();
+  LockInc(&shared->c.incrementalreindexes);
+  return true;
 }
 
 static bool OpenZip(bool force) {
   int fd;
   size_t n;
+  bool appended;
   uint8_t *m, *d;
   struct stat st;
   if (stat(zpath, &st) != -1) {
     if (force || st.st_ino != zst.st_ino || st.st_size > zst.st_size) {
+      appended = !force && assets.n && st.st_ino == zst.st_ino;
       if (st.st_ino == zst.st_ino) {
         fd = zfd;
       } else if ((fd = open(zpath, O_RDWR)) == -1) {
@@ -2245,20 +2455,30 @@ static bool OpenZip(bool force) {
           if (zmap) {
             LOGIFNEG1(munmap(zmap, zsize));
           }
+          // keep a descriptor to the mapped file around for sendfile()
+          if (zmapfd != -1) {
+            close(zmapfd);
+          }
+          zmapfd = fd == zfd ? dup(fd) : fd;
           zmap = m;
           zsize = n;
           zcdir = d;
           DCHECK(IsZipEocd32(zmap, zsize, zcdir - zmap) == kZipOk ||
                  IsZipEocd64(zmap, zsize, zcdir - zmap) == kZipOk);
           memcpy(&zst, &st, sizeof(st));
-          IndexAssets();
+          if (!appended || !IndexAssetsIncrementally())
+            IndexAssets();
           return true;
         } else {
           WARNF("(zip) couldn't locate central directory");
+          LOGIFNEG1(munmap(m, st.st_size));
         }
       } else {
         WARNF("(zip) mmap() error: %m");
       }
+      if (fd != zfd) {
+        close(fd);
+      }
     }
   } else {
     // avoid noise if we setuid to user who can't see executable
@@ -2272,20 +2492,12 @@ static bool OpenZip(bool force) {
 }
 
 static struct Asset *GetAssetZip(const char *path, size_t pathlen) {
-  uint32_t i, step, hash;
+  long i;
   if (pathlen > 1 && path[0] == '/')
     ++path, --pathlen;
-  hash = Hash(path, pathlen);
-  for (step = 0;; ++step) {
-    i = (hash + ((step * (step + 1)) >> 1)) & (assets.n - 1);
-    if (!assets.p[i].hash)
-      return NULL;
-    if (hash == assets.p[i].hash &&
-        pathlen == ZIP_CFILE_NAMESIZE(zmap + assets.p[i].cf) &&
-        memcmp(path, ZIP_CFILE_NAME(zmap + assets.p[i].cf), pathlen) == 0) {
-      return &assets.p[i];
-    }
-  }
+  if ((i = FindAssetIndex(&assets.index, path, pathlen)) == -1)
+    return NULL;
+  return &assets.p[i];
 }
 
 static struct Asset *GetAssetFile(const char *path, size_t pathlen) {
@@ -2354,7 +2566,8 @@ static char *AppendExpires(char *p, int64_t t) {
   return AppendCrlf(p);
 }
 
-static char *AppendCache(char *p, int64_t seconds, char *directive) {
+static char *AppendCacheAt(char *p, int64_t now, int64_t seconds,
+                           char *directive) {
   if (seconds < 0)
     return p;
   p = stpcpy(p, "Cache-Control: max-age=");
@@ -2366,7 +2579,11 @@ static char *AppendCache(char *p, int64_t seconds, char *directive) {
     p = stpcpy(p, directive);
   }
   p = AppendCrlf(p);
-  return AppendExpires(p, shared->nowish.tv_sec + seconds);
+  return AppendExpires(p, now + seconds);
+}
+
+static char *AppendCache(char *p, int64_t seconds, char *directive) {
+  return AppendCacheAt(p, shared->nowish.tv_sec, seconds, directive);
 }
 
 static inline char *AppendContentLength(char *p, size_t n) {
@@ -2394,6 +2611,36 @@ static bool Inflate(void *dp, size_t dn, const void *sp, size_t sn) {
   return !__inflate(dp, dn, sp, sn);
 }
 
+static bool Unzstd(void *dp, size_t dn, const void *sp, size_t sn) {
+  size_t rc;
+  LockInc(&shared->c.zstddecompresses);
+  rc = ZSTD_decompress(dp, dn, sp, sn);
+  return !ZSTD_isError(rc) && rc == dn;
+}
+
+// assets packed by zipobj may have full flush points that let several
+// threads inflate independent segments at once
+static bool InflateAsset(struct Asset *a, void *dp, size_t dn, const void *sp,
+                         size_t sn) {
+  size_t count;
+  uint32_t span;
+  const uint8_t *points;
+  if (a->file || !(points = GetZipCfileFlushPoints(zmap + a->cf, &span,
+                                                   &count)))
+    return Inflate(dp, dn, sp, sn);
+  LockInc(&shared->c.inflates);
+  return !__inflate_segments(dp, dn, sp, sn, span, points, count);
+}
+
+static bool Decompress(struct Asset *a, void *dp, size_t dn, const void *sp,
+                       size_t sn) {
+  if (GetMethod(a) == kZipCompressionZstd) {
+    return Unzstd(dp, dn, sp, sn);
+  } else {
+    return InflateAsset(a, dp, dn, sp, sn);
+  }
+}
+
 static bool Verify(void *data, size_t size, uint32_t crc) {
   uint32_t got;
   LockInc(&shared->c.verifies);
@@ -2423,6 +2670,18 @@ static void *Deflate(const void *data, size_t size, size_t *out_size) {
   return xrealloc(res, zs.total_out);
 }
 
+static void *Zstd(const void *data, size_t size, size_t *out_size) {
+  void *res;
+  size_t n, rc;
+  LockInc(&shared->c.zstdcompresses);
+  n = ZSTD_compressBound(size);
+  res = xmalloc(n);
+  rc = ZSTD_compress(res, n, data, size, zstdlevel);
+  CHECK(!ZSTD_isError(rc));
+  *out_size = rc;
+  return xrealloc(res, rc);
+}
+
 static void *LoadAsset(struct Asset *a, size_t *out_size) {
   size_t size;
   uint8_t *data;
@@ -2435,8 +2694,8 @@ static void *LoadAsset(struct Asset *a, size_t *out_size) {
     if (size == SIZE_MAX || !(data = malloc(size + 1)))
       return NULL;
     if (IsCompressed(a)) {
-      if (!Inflate(data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
-                   GetZipCfileCompressedSize(zmap + a->cf))) {
+      if (!Decompress(a, data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
+                      GetZipCfileCompressedSize(zmap + a->cf))) {
         free(data);
         return NULL;
       }
@@ -2488,27 +2747,80 @@ static void AppendLogo(void) {
   }
 }
 
+static void HandleSendError(void) {
+  if (errno == ECONNRESET) {
+    LockInc(&shared->c.writeresets);
+    DEBUGF("(rsp) %s write reset", DescribeClient());
+  } else if (errno == EAGAIN) {
+    LockInc(&shared->c.writetimeouts);
+    WARNF("(rsp) %s write timeout", DescribeClient());
+    errno = 0;
+  } else {
+    LockInc(&shared->c.writeerrors);
+    if (errno == EBADF) {  // don't warn on close/bad fd
+      DEBUGF("(rsp) %s write badf", DescribeClient());
+    } else {
+      WARNF("(rsp) %s write error: %m", DescribeClient());
+    }
+  }
+  connectionclose = true;
+}
+
 static ssize_t Send(struct iovec *iov, int iovlen) {
   ssize_t rc;
   if ((rc = writer(client, iov, iovlen)) == -1) {
-    if (errno == ECONNRESET) {
-      LockInc(&shared->c.writeresets);
-      DEBUGF("(rsp) %s write reset", DescribeClient());
-    } else if (errno == EAGAIN) {
-      LockInc(&shared->c.writetimeouts);
-      WARNF("(rsp) %s write timeout", DescribeClient());
+    HandleSendError();
+  }
+  return rc;
+}
+
+static bool IsSendfileCandidate(struct iovec *body) {
+  return !usingssl && zmapfd != -1 && body->iov_len >= SENDFILE_MIN &&
+         (uint8_t *)body->iov_base >= zmap &&
+         (uint8_t *)body->iov_base + body->iov_len <= zmap + zsize;
+}
+
+// sends iov[body] straight from the executable's file descriptor, so
+// large zip assets are copied by the kernel rather than through writev
+static ssize_t SendWithFile(struct iovec *iov, int iovlen, int body) {
+  ssize_t rc;
+  int64_t off;
+  size_t i, n;
+  if (body && Send(iov, body) == -1)
+    return -1;
+  off = (uint8_t *)iov[body].iov_base - zmap;
+  n = iov[body].iov_len;
+  for (i = 0; i < n;) {
+    if ((rc = sendfile(client, zmapfd, &off, n - i)) > 0) {
+      i += rc;
+    } else if (rc == -1 && errno == EINTR) {
       errno = 0;
-    } else {
-      LockInc(&shared->c.writeerrors);
-      if (errno == EBADF) {  // don't warn on close/bad fd
-        DEBUGF("(rsp) %s write badf", DescribeClient());
-      } else {
-        WARNF("(rsp) %s write error: %m", DescribeClient());
+      LockInc(&shared->c.writeinterruputs);
+      if (killed || IsTakingTooLong()) {
+        connectionclose = true;
+        return -1;
       }
+    } else if (rc == -1 && !i &&
+               (errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+      // e.g. system doesn't support sendfile() for this kind of fd
+      errno = 0;
+      break;
+    } else {
+      if (!rc)
+        errno = EIO;  // executable shrank underneath us
+      HandleSendError();
+      return -1;
     }
-    connectionclose = true;
   }
-  return rc;
+  if (i) {
+    LockInc(&shared->c.sendfiles);
+  }
+  iov[body].iov_base = (char *)iov[body].iov_base + i;
+  iov[body].iov_len -= i;
+  if (body + 1 < iovlen || iov[body].iov_len) {
+    return Send(iov + body, iovlen - body);
+  }
+  return 0;
 }
 
 static bool IsSslCompressed(void) {
@@ -2525,6 +2837,15 @@ static char *CommitOutput(char *p) {
         p = stpcpy(p, "Vary: Accept-Encoding\r\n");
       }
       if (!IsTiny() &&            //
+          !IsSslCompressed() &&   //
+          zstdlevel &&            //
+          ClientAcceptsZstd() &&  //
+          !ShouldAvoidGzip()) {
+        cpm.encoding = "zstd";
+        cpm.content =
+            FreeLater(Zstd(cpm.outbuf, outbuflen, &cpm.contentlength));
+        DropOutput();
+      } else if (!IsTiny() &&     //
           !IsSslCompressed() &&   //
           ClientAcceptsGzip() &&  //
           !ShouldAvoidGzip()) {
@@ -2596,7 +2917,7 @@ static char *ServeErrorImplDefault(unsigned code, const char *reason,
     if (IsCompressed(a)) {
       n = GetZipLfileUncompressedSize(zmap + a->lf);
       if ((s = FreeLater(malloc(n))) &&
-          Inflate(s, n, cpm.content, cpm.contentlength)) {
+          Decompress(a, s, n, cpm.content, cpm.contentlength)) {
         cpm.content = s;
         cpm.contentlength = n;
       } else {
@@ -2835,6 +3156,170 @@ static ssize_t InflateGenerator(struct iovec v[3]) {
   return v[0].iov_len + v[1].iov_len + v[2].iov_len;
 }
 
+static void InitInflateCache(void) {
+  size_t n;
+  if (IsTiny() || inflatecachesize <= 0)
+    return;
+  n = ROUNDUP(sizeof(struct InflateCache) + inflatecachesize, FRAMESIZE);
+  if ((inflatecache = mmap(0, n, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+    WARNF("(srvr) failed to map %,ld byte inflate cache: %m", n);
+    inflatecache = 0;
+    errno = 0;
+    return;
+  }
+  inflatecache->size = n - sizeof(struct InflateCache);
+  inflatecache->filling = -1;
+}
+
+// the inflate cache is locked by recording our pid and tid, rather than
+// with a pthread_mutex_t, because a worker may be killed while holding
+// it, e.g. by SIGKILL from the timeout watchdog, and a dead mutex owner
+// would wedge every other worker forever. the master reaps all workers,
+// so it is able to release the lock on behalf of the dead, which wouldn't
+// be possible from within the sandboxed workers themselves. the tid keeps
+// -n threads from sharing the lock, and the pid is what the master sees
+// when a worker dies, since tids aren't pids on every system.
+static uint64_t GetInflateCacheOwner(void) {
+  return (uint64_t)getpid() << 32 | (uint32_t)gettid();
+}
+
+static void LockInflateCache(void) {
+  uint64_t owner, self = GetInflateCacheOwner();
+  for (;;) {
+    owner = 0;
+    if (atomic_compare_exchange_weak_explicit(&inflatecache->owner, &owner,
+                                              self, memory_order_acquire,
+                                              memory_order_relaxed)) {
+      return;
+    }
+    sched_yield();
+  }
+}
+
+static void UnlockInflateCache(void) {
+  atomic_store_explicit(&inflatecache->owner, 0, memory_order_release);
+}
+
+// called by master when a worker dies, in case it died holding the lock
+static void RecoverInflateCache(int pid) {
+  if (!inflatecache)
+    return;
+  if (atomic_load_explicit(&inflatecache->owner, memory_order_acquire) >> 32 !=
+      (uint32_t)pid)
+    return;
+  WARNF("(srvr) worker %d died holding inflate cache lock", pid);
+  if (inflatecache->filling != -1) {
+    // the data for this slot might only be partially copied
+    inflatecache->e[inflatecache->filling].lastuse = 0;
+    inflatecache->filling = -1;
+  }
+  UnlockInflateCache();
+}
+
+static int CompareInflateEntries(const void *a, const void *b) {
+  const struct InflateEntry *x = *(const struct InflateEntry **)a;
+  const struct InflateEntry *y = *(const struct InflateEntry **)b;
+  return (x->off > y->off) - (x->off < y->off);
+}
+
+// returns offset of first hole in cache that's big enough, or -1
+static size_t FindInflateHole(size_t size) {
+  size_t i, n, off;
+  struct InflateEntry *v[INFLATE_SLOTS];
+  for (n = i = 0; i < INFLATE_SLOTS; ++i) {
+    if (inflatecache->e[i].lastuse) {
+      v[n++] = inflatecache->e + i;
+    }
+  }
+  qsort(v, n, sizeof(*v), CompareInflateEntries);
+  for (off = i = 0; i < n; off = v[i]->off + v[i]->size, ++i) {
+    if (v[i]->off - off >= size) {
+      return off;
+    }
+  }
+  return inflatecache->size - off >= size ? off : -1;
+}
+
+// evicts the least recently used cache entry
+static bool EvictInflateEntry(void) {
+  size_t i;
+  struct InflateEntry *e;
+  for (e = 0, i = 0; i < INFLATE_SLOTS; ++i) {
+    if (inflatecache->e[i].lastuse &&
+        (!e || inflatecache->e[i].lastuse < e->lastuse)) {
+      e = inflatecache->e + i;
+    }
+  }
+  if (!e)
+    return false;
+  e->lastuse = 0;
+  LockInc(&shared->c.inflatecacheevictions);
+  return true;
+}
+
+static struct InflateEntry *GetInflateEntry(struct Asset *a) {
+  size_t i;
+  uint32_t crc;
+  struct InflateEntry *e;
+  crc = ZIP_CFILE_CRC32(zmap + a->cf);
+  for (i = 0; i < INFLATE_SLOTS; ++i) {
+    e = inflatecache->e + i;
+    if (e->lastuse && e->cf == a->cf && e->ino == zst.st_ino && e->crc == crc) {
+      return e;
+    }
+  }
+  return 0;
+}
+
+// copies inflated asset out of the cache shared by all workers
+static char *LoadInflated(struct Asset *a, size_t size) {
+  char *p = 0;
+  struct InflateEntry *e;
+  LockInflateCache();
+  if ((e = GetInflateEntry(a)) && e->size == size &&
+      (p = FreeLater(malloc(size)))) {
+    memcpy(p, inflatecache->data + e->off, size);
+    e->lastuse = ++inflatecache->tick;
+  }
+  UnlockInflateCache();
+  return p;
+}
+
+static void StoreInflated(struct Asset *a, const char *p, size_t size) {
+  size_t i, off;
+  struct InflateEntry *e;
+  LockInflateCache();
+  if (!GetInflateEntry(a)) {
+    for (;;) {
+      for (e = 0, i = 0; i < INFLATE_SLOTS; ++i) {
+        if (!inflatecache->e[i].lastuse) {
+          e = inflatecache->e + i;
+          break;
+        }
+      }
+      if (e && (off = FindInflateHole(size)) != -1)
+        break;
+      if (!EvictInflateEntry()) {
+        e = 0;
+        break;
+      }
+    }
+    if (e) {
+      inflatecache->filling = e - inflatecache->e;
+      memcpy(inflatecache->data + off, p, size);
+      e->ino = zst.st_ino;
+      e->cf = a->cf;
+      e->crc = ZIP_CFILE_CRC32(zmap + a->cf);
+      e->size = size;
+      e->off = off;
+      e->lastuse = ++inflatecache->tick;
+      inflatecache->filling = -1;
+    }
+  }
+  UnlockInflateCache();
+}
+
 static char *ServeAssetDecompressed(struct Asset *a) {
   char *p;
   size_t size;
@@ -2846,7 +3331,23 @@ static char *ServeAssetDecompressed(struct Asset *a) {
     cpm.content = 0;
     cpm.contentlength = size;
     return SetStatus(200, "OK");
-  } else if (!IsTiny()) {
+  } else if (inflatecache && size <= inflatecache->size / 4) {
+    if ((p = LoadInflated(a, size))) {
+      LockInc(&shared->c.inflatecachehits);
+    } else {
+      LockInc(&shared->c.inflatecachemisses);
+      if ((p = FreeLater(malloc(size))) &&
+          Decompress(a, p, size, cpm.content, cpm.contentlength) &&
+          Verify(p, size, ZIP_CFILE_CRC32(zmap + a->cf))) {
+        StoreInflated(a, p, size);
+      } else {
+        return ServeError(500, "Internal Server Error");
+      }
+    }
+    cpm.content = p;
+    cpm.contentlength = size;
+    return SetStatus(200, "OK");
+  } else if (!IsTiny() && GetMethod(a) == kZipCompressionDeflate) {
     dg.t = 0;
     dg.i = 0;
     dg.c = 0;
@@ -2857,7 +3358,7 @@ static char *ServeAssetDecompressed(struct Asset *a) {
     dg.b = FreeLater(malloc(dg.z));
     return SetStatus(200, "OK");
   } else if ((p = FreeLater(malloc(size))) &&
-             Inflate(p, size, cpm.content, cpm.contentlength) &&
+             Decompress(a, p, size, cpm.content, cpm.contentlength) &&
              Verify(p, size, ZIP_CFILE_CRC32(zmap + a->cf))) {
     cpm.content = p;
     cpm.contentlength = size;
@@ -3399,7 +3900,7 @@ static const char *LuaCheckHost(lua_State *L, int idx, size_t *hostlen) {
 }
 
 static void OnlyCallFromInitLua(lua_State *L, const char *api) {
-  if (isinitialized) {
+  if (isinitialized && !isinitializingthread) {
     luaL_error(L, "%s() should be called %s", api,
                "from the global scope of .init.lua");
     __builtin_unreachable();
@@ -3917,6 +4418,10 @@ static int LuaStoreAsset(lua_State *L) {
   }
   data = luaL_checklstring(L, 2, &datalen);
   mode = luaL_optinteger(L, 3, 0);
+  if (workerthreads && isinitialized) {
+    return luaL_error(L, "StoreAsset() can't be called while -n threads "
+                         "are serving, since they read the zip unlocked");
+  }
   StoreAsset(path, pathlen, data, datalen, mode);
   return 0;
 }
@@ -4233,11 +4738,23 @@ static int LuaGetBody(lua_State *L) {
 
 static int LuaGetResponseBody(lua_State *L) {
   char *s = "";
+  unsigned long long n;
   // response can be gzipped (>0), text (=0), or generator (<0)
   int size = cpm.gzipped > 0    ? cpm.gzipped  // original size
              : cpm.gzipped == 0 ? cpm.contentlength
                                 : 0;
   OnlyCallDuringRequest(L, "GetResponseBody");
+  if (cpm.encoding) {
+    if (strcmp(cpm.encoding, "zstd") ||
+        (n = ZSTD_getFrameContentSize(cpm.content, cpm.contentlength)) >=
+            ZSTD_CONTENTSIZE_ERROR ||
+        !(s = FreeLater(malloc(n))) ||
+        !Unzstd(s, n, cpm.content, cpm.contentlength)) {
+      return LuaNilError(L, "failed to decompress response");
+    }
+    lua_pushlstring(L, s, n);
+    return 1;
+  }
   if (cpm.gzipped > 0 &&
       (!(s = FreeLater(malloc(cpm.gzipped))) ||
        !Inflate(s, cpm.gzipped, cpm.content, cpm.contentlength))) {
@@ -4570,6 +5087,17 @@ static int LuaProgramSslTicketLifetime(lua_State *L) {
   return LuaProgramInt(L, ProgramSslTicketLifetime);
 }
 
+static int LuaProgramHttp2(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramHttp2");
+  if (!lua_isboolean(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid http/2 mode; boolean expected");
+  }
+  lua_pushboolean(L, http2);
+  if (lua_isboolean(L, 1))
+    http2 = lua_toboolean(L, 1);
+  return 1;
+}
+
 static int LuaProgramUniprocess(lua_State *L) {
   OnlyCallFromInitLua(L, "ProgramUniprocess");
   if (!lua_isboolean(L, 1) && !lua_isnoneornil(L, 1)) {
@@ -4581,6 +5109,50 @@ static int LuaProgramUniprocess(lua_State *L) {
   return 1;
 }
 
+static int LuaProgramPreforkWorkers(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramPreforkWorkers");
+  if (!lua_isinteger(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid number of workers; integer expected");
+  }
+  lua_pushinteger(L, preforkworkers);
+  if (lua_isinteger(L, 1))
+    ProgramPreforkWorkers(lua_tointeger(L, 1));
+  return 1;
+}
+
+static int LuaProgramWorkerThreads(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramWorkerThreads");
+  if (!lua_isinteger(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid number of threads; integer expected");
+  }
+  lua_pushinteger(L, workerthreads);
+  if (lua_isinteger(L, 1))
+    ProgramWorkerThreads(lua_tointeger(L, 1));
+  return 1;
+}
+
+static int LuaProgramZstdLevel(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramZstdLevel");
+  if (!lua_isinteger(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid level; integer expected");
+  }
+  lua_pushinteger(L, zstdlevel);
+  if (lua_isinteger(L, 1))
+    zstdlevel = MIN(ZSTD_maxCLevel(), MAX(0, lua_tointeger(L, 1)));
+  return 1;
+}
+
+static int LuaProgramInflateCacheSize(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramInflateCacheSize");
+  if (!lua_isinteger(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid cache size; integer expected");
+  }
+  lua_pushinteger(L, inflatecachesize);
+  if (lua_isinteger(L, 1))
+    inflatecachesize = MAX(0, lua_tointeger(L, 1));
+  return 1;
+}
+
 static int LuaProgramHeartbeatInterval(lua_State *L) {
   int64_t millis;
   OnlyCallFromMainProcess(L, "ProgramHeartbeatInterval");
@@ -5182,10 +5754,13 @@ static const char *const kDontAutoComplete[] = {
     "ProgramBrand",              //
     "ProgramCertificate",        // TODO
     "ProgramGid",                //
+    "ProgramHttp2",              //
+    "ProgramInflateCacheSize",   //
     "ProgramLogPath",            // TODO
     "ProgramMaxPayloadSize",     // TODO
     "ProgramPidPath",            // TODO
     "ProgramPort",               // TODO
+    "ProgramPreforkWorkers",     //
     "ProgramPrivateKey",         // TODO
     "ProgramSslCiphersuite",     // TODO
     "ProgramSslClientVerify",    // TODO
@@ -5193,6 +5768,8 @@ static const char *const kDontAutoComplete[] = {
     "ProgramTimeout",            // TODO
     "ProgramUid",                //
     "ProgramUniprocess",         //
+    "ProgramWorkerThreads",      //
+    "ProgramZstdLevel",          //
     "Respond",                   //
     "Route",                     //
     "RouteHost",                 //
@@ -5328,6 +5905,8 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ProgramGid", LuaProgramGid},                              //
     {"ProgramHeader", LuaProgramHeader},                        //
     {"ProgramHeartbeatInterval", LuaProgramHeartbeatInterval},  //
+    {"ProgramHttp2", LuaProgramHttp2},                          //
+    {"ProgramInflateCacheSize", LuaProgramInflateCacheSize},    //
     {"ProgramLogBodies", LuaProgramLogBodies},                  //
     {"ProgramLogMessages", LuaProgramLogMessages},              //
     {"ProgramLogPath", LuaProgramLogPath},                      //
@@ -5335,11 +5914,14 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ProgramMaxWorkers", LuaProgramMaxWorkers},                //
     {"ProgramPidPath", LuaProgramPidPath},                      //
     {"ProgramPort", LuaProgramPort},                            //
+    {"ProgramPreforkWorkers", LuaProgramPreforkWorkers},        //
     {"ProgramRedirect", LuaProgramRedirect},                    //
     {"ProgramTimeout", LuaProgramTimeout},                      //
     {"ProgramTrustedIp", LuaProgramTrustedIp},                  // undocumented
     {"ProgramUid", LuaProgramUid},                              //
     {"ProgramUniprocess", LuaProgramUniprocess},                //
+    {"ProgramWorkerThreads", LuaProgramWorkerThreads},          //
+    {"ProgramZstdLevel", LuaProgramZstdLevel},                  //
     {"Rand64", LuaRand64},                                      //
     {"Rdrand", LuaRdrand},                                      //
     {"Rdseed", LuaRdseed},                                      //
@@ -5852,6 +6434,11 @@ static void HandleFrag(size_t got) {
 }
 
 static void HandleReload(void) {
+  if (workerthreads) {
+    WARNF("(srvr) can't reload the zip while -n threads are serving");
+    invalidated = false;
+    return;
+  }
   LockInc(&shared->c.reloads);
   LuaOnServerReload(Reindex());
   invalidated = false;
@@ -5860,8 +6447,13 @@ static void HandleReload(void) {
 static void HandleHeartbeat(void) {
   size_t i;
   UpdateCurrentDate(timespec_real());
-  Reindex();
+  if (!workerthreads) {
+    Reindex();
+  }
   getrusage(RUSAGE_SELF, &shared->server);
+  if (preforkworkers) {
+    needworkers = true;
+  }
 #ifndef STATIC
   CallSimpleHookIfDefined("OnServerHeartbeat");
   CollectGarbage();
@@ -6072,7 +6664,9 @@ static bool HasAtMostThisElement(int h, const char *s) {
 
 static char *HandleRequest(void) {
   char *p;
-  if (cpm.msg.version == 11) {
+  if (h2.cur) {
+    LockInc(&shared->c.http2);
+  } else if (cpm.msg.version == 11) {
     LockInc(&shared->c.http11);
   } else if (cpm.msg.version < 10) {
     LockInc(&shared->c.http09);
@@ -6251,6 +6845,13 @@ static const char *GetContentType(struct Asset *a, const char *path, size_t n) {
                    a->istext ? "text/plain" : "application/octet-stream"));
 }
 
+static const char *GetLastModified(struct Asset *a) {
+  if (!a->lastmodifiedstr) {
+    a->lastmodifiedstr = FormatUnixHttpDateTime(xmalloc(30), a->lastmodified);
+  }
+  return a->lastmodifiedstr;
+}
+
 static bool IsNotModified(struct Asset *a) {
   if (cpm.msg.version < 10)
     return false;
@@ -6261,9 +6862,58 @@ static bool IsNotModified(struct Asset *a) {
                            HeaderLength(kHttpIfModifiedSince));
 }
 
+static struct Asset *GetAssetSibling(struct Asset *a, const char *ext) {
+  size_t n, m;
+  struct Asset *b;
+  char name[PATH_MAX];
+  n = ZIP_CFILE_NAMESIZE(zmap + a->cf);
+  m = strlen(ext);
+  if (n + m >= sizeof(name))
+    return NULL;
+  memcpy(mempcpy(name, ZIP_CFILE_NAME(zmap + a->cf), n), ext, m);
+  if ((b = GetAssetZip(name, n + m)) && !IsCompressed(b))
+    return b;
+  return NULL;
+}
+
+// picks the smallest precompressed `.zst` or `.br` sibling of a zip
+// asset which the client accepts, e.g. /foo.js.zst for /foo.js
+static struct Asset *GetAssetEncoded(struct Asset *a, const char **enc) {
+  struct Asset *b, *r = NULL;
+  if (a->file || IsTiny() || IsSslCompressed() || HasHeader(kHttpRange))
+    return NULL;
+  if (ClientAcceptsZstd() && (b = GetAssetSibling(a, ".zst"))) {
+    r = b;
+    *enc = "zstd";
+  }
+  if (ClientAcceptsBrotli() && (b = GetAssetSibling(a, ".br")) &&
+      (!r || GetZipCfileCompressedSize(zmap + b->cf) <
+                 GetZipCfileCompressedSize(zmap + r->cf))) {
+    r = b;
+    *enc = "br";
+  }
+  return r;
+}
+
+static char *ServeAssetEncoded(struct Asset *a, const char *enc) {
+  DEBUGF("(srvr) ServeAssetEncoded(%s)", enc);
+  LockInc(&shared->c.encodedresponses);
+  cpm.encoding = enc;
+  cpm.content = (char *)ZIP_LFILE_CONTENT(zmap + a->lf);
+  cpm.contentlength = GetZipCfileCompressedSize(zmap + a->cf);
+  if (!IsCompressed(a) && !a->isverified) {
+    // zstd zip entries have the crc of the decoded content
+    if (!Verify(cpm.content, cpm.contentlength, ZIP_LFILE_CRC32(zmap + a->lf)))
+      return ServeError(500, "Internal Server Error");
+    a->isverified = true;
+  }
+  return SetStatus(200, "OK");
+}
+
 static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
   char *p;
-  const char *ct;
+  const char *ct, *enc;
+  struct Asset *b;
   ct = GetContentType(a, path, pathlen);
   if (IsNotModified(a)) {
     LockInc(&shared->c.notmodifieds);
@@ -6275,7 +6925,15 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
     } else if ((p = OpenAsset(a))) {
       return p;
     }
-    if (IsCompressed(a)) {
+    if ((b = GetAssetEncoded(a, &enc))) {
+      p = ServeAssetEncoded(b, enc);
+    } else if (GetMethod(a) == kZipCompressionZstd) {
+      if (ClientAcceptsZstd()) {
+        p = ServeAssetEncoded(a, "zstd");
+      } else {
+        p = ServeAssetDecompressed(a);
+      }
+    } else if (IsCompressed(a)) {
       if (ClientAcceptsGzip()) {
         p = ServeAssetPrecompressed(a);
       } else {
@@ -6286,8 +6944,9 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
     } else if (!a->file) {
       LockInc(&shared->c.identityresponses);
       DEBUGF("(zip) ServeAssetZipIdentity(%`'s)", ct);
-      if (Verify(cpm.content, cpm.contentlength,
-                 ZIP_LFILE_CRC32(zmap + a->lf))) {
+      if (a->isverified || Verify(cpm.content, cpm.contentlength,
+                                  ZIP_LFILE_CRC32(zmap + a->lf))) {
+        a->isverified = true;
         p = SetStatus(200, "OK");
       } else {
         return ServeError(500, "Internal Server Error");
@@ -6307,12 +6966,12 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
   }
   p = AppendContentType(p, ct);
   p = stpcpy(p, "Vary: Accept-Encoding\r\n");
-  p = AppendHeader(p, "Last-Modified", a->lastmodifiedstr);
+  p = AppendHeader(p, "Last-Modified", GetLastModified(a));
   if (cpm.msg.version >= 11) {
     if (!cpm.gotcachecontrol) {
       p = AppendCache(p, cacheseconds, cachedirective);
     }
-    if (!IsCompressed(a)) {
+    if (!IsCompressed(a) && !cpm.encoding) {
       p = stpcpy(p, "Accept-Ranges: bytes\r\n");
     }
   }
@@ -6352,7 +7011,7 @@ static inline bool MustNotIncludeMessageBody(void) { /* RFC2616 § 4.4 */
 }
 
 static bool TransmitResponse(char *p) {
-  int iovlen;
+  int iovlen, body;
   struct iovec iov[4];
   long actualcontentlength;
   if (cpm.msg.version >= 10) {
@@ -6360,6 +7019,8 @@ static bool TransmitResponse(char *p) {
     if (cpm.gzipped) {
       actualcontentlength += sizeof(kGzipHeader) + sizeof(gzip_footer);
       p = stpcpy(p, "Content-Encoding: gzip\r\n");
+    } else if (cpm.encoding) {
+      p = AppendHeader(p, "Content-Encoding", cpm.encoding);
     }
     p = AppendContentLength(p, actualcontentlength);
     p = AppendCrlf(p);
@@ -6376,6 +7037,7 @@ static bool TransmitResponse(char *p) {
         iov[iovlen].iov_len = sizeof(kGzipHeader);
         ++iovlen;
       }
+      body = iovlen;
       iov[iovlen].iov_base = cpm.content;
       iov[iovlen].iov_len = cpm.contentlength;
       ++iovlen;
@@ -6384,13 +7046,20 @@ static bool TransmitResponse(char *p) {
         iov[iovlen].iov_len = sizeof(gzip_footer);
         ++iovlen;
       }
+    } else {
+      body = -1;
     }
   } else {
+    body = 0;
     iov[0].iov_base = cpm.content;
     iov[0].iov_len = cpm.contentlength;
     iovlen = 1;
   }
-  Send(iov, iovlen);
+  if (body != -1 && IsSendfileCandidate(iov + body)) {
+    SendWithFile(iov, iovlen, body);
+  } else {
+    Send(iov, iovlen);
+  }
   LockInc(&shared->c.messageshandled);
   ++messageshandled;
   return true;
@@ -6513,7 +7182,9 @@ static bool HandleMessageActual(void) {
            cpm.msg.uri.b - cpm.msg.uri.a, inbuf.p + cpm.msg.uri.a, reqtime,
            contime);
   }
-  if (!cpm.generator) {
+  if (h2.cur) {
+    return QueueHttp2Response(p);
+  } else if (!cpm.generator) {
     return TransmitResponse(p);
   } else {
     return StreamResponse(p);
@@ -6533,6 +7204,8 @@ static void InitRequest(void) {
   bzero(&cpm, sizeof(cpm));
 }
 
+#include "tool/net/http2.inc"
+
 static bool IsSsl(unsigned char c) {
   if (c == 22)
     return true;
@@ -6543,6 +7216,41 @@ static bool IsSsl(unsigned char c) {
   return true;
 }
 
+// hands idle keep-alive connection over to epoll so worker can move on
+static bool ParkClient(void) {
+  struct Keepalive *k;
+  struct epoll_event ev;
+  if (epfd == -1 || usingssl || amtread)
+    return false;
+  if (client >= keepalives.n) {
+    keepalives.p = xrealloc(keepalives.p, (client + 1) * sizeof(*keepalives.p));
+    bzero(keepalives.p + keepalives.n,
+          (client + 1 - keepalives.n) * sizeof(*keepalives.p));
+    keepalives.n = client + 1;
+  }
+  k = keepalives.p + client;
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+  ev.data.u64 = EPOLL_CLIENT | client;
+  if (epoll_ctl(epfd, k->isregistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, client,
+                &ev) == -1) {
+    WARNF("(srvr) %s epoll_ctl error: %m", DescribeClient());
+    errno = 0;
+    return false;
+  }
+  k->isparked = true;
+  k->isregistered = true;
+  k->clientaddr = clientaddr;
+  k->serveraddr = serveraddr;
+  k->startconnection = startconnection;
+  k->messageshandled = messageshandled;
+  k->lastactive = timespec_real();
+  ++keepalives.idle;
+  clientparked = true;
+  LockInc(&shared->c.keepaliveparks);
+  DEBUGF("(stat) %s parked (%,zu idle)", DescribeClient(), keepalives.idle);
+  return true;
+}
+
 static void HandleMessages(void) {
   bool once;
   ssize_t rc;
@@ -6582,7 +7290,12 @@ static void HandleMessages(void) {
           }
 #endif
           DEBUGF("(stat) %s read %,zd bytes", DescribeClient(), got);
-          if (HandleMessage()) {
+          if (http2 && !messageshandled && IsHttp2Preface()) {
+            if (amtread >= sizeof(kHttp2Preface) - 1) {
+              HandleHttp2();
+              return;
+            }
+          } else if (HandleMessage()) {
             break;
           } else if (got) {
             HandleFrag(got);
@@ -6661,6 +7374,9 @@ static void HandleMessages(void) {
     if (invalidated) {
       HandleReload();
     }
+    if (ParkClient()) {
+      return;
+    }
   }
 }
 
@@ -6695,7 +7411,20 @@ static void UnveilRedbean(void) {
   unveil(0, 0);
 }
 
-static int EnableSandbox(void) {
+// prefork workers accept their own connections, so offline policies
+// need to keep allowing accept() on sockets that are already listening
+static int PledgeWorker(const char *promises, bool accepts) {
+  char buf[64];
+  if (accepts) {
+    // openbsd has no anet promise
+    snprintf(buf, sizeof(buf), "%s %s", promises,
+             IsOpenbsd() ? "inet" : "anet");
+    promises = buf;
+  }
+  return pledge(promises, 0);
+}
+
+static int EnableSandbox(bool accepts) {
   __pledge_mode = PLEDGE_PENALTY_RETURN_EPERM | PLEDGE_STDERR_LOGGING;
   switch (sandboxed) {
     case 0:
@@ -6707,11 +7436,11 @@ static int EnableSandbox(void) {
     case 2:  // -SS
       DEBUGF("(stat) applying '%s' sandbox policy", "offline");
       UnveilRedbean();
-      return pledge("stdio rpath id", 0);
+      return PledgeWorker("stdio rpath id", accepts);
     default:  // -SSS
       DEBUGF("(stat) applying '%s' sandbox policy", "contained");
       UnveilRedbean();
-      return pledge("stdio", 0);
+      return PledgeWorker("stdio", accepts);
   }
 }
 
@@ -6725,7 +7454,7 @@ static void *MemoryMonitor(void *arg) {
   unsigned char rez;
   struct termios term;
   char *b, *addr;
-  struct MemoryInterval *mi, *mi2;
+  struct MemoryInterval *mi, *mi2, *e;
   long i, j, gen, pages;
   int rc, id, color, color2, workers;
   id = atomic_load_explicit(&shared->workers, memory_order_relaxed);
@@ -6784,7 +7513,8 @@ static void *MemoryMonitor(void *arg) {
         mi[2].flags = 0;
         __mmi_lock();
         if (_mmi.i == intervals - 3) {
-          memcpy(mi + 3, _mmi.p, _mmi.i * sizeof(*mi));
+          for (i = 3, e = __first_memory(&_mmi); e; e = __next_memory(e))
+            mi[i++] = *e;
           ok = true;
         } else {
           ok = false;
@@ -6878,6 +7608,86 @@ static void MonitorMemory(void) {
   }
 }
 
+static void CloseClient(void) {
+  DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
+         timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
+  if (preforkworkers || workerthreads) {
+    LockInc(&shared->c.connectionshandled);
+  }
+  if (client < keepalives.n) {
+    keepalives.p[client].isregistered = false;
+  }
+  close(client);
+}
+
+// resets in-process connection state, unless client was parked
+static void FinishConnection(void) {
+  if (clientparked) {
+    clientparked = false;
+  } else {
+    CloseClient();
+  }
+  oldin.p = 0;
+  oldin.n = 0;
+  if (inbuf.c) {
+    inbuf.p -= inbuf.c;
+    inbuf.n += inbuf.c;
+    inbuf.c = 0;
+  }
+#ifndef UNSECURE
+  if (usingssl) {
+    usingssl = false;
+    reader = read;
+    writer = WritevAll;
+    mbedtls_ssl_session_reset(&ssl);
+  }
+#endif
+}
+
+static void HandleKeepalive(int fd) {
+  struct Keepalive *k;
+  if (fd >= keepalives.n || !keepalives.p[fd].isparked)
+    return;
+  k = keepalives.p + fd;
+  k->isparked = false;
+  --keepalives.idle;
+  client = fd;
+  clientaddr = k->clientaddr;
+  serveraddr = k->serveraddr;
+  startconnection = k->startconnection;
+  messageshandled = k->messageshandled;
+  connectionclose = false;  // may be left over from another client
+  LockInc(&shared->c.keepaliveresumes);
+  HandleMessages();
+  FinishConnection();
+  CollectGarbage();
+}
+
+static void ExpireKeepalives(void) {
+  size_t fd;
+  struct timespec now;
+  struct Keepalive *k;
+  if (!keepalives.idle || timeout.tv_sec < 0 ||
+      (!timeout.tv_sec && !timeout.tv_usec))
+    return;
+  now = timespec_real();
+  for (fd = 0; fd < keepalives.n; ++fd) {
+    k = keepalives.p + fd;
+    if (!k->isparked)
+      continue;
+    if (timespec_cmp(timespec_sub(now, k->lastactive),
+                     timeval_totimespec(timeout)) < 0)
+      continue;
+    k->isparked = false;
+    --keepalives.idle;
+    client = fd;
+    clientaddr = k->clientaddr;
+    startconnection = k->startconnection;
+    LockInc(&shared->c.keepalivetimeouts);
+    CloseClient();
+  }
+}
+
 static int HandleConnection(size_t i) {
   uint32_t ip;
   int pid, tok, rc = 0;
@@ -6885,6 +7695,10 @@ static int HandleConnection(size_t i) {
   if ((client = accept4(servers.p[i].fd, (struct sockaddr *)&clientaddr,
                         &clientaddrsize, SOCK_CLOEXEC)) != -1) {
     LockInc(&shared->c.accepts);
+    if ((preforkworkers || workerthreads) && !IsLinux()) {
+      // bsd sockets inherit o_nonblock from the listening socket
+      fcntl(client, F_SETFL, 0);
+    }
     GetClientAddr(&ip, 0);
     if (tokenbucket.cidr && tokenbucket.reject >= 0) {
       if (!IsTrustedIp(ip)) {
@@ -6921,7 +7735,8 @@ static int HandleConnection(size_t i) {
       DEBUGF("(token) can't acquire accept() token for client");
     }
     startconnection = timespec_real();
-    if (UNLIKELY(maxworkers) && shared->workers >= maxworkers) {
+    if (UNLIKELY(maxworkers) && !preforkworkers && !workerthreads &&
+        shared->workers >= maxworkers) {
       EnterMeltdownMode();
       SendServiceUnavailable();
       close(client);
@@ -6936,6 +7751,9 @@ static int HandleConnection(size_t i) {
     if (uniprocess) {
       pid = -1;
       connectionclose = true;
+    } else if (preforkworkers || workerthreads) {
+      pid = -1;
+      connectionclose = false;
     } else {
       switch ((pid = fork())) {
         case 0:
@@ -6944,13 +7762,14 @@ static int HandleConnection(size_t i) {
           }
           meltdown = false;
           __isworker = true;
+          DropFetchPool();
           connectionclose = false;
           if (!IsTiny() && systrace) {
             kStartTsc = rdtsc();
           }
           TRACE_BEGIN;
           if (sandboxed) {
-            CHECK_NE(-1, EnableSandbox());
+            CHECK_NE(-1, EnableSandbox(false));
           }
           if (hasonworkerstart) {
             CallSimpleHook("OnWorkerStart");
@@ -6973,30 +7792,15 @@ static int HandleConnection(size_t i) {
       CloseServerFds();
     }
     HandleMessages();
-    DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
-           timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
     if (!pid) {
+      DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
+             timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
       if (hasonworkerstop) {
         CallSimpleHook("OnWorkerStop");
       }
       rc = ExitWorker();
     } else {
-      close(client);
-      oldin.p = 0;
-      oldin.n = 0;
-      if (inbuf.c) {
-        inbuf.p -= inbuf.c;
-        inbuf.n += inbuf.c;
-        inbuf.c = 0;
-      }
-#ifndef UNSECURE
-      if (usingssl) {
-        usingssl = false;
-        reader = read;
-        writer = WritevAll;
-        mbedtls_ssl_session_reset(&ssl);
-      }
-#endif
+      FinishConnection();
     }
     CollectGarbage();
   } else {
@@ -7116,11 +7920,15 @@ static int HandleReadline(void) {
 
 static int HandlePoll(int ms) {
   int rc, nfds;
-  size_t pollid, serverid;
-  if ((nfds = poll(polls, 1 + servers.n, ms)) != -1) {
+  size_t pollid, serverid, pollcount;
+  // prefork main process leaves accepting to its workers, as does the
+  // main thread when -n is used
+  pollcount =
+      (preforkworkers && !__isworker) || workerthreads ? 1 : 1 + servers.n;
+  if ((nfds = poll(polls, pollcount, ms)) != -1) {
     if (nfds) {
       // handle pollid/o events
-      for (pollid = 0; pollid < 1 + servers.n; ++pollid) {
+      for (pollid = 0; pollid < pollcount; ++pollid) {
         if (!polls[pollid].revents)
           continue;
         if (polls[pollid].fd < 0)
@@ -7147,7 +7955,7 @@ static int HandlePoll(int ms) {
         }
       }
 #ifndef STATIC
-    } else if (__ttyconf.replmode) {
+    } else if (__ttyconf.replmode && !__isworker) {
       // handle refresh repl line
       rc = HandleReadline();
       if (rc < 0)
@@ -7169,6 +7977,146 @@ static int HandlePoll(int ms) {
   return 0;
 }
 
+static int HandleEpoll(int ms) {
+  int i, rc, nfds;
+  uint64_t x;
+  struct epoll_event ev[16];
+  if ((nfds = epoll_wait(epfd, ev, ARRAYLEN(ev), ms)) != -1) {
+    for (rc = i = 0; i < nfds && rc != -1; ++i) {
+      x = ev[i].data.u64;
+      lua_repl_lock();
+      ishandlingconnection = true;
+      if (x & EPOLL_CLIENT) {
+        HandleKeepalive(x & ~EPOLL_CLIENT);
+      } else {
+        assert(x < servers.n);
+        serveraddr = &servers.p[x].addr;
+        rc = HandleConnection(x);
+      }
+      ishandlingconnection = false;
+      lua_repl_unlock();
+    }
+    return rc;
+  } else {
+    if (errno == EINTR || errno == EAGAIN) {
+      LockInc(&shared->c.pollinterrupts);
+    } else if (errno == ENOMEM) {
+      LockInc(&shared->c.enomems);
+      WARNF("(srvr) epoll error: ran out of memory");
+      meltdown = true;
+    } else {
+      DIEF("(srvr) epoll error: %m");
+    }
+    errno = 0;
+  }
+  return 0;
+}
+
+// multiplexes idle keep-alive connections within prefork worker
+static void InitEpoll(void) {
+  size_t i;
+  struct epoll_event ev;
+  if (!IsLinux())
+    return;
+  if ((epfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    WARNF("(srvr) epoll_create1 error: %m");
+    errno = 0;
+    return;
+  }
+  for (i = 0; i < servers.n; ++i) {
+    // only wake one worker per connection on linux 4.5+
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.u64 = i;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, servers.p[i].fd, &ev) == -1) {
+      ev.events = EPOLLIN;
+      if (epoll_ctl(epfd, EPOLL_CTL_ADD, servers.p[i].fd, &ev) == -1) {
+        WARNF("(srvr) epoll_ctl error: %m");
+        close(epfd);
+        epfd = -1;
+        errno = 0;
+        return;
+      }
+    }
+  }
+  errno = 0;
+}
+
+static int HandlePreforkWorker(void) {
+  struct timespec t;
+  if (!IsTiny() && monitortty) {
+    MonitorMemory();
+  }
+  meltdown = false;
+  __isworker = true;
+  polls[0].fd = -1;
+  if (!IsTiny() && systrace) {
+    kStartTsc = rdtsc();
+  }
+  TRACE_BEGIN;
+  if (sandboxed) {
+    CHECK_NE(-1, EnableSandbox(true));
+  }
+  if (hasonworkerstart) {
+    CallSimpleHook("OnWorkerStart");
+  }
+  InitEpoll();
+  while (!terminated) {
+    errno = 0;
+    if (invalidated) {
+      HandleReload();
+    } else if (meltdown) {
+      // meltdown only applies to connections that were in flight
+      meltdown = false;
+    } else if (timespec_cmp(timespec_sub((t = timespec_real()), lastheartbeat),
+                            heartbeatinterval) >= 0) {
+      lastheartbeat = t;
+      Reindex();
+      ExpireKeepalives();
+    } else if (epfd != -1) {
+      if (HandleEpoll(timespec_tomillis(heartbeatinterval)) == -1) {
+        return -1;
+      }
+    } else if (HandlePoll(timespec_tomillis(heartbeatinterval)) == -1) {
+      return -1;
+    }
+  }
+  if (hasonworkerstop) {
+    CallSimpleHook("OnWorkerStop");
+  }
+  return ExitWorker();
+}
+
+// launches long-lived workers which each accept many connections
+static int SpawnWorkers(void) {
+  int pid;
+  needworkers = false;
+  if (respawnfailures && timespec_cmp(timespec_real(), respawnafter) < 0)
+    return 0;  // try again on a later heartbeat
+  while (!terminated && shared->workers < preforkworkers) {
+    switch ((pid = fork())) {
+      case 0:
+        DropFetchPool();
+        return HandlePreforkWorker();
+      case -1:
+        // try again on the next heartbeat
+        LockInc(&shared->c.forkerrors);
+        WARNF("(srvr) failed to spawn prefork worker: %m");
+        errno = 0;
+        return 0;
+      default:
+        LockInc(&shared->workers);
+        ReseedRng(&rng, "parent");
+        if (hasonprocesscreate) {
+          LuaOnProcessCreate(pid);
+        }
+        break;
+    }
+  }
+  return 0;
+}
+
+#include "tool/net/threads.inc"
+
 static void Listen(void) {
   char ipbuf[16];
   size_t i, j, n;
@@ -7214,6 +8162,10 @@ static void Listen(void) {
       if (listen(servers.p[n].fd, 10) == -1) {
         DIEF("(srvr) listen error: %m");
       }
+      if (preforkworkers || workerthreads) {
+        // workers race to accept() connections announced by poll()
+        fcntl(servers.p[n].fd, F_SETFL, O_NONBLOCK);
+      }
       addrsize = sizeof(servers.p[n].addr);
       if (getsockname(servers.p[n].fd, (struct sockaddr *)&servers.p[n].addr,
                       &addrsize) == -1) {
@@ -7269,6 +8221,10 @@ int EventLoop(int ms) {
       lua_repl_lock();
       ReapZombies();
       lua_repl_unlock();
+    } else if (needworkers) {
+      if (SpawnWorkers() == -1) {
+        break;
+      }
     } else if (invalidated) {
       lua_repl_lock();
       HandleReload();
@@ -7379,10 +8335,10 @@ static void TlsInit(void) {
   }
   mbedtls_ssl_set_bio(&ssl, &g_bio, TlsSend, 0, TlsRecv);
   conf.disable_compression = confcli.disable_compression = true;
-  DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(&conf, (void *)kAlpn));
+  DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(
+                   &conf, (void *)(http2 ? kAlpnHttp2 : kAlpn)));
   DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(&confcli, (void *)kAlpn));
   DCHECK_EQ(0, mbedtls_ssl_setup(&ssl, &conf));
-  DCHECK_EQ(0, mbedtls_ssl_setup(&sslcli, &confcli));
 #endif
 }
 
@@ -7391,7 +8347,6 @@ static void TlsDestroy(void) {
   if (unsecure)
     return;
   mbedtls_ssl_free(&ssl);
-  mbedtls_ssl_free(&sslcli);
   mbedtls_ctr_drbg_free(&rng);
   mbedtls_ctr_drbg_free(&rngcli);
   mbedtls_ssl_config_free(&conf);
@@ -7423,6 +8378,8 @@ static void GetOpts(int argc, char *argv[]) {
       CASE('a', logrusage = true);
       CASE('J', requiressl = true);
       CASE('u', uniprocess = true);
+      CASE('N', ProgramPreforkWorkers(ParseInt(optarg)));
+      CASE('n', ProgramWorkerThreads(ParseInt(optarg)));
       CASE('g', loglatency = true);
       CASE('m', logmessages = true);
       CASE('w', launchbrowser = strdup(optarg));
@@ -7548,7 +8505,15 @@ void RedBean(int argc, char *argv[]) {
   oldloglevel = __log_level;
   if (uniprocess) {
     shared->workers = 1;
+    preforkworkers = 0;
+  }
+  if (preforkworkers && IsWindows()) {
+    WARNF("(srvr) prefork workers aren't supported on windows");
+    preforkworkers = 0;
   }
+  needworkers = !!preforkworkers;
+  CheckWorkerThreads();
+  InitInflateCache();
   if (daemonize) {
     if (!logpath)
       ProgramLogPath("/dev/null");
@@ -7586,6 +8551,9 @@ void RedBean(int argc, char *argv[]) {
       MonitorMemory();
     }
   }
+  if (workerthreads) {
+    SpawnWorkerThreads();
+  }
 #ifdef STATIC
   EventLoop(timespec_tomillis(heartbeatinterval));
 #else
@@ -7596,6 +8564,9 @@ void RedBean(int argc, char *argv[]) {
   }
 #endif
   if (!isexitingworker) {
+    if (workerthreads) {
+      JoinWorkerThreads();
+    }
     if (!IsTiny()) {
       terminatemonitor = true;
       if (monitorth) {